@@ -0,0 +1,141 @@
+#include <archive.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace masonc
+{
+    static constexpr char ARCHIVE_MAGIC[] = "!<arch>\n";
+
+    // Every member starts with a header of this size.
+    static constexpr u64 HEADER_SIZE = 60;
+
+    // Appends "value" left-aligned in a field of "width" characters padded with spaces.
+    static void append_field(std::string* output, const std::string& value, u64 width)
+    {
+        output->append(value, 0, std::min<u64>(value.size(), width));
+
+        if (value.size() < width)
+            output->append(width - value.size(), ' ');
+    }
+
+    static void append_header(std::string* output, const std::string& name, u64 size)
+    {
+        append_field(output, name, 16);
+        append_field(output, "0", 12); // Modification time.
+        append_field(output, "0", 6);  // Owner ID.
+        append_field(output, "0", 6);  // Group ID.
+        append_field(output, "644", 8);
+        append_field(output, std::to_string(size), 10);
+        output->append("`\n");
+    }
+
+    // Members start at even offsets.
+    static void append_padding(std::string* output)
+    {
+        if (output->size() % 2 != 0)
+            output->push_back('\n');
+    }
+
+    static void append_u32_big_endian(std::string* output, u32 value)
+    {
+        output->push_back(static_cast<char>((value >> 24) & 0xff));
+        output->push_back(static_cast<char>((value >> 16) & 0xff));
+        output->push_back(static_cast<char>((value >> 8) & 0xff));
+        output->push_back(static_cast<char>(value & 0xff));
+    }
+
+    std::string archive_create(const std::vector<archive_member>& members)
+    {
+        // Names that do not fit into a header go into the name table,
+        // and the header refers to them by their offset in it.
+        std::string name_table;
+        std::vector<std::string> header_names;
+        header_names.reserve(members.size());
+
+        for (const archive_member& member : members) {
+            if (member.name.size() <= 15) {
+                header_names.push_back(member.name + "/");
+            }
+            else {
+                header_names.push_back("/" + std::to_string(name_table.size()));
+                name_table += member.name + "/\n";
+            }
+        }
+
+        u64 symbol_count = 0;
+        u64 symbol_names_size = 0;
+
+        for (const archive_member& member : members) {
+            symbol_count += member.symbols.size();
+
+            for (const std::string& symbol_name : member.symbols) {
+                symbol_names_size += symbol_name.size() + 1;
+            }
+        }
+
+        // Offsets in the index are absolute, so the size of everything in front of the members
+        // has to be known before the index is written.
+        u64 index_size = 4 + 4 * symbol_count + symbol_names_size;
+        u64 first_member_offset = (sizeof(ARCHIVE_MAGIC) - 1) + HEADER_SIZE + index_size + index_size % 2;
+
+        if (!name_table.empty())
+            first_member_offset += HEADER_SIZE + name_table.size() + name_table.size() % 2;
+
+        std::vector<u32> member_offsets;
+        member_offsets.reserve(members.size());
+
+        u64 member_offset = first_member_offset;
+
+        for (const archive_member& member : members) {
+            member_offsets.push_back(static_cast<u32>(member_offset));
+            member_offset += HEADER_SIZE + member.contents.size() + member.contents.size() % 2;
+        }
+
+        std::string output{ ARCHIVE_MAGIC };
+        output.reserve(member_offset);
+
+        append_header(&output, "/", index_size);
+        append_u32_big_endian(&output, static_cast<u32>(symbol_count));
+
+        for (u64 i = 0; i < members.size(); i += 1) {
+            for (u64 j = 0; j < members[i].symbols.size(); j += 1) {
+                append_u32_big_endian(&output, member_offsets[i]);
+            }
+        }
+
+        for (const archive_member& member : members) {
+            for (const std::string& symbol_name : member.symbols) {
+                output.append(symbol_name);
+                output.push_back('\0');
+            }
+        }
+
+        append_padding(&output);
+
+        if (!name_table.empty()) {
+            append_header(&output, "//", name_table.size());
+            output.append(name_table);
+            append_padding(&output);
+        }
+
+        for (u64 i = 0; i < members.size(); i += 1) {
+            append_header(&output, header_names[i], members[i].contents.size());
+            output.append(members[i].contents);
+            append_padding(&output);
+        }
+
+        return output;
+    }
+
+    bool file_write(const std::string& path, const std::string& contents)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        return (std::fclose(file) == 0) && written;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef MASONC_ARCHIVE_HPP
+#define MASONC_ARCHIVE_HPP
+
+#include <common.hpp>
+
+#include <string>
+#include <vector>
+
+namespace masonc
+{
+    // A file in an archive.
+    struct archive_member
+    {
+        std::string name;
+        std::string contents;
+
+        // Symbols that the member defines, which a linker looks up in the archive's index
+        // to decide which members it needs.
+        std::vector<std::string> symbols;
+    };
+
+    // Returns an archive of "members" in the GNU "ar" format, starting with an index of their symbols.
+    // Names longer than 15 characters are stored in a name table.
+    std::string archive_create(const std::vector<archive_member>& members);
+
+    // Writes "contents" to the file at "path", replacing it.
+    // Returns false if the file could not be written.
+    bool file_write(const std::string& path, const std::string& contents);
+}
+
+#endif
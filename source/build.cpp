@@ -8,11 +8,25 @@
 #include <llvm_converter.hpp>
 #include <language.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <tuple>
+
 namespace masonc
 {
     builder::builder(std::vector<path> sources, u64 overwrite_thread_count,
-                     u64 min_bytes_for_sync)
+        std::optional<std::string> cache_directory, std::optional<std::string> object_file_name,
+        u32 optimization_level, masonc::llvm::lto_mode lto)
+        : emit_objects{ object_file_name.has_value() }, optimization_level{ optimization_level }, lto{ lto }
     {
+
+        if (cache_directory) {
+            cache.emplace(cache_directory.value());
+
+            if (emit_objects && lto == masonc::llvm::lto_mode::NONE)
+                procedure_objects_cache.emplace(cache_directory.value());
+        }
+
         if (overwrite_thread_count == 0) {
             worker_thread_count = static_cast<u64>(std::thread::hardware_concurrency());
         }
@@ -25,171 +39,510 @@ namespace masonc
             worker_thread_count = 1;
         }
 
-        std::vector<std::thread> threads;
-        threads.reserve(worker_thread_count);
-        all_work.reserve(worker_thread_count);
+        work_stealing_scheduler scheduler{ worker_thread_count };
+
+        worker_lexers.resize(worker_thread_count);
+        worker_parse_output.resize(worker_thread_count);
+
+        std::thread link_thread{ &builder::link_modules, this };
+
+        // Code generation threads wait on "linked_modules" while there is nothing to convert,
+        // so they do not take time away from the workers.
+        std::vector<std::thread> code_generation_threads;
+
+        for (u64 i = 0; i < worker_thread_count; i += 1) {
+            code_generators.emplace_back(optimization_level);
+        }
 
         for (u64 i = 0; i < worker_thread_count; i += 1) {
-            all_work.emplace_back();
-            // FIXME: Protect "this" with a mutex maybe?
-            threads.emplace_back(std::thread{ &builder::do_work, this, i });
+            code_generation_threads.emplace_back(&builder::generate_code, this, i);
         }
 
         std::vector<std::string> file_paths = concrete_file_paths(sources);
+        mapped_files.reserve(file_paths.size());
 
-        // To be synced with member vectors.
-        std::vector<char*> files;
-        std::vector<u64> sizes;
+        // Hand every file to the scheduler as soon as it is loaded.
+        // Larger files are started first, so that no worker is left alone with a huge file at the end.
+        files_load(file_paths, [&](u64 path_index, std::optional<mapped_file> contents) {
+            // TODO: Mark as unlikely.
+            if (!contents) {
+                message_list load_messages;
+                load_messages.report_error("Could not load file \"" + file_paths[path_index] + "\".");
 
-        parse_output.reserve(file_paths.size());
-        file_queue.reserve(file_paths.size());
-        file_sizes.reserve(file_paths.size());
-        files.reserve(file_paths.size());
-        sizes.reserve(file_paths.size());
+                report_failed_file(load_messages);
+                return;
+            }
 
-        // Bytes read since last sync.
-        u64 bytes_read = 0;
+            const char* file = contents.value().data();
+            u64 file_size = contents.value().size();
 
-        for (u64 i = 0; i < file_paths.size(); i += 1) {
-            u64 contents_size;
-            char* contents = file_read(file_paths[i].c_str(), 64000, &contents_size);
+            {
+                std::lock_guard<std::mutex> mapped_files_lock{ mapped_files_mutex };
 
-            // TODO: Mark as unlikely.
-            if (contents == nullptr) {
-                // TODO: Error.
+                // Moving does not change where the contents are mapped.
+                mapped_files.push_back(std::move(contents.value()));
             }
-            else {
-                bytes_read += contents_size;
 
-                files.push_back(contents);
-                sizes.push_back(contents_size);
+            scheduler.submit([this, file, file_size](u64 worker_index) {
+                parse_file(worker_index, file, file_size);
+            }, file_size);
+        });
 
-                // Time to sync?
-                if (bytes_read > min_bytes_for_sync) {
-                    std::unique_lock<std::shared_mutex> file_queue_unique_lock{ file_queue_mutex };
+        scheduler.finish();
+        worker_stats_list = scheduler.stats();
 
-                    file_queue.insert(file_queue.end(), files.begin(), files.end());
-                    file_sizes.insert(file_sizes.end(), sizes.begin(), sizes.end());
+        // Every module is parsed, let the later stages drain their queues and stop.
+        parsed_modules.close();
 
-                    split_work();
+        link_thread.join();
 
-                    file_queue_unique_lock.unlock();
-                    file_queue_condition.notify_all();
+        for (std::thread& code_generation_thread : code_generation_threads) {
+            code_generation_thread.join();
+        }
 
-                    files.clear();
-                    sizes.clear();
-                    bytes_read = 0;
-                }
+        if (emit_objects && lto == masonc::llvm::lto_mode::THIN) {
+            link_thin();
+
+            // Every thread compiles the modules it converted, because they are in its context.
+            code_generation_threads.clear();
+
+            for (u64 i = 0; i < worker_thread_count; i += 1) {
+                code_generation_threads.emplace_back(&builder::emit_thin, this, i);
+            }
+
+            for (std::thread& code_generation_thread : code_generation_threads) {
+                code_generation_thread.join();
             }
         }
 
-        std::unique_lock<std::shared_mutex> file_queue_unique_lock{ file_queue_mutex };
+        // Failed files and link errors are printed by the link thread.
+        for (code_generator& generator : code_generators) {
+            for (generated_module& current_module : generator.modules) {
+                if (current_module.output.messages.errors.size() != 0)
+                    current_module.output.messages.print_errors();
+            }
+        }
 
-        // Perhaps we read some last files without reaching "min_bytes_for_sync".
-        // Sync the rest if we have anything.
-        if (files.size() > 0) {
+        if (object_file_name)
+            write_objects(object_file_name.value());
+    }
 
-            file_queue.insert(file_queue.end(), files.begin(), files.end());
-            file_sizes.insert(file_sizes.end(), sizes.begin(), sizes.end());
+    builder::~builder()
+    {
+        // Modules have to be disposed before the context they are in.
+        for (code_generator& generator : code_generators) {
+            for (generated_module& current_module : generator.modules) {
+                current_module.converter.free();
+            }
+        }
+    }
 
-            split_work();
+    const std::vector<worker_stats>& builder::stats() const
+    {
+        return worker_stats_list;
+    }
+
+    bool builder::has_errors() const
+    {
+        if (link_output.messages.errors.size() != 0)
+            return true;
+
+        for (const code_generator& generator : code_generators) {
+            for (const generated_module& current_module : generator.modules) {
+                if (current_module.output.messages.errors.size() != 0)
+                    return true;
+            }
         }
 
-        no_more_work = true;
+        return false;
+    }
 
-        file_queue_unique_lock.unlock();
-        file_queue_condition.notify_all();
+    bool builder::add_modules(masonc::llvm::llvm_jit* jit)
+    {
+        if (has_errors())
+            return false;
+
+        for (code_generator& generator : code_generators) {
+            for (generated_module& current_module : generator.modules) {
+                LLVMModuleRef module = current_module.output.llvm_module;
+                if (module == nullptr)
+                    continue;
 
-        for (u64 i = 0; i < threads.size(); i += 1) {
-            threads[i].join();
+                current_module.output.llvm_module = nullptr;
+
+                if (!jit->add_module(module))
+                    return false;
+            }
         }
+
+        return true;
     }
 
-    void builder::do_work(u64 thread_index)
+    void builder::parse_file(u64 worker_index, const char* file, u64 file_size)
     {
-        std::shared_lock<std::shared_mutex> file_queue_shared_lock{ file_queue_mutex };
+        auto* current_parse_output = &worker_parse_output[worker_index].emplace_back();
 
-        const std::vector<u64>& work = all_work[thread_index];
-        u64 work_index = 0;
+        if (cache && cache->load(file, file_size, current_parse_output)) {
+            add_declarations(current_parse_output);
+            parsed_modules.push(current_parse_output);
+            return;
+        }
 
-        // To be synced with "parse_outputs".
-        std::vector<masonc::parser::parser_instance_output> buffered_parse_output;
-        std::vector<masonc::parser::parser_instance> parsers;
+        worker_lexers[worker_index].tokenize(file, file_size, &current_parse_output->lexer_output);
 
-        masonc::lexer::lexer_instance lexer;
+        if (current_parse_output->lexer_output.messages.errors.size() != 0) {
+            report_failed_file(current_parse_output->lexer_output.messages);
+            return;
+        }
 
-        while (!no_more_work)
-        {
-            u64 i = work_index;
+        masonc::parser::parser_instance parser{ current_parse_output };
+
+        if (current_parse_output->messages.errors.size() != 0) {
+            report_failed_file(current_parse_output->messages);
+            return;
+        }
+
+        if (cache)
+            cache->store(*current_parse_output);
+
+        add_declarations(current_parse_output);
+        parsed_modules.push(current_parse_output);
+    }
+
+    void builder::report_failed_file(const message_list& messages)
+    {
+        std::lock_guard<std::mutex> failed_file_messages_lock{ failed_file_messages_mutex };
+
+        failed_file_messages.errors.insert(failed_file_messages.errors.end(),
+            messages.errors.begin(), messages.errors.end());
+    }
+
+    void builder::add_declarations(masonc::parser::parser_instance_output* parse_output)
+    {
+        for (const declaration& duplicate : declarations.add_module(parse_output)) {
+            const masonc::parser::top_level_span& span = parse_output->AST_spans[duplicate.top_level_index];
 
-            LOOP:
-            if (i < work.size())
+            parse_output->messages.report_error("Symbol \"" + std::string{ global_interner.at(duplicate.name) } +
+                "\" is already declared by another file of module \"" + parse_output->module_name + "\".",
+                build_stage::PARSER, parse_output->lexer_output.location_at(span.first_token));
+        }
+    }
+
+    void builder::link_modules()
+    {
+        while (true) {
+            std::optional<masonc::parser::parser_instance_output*> parsed_module = parsed_modules.pop();
+            if (!parsed_module)
+                break;
+
+            // Errors found once the file was parsed, like duplicate declarations, fail the link stage,
+            // so that they are printed and no objects are written.
+            const message_list& parse_messages = parsed_module.value()->messages;
+            link_output.messages.errors.insert(link_output.messages.errors.end(),
+                parse_messages.errors.begin(), parse_messages.errors.end());
+
+            for (masonc::parser::parser_instance_output* ready_module :
+                module_linker.add_module(parsed_module.value()))
             {
-                // Do the work.
-                {
-                    auto* current_parse_output = &buffered_parse_output.emplace_back();
+                linked_modules.push(ready_module);
+            }
+        }
 
-                    lexer.tokenize(file_queue[work[i]], file_sizes[work[i]],
-                                &current_parse_output->lexer_output);
+        // Every file is parsed, the ones that failed to are not linked, but they fail the build.
+        link_output.messages.errors.insert(link_output.messages.errors.end(),
+            failed_file_messages.errors.begin(), failed_file_messages.errors.end());
 
-                    if (current_parse_output->lexer_output.messages.errors.size() != 0) {
-                        // TODO: Error.
-                    }
+        // Every file is parsed, so the modules imported by the held ones are complete now.
+        for (masonc::parser::parser_instance_output* ready_module : module_linker.complete_modules()) {
+            linked_modules.push(ready_module);
+        }
+
+        module_linker.report_unresolved_imports(&link_output);
+        module_linker.report_import_cycles(&link_output);
+
+        if (link_output.messages.errors.size() != 0)
+            link_output.messages.print_errors();
+
+        linked_modules.close();
+    }
+
+    void builder::generate_code(u64 generator_index)
+    {
+        code_generator& generator = code_generators[generator_index];
+
+        // Modules that use a name declared by a file that may not be parsed yet.
+        std::vector<generated_module*> deferred_modules;
+
+        while (true) {
+            std::optional<masonc::parser::parser_instance_output*> linked_module = linked_modules.pop();
+            if (!linked_module)
+                break;
+
+            generated_module& current_module = generator.modules.emplace_back();
+            current_module.source = linked_module.value();
+
+            if (!convert_module(&generator, &current_module, true))
+                deferred_modules.push_back(&current_module);
+        }
+
+        // "linked_modules" is only closed once every file is parsed and its declarations are added.
+        for (generated_module* current_module : deferred_modules) {
+            convert_module(&generator, current_module, false);
+        }
+    }
+
+    bool builder::convert_module(code_generator* generator, generated_module* current_module, bool may_defer)
+    {
+        masonc::parser::parser_instance_output* source = current_module->source;
 
-                    masonc::parser::parser_instance parser{ current_parse_output };
+        current_module->converter.convert(&generator->context, &source->lexer_output, source,
+            &current_module->output, !procedure_objects_cache.has_value(), &declarations);
+
+        if (may_defer && current_module->output.unresolved_names) {
+            current_module->converter.free();
+            current_module->output = masonc::llvm::llvm_converter_output{};
+
+            return false;
+        }
+
+        // A module that failed to convert is never compiled, its errors are printed once every module is.
+        if (!emit_objects || current_module->output.messages.errors.size() != 0)
+            return true;
+
+        if (lto == masonc::llvm::lto_mode::THIN) {
+            current_module->summary = masonc::llvm::summarize_module(current_module->output.llvm_module);
+        }
+        else {
+            emit_module(generator, current_module);
+
+            if (procedure_objects_cache)
+                emit_procedures(generator, current_module);
+        }
+
+        return true;
+    }
+
+    void builder::emit_module(code_generator* generator, generated_module* current_module)
+    {
+        current_module->object = generator->emitter.emit(current_module->output.llvm_module,
+            member_name(*current_module->source) + ".o");
+
+        if (!current_module->object) {
+            current_module->output.messages.report_error(generator->emitter.error(),
+                build_stage::CODE_GENERATOR);
+        }
+    }
+
+    void builder::emit_procedures(code_generator* generator, generated_module* current_module)
+    {
+        masonc::parser::parser_instance_output* source = current_module->source;
+
+        masonc::cache::signature_map module_signatures;
+        masonc::cache::add_signatures(*source, &module_signatures);
+
+        symbol module_name = global_interner.intern(source->module_name);
+
+        // Declarations of other files of the module and of imported modules are part of the hash too.
+        // Imported modules are parsed already, but other files of the module may not be yet.
+        auto signature_of = [&](symbol name) -> std::optional<u64> {
+            auto find_it = module_signatures.find(name);
+            if (find_it != module_signatures.end())
+                return find_it->second;
+
+            std::optional<declaration> found = declarations.find(module_name, name);
+
+            if (!found)
+                found = declarations.find_imported(source, name);
+
+            if (!found)
+                return std::nullopt;
+
+            return masonc::cache::declaration_signature(*found->module, found->module->AST[found->top_level_index]);
+        };
+
+        std::string module_member_name = member_name(*source);
+
+        for (masonc::parser::expression_handle top_level : source->AST) {
+            const masonc::parser::expression& expr = source->expression_at(top_level);
+            if (expr.type != masonc::parser::EXPR_PROC_DEFINITION)
+                continue;
+
+            symbol name = source->expression_at(expr.procedure_definition.prototype).procedure_prototype.name_handle;
+            std::string procedure_member_name = module_member_name + "." + std::string{ global_interner.at(name) } + ".o";
+
+            // A procedure that refers to a name whose declaration is not parsed yet is compiled,
+            // but not cached, since its entry would not change with the declaration.
+            std::optional<u64> entry_key;
+            std::optional<u64> hash = masonc::cache::procedure_hash(*source, expr.procedure_definition, signature_of);
+
+            if (hash)
+                entry_key = masonc::cache::procedure_cache::key(hash.value(), generator->emitter.configuration());
+
+            std::optional<archive_member> object;
+
+            if (entry_key)
+                object = procedure_objects_cache->load(entry_key.value(), procedure_member_name);
+
+            if (!object) {
+                masonc::llvm::llvm_converter converter;
+                masonc::llvm::llvm_converter_output output;
+
+                converter.convert_procedure_definition(&generator->context, &source->lexer_output, source,
+                    top_level, &output, &declarations);
+
+                if (output.messages.errors.size() != 0) {
+                    current_module->output.messages.errors.insert(current_module->output.messages.errors.end(),
+                        output.messages.errors.begin(), output.messages.errors.end());
+
+                    converter.free();
+                    return;
+                }
+
+                object = generator->emitter.emit(output.llvm_module, procedure_member_name);
+                converter.free();
+
+                if (!object) {
+                    current_module->output.messages.report_error(generator->emitter.error(),
+                        build_stage::CODE_GENERATOR);
+                    return;
                 }
 
-                i += 1;
-                goto LOOP;
+                if (entry_key)
+                    procedure_objects_cache->store(entry_key.value(), object.value());
             }
 
-            // There is no (more) work, we either had a spurious wakeup, we didn't get any work,
-            // or we already finished our work.
-            work_index = work.size();
-            file_queue_condition.wait(file_queue_mutex);
+            current_module->procedure_objects.push_back(std::move(object.value()));
         }
+    }
+
+    void builder::link_thin()
+    {
+        // Nothing is inlined without optimizations, so importing would only cost time.
+        if (optimization_level == 0)
+            return;
+
+        // Several files can make up one module.
+        robin_hood::unordered_map<std::string, std::vector<const generated_module*>> modules_by_name;
+
+        for (const code_generator& generator : code_generators) {
+            for (const generated_module& current_module : generator.modules) {
+                modules_by_name[current_module.source->module_name].push_back(&current_module);
+            }
+        }
+
+        for (code_generator& generator : code_generators) {
+            for (generated_module& current_module : generator.modules) {
+                const cstring_collection& import_names = current_module.source->file_module.module_import_names;
+
+                for (u64 i = 0; i < import_names.size(); i += 1) {
+                    auto find_it = modules_by_name.find(std::string{ import_names.at(i), import_names.length_at(i) });
+                    if (find_it == modules_by_name.end())
+                        continue;
+
+                    for (const generated_module* imported_module : find_it->second) {
+                        if (!imported_module->summary)
+                            continue;
 
-        // Sync all the parse results.
-        std::unique_lock<std::mutex> parse_output_lock{ parse_output_mutex };
-        parse_output.insert(parse_output.end(),
-                            buffered_parse_output.begin(),
-                            buffered_parse_output.end());
+                        masonc::llvm::procedure_import import{ &imported_module->summary.value(), {} };
+
+                        for (const masonc::llvm::procedure_summary& procedure : imported_module->summary->procedures) {
+                            if (procedure.instruction_count <= masonc::llvm::IMPORT_INSTRUCTION_LIMIT)
+                                import.names.push_back(procedure.name);
+                        }
+
+                        if (!import.names.empty())
+                            current_module.imports.push_back(std::move(import));
+                    }
+                }
+            }
+        }
     }
 
-    void builder::split_work()
+    void builder::emit_thin(u64 generator_index)
     {
-        // Setting the average file size as a sort of "minimum amount of work"
-        // should help counteract randomness of file sizes, such that some workers
-        // don't only have a tiny file to work with while others have a huge file.
-        // Instead, a worker will get multiple files to work with if they are relatively small
-        // (provided that there is some variance in file sizes).
-        u64 average_file_size = 0;
-        for (u64 i = file_queue_first; i < file_sizes.size(); i += 1) {
-            average_file_size += file_sizes[i];
-        }
-        average_file_size /= file_sizes.size() - file_queue_first;
-
-        // How many bytes the current worker thread will be assigned to work with.
-        u64 work_size = 0;
-
-        u64 thread_index = 0;
-        for (u64 i = file_queue_first; i < file_sizes.size(); i += 1)
-        {
-            all_work[thread_index].push_back(i);
+        code_generator& generator = code_generators[generator_index];
+
+        for (generated_module& current_module : generator.modules) {
+            if (current_module.output.messages.errors.size() != 0)
+                continue;
+
+            for (const masonc::llvm::procedure_import& import : current_module.imports) {
+                // The module is still correct without the import, it is only optimized less.
+                if (!masonc::llvm::import_procedures(current_module.output.llvm_module, import)) {
+                    current_module.output.messages.report_warning(
+                        "Could not import procedures into module \"" + current_module.source->module_name + "\".",
+                        build_stage::CODE_GENERATOR);
+                }
+            }
 
-            work_size += file_sizes[i];
-            file_queue_first += 1;
+            emit_module(&generator, &current_module);
+        }
+    }
+
+    void builder::write_objects(const std::string& object_file_name)
+    {
+        message_list write_messages;
+        std::string not_written_error = "Nothing was written to \"" + object_file_name + "\" because of errors.";
+
+        // The modules that did get converted may refer to ones that are missing or never converted.
+        if (has_errors()) {
+            write_messages.report_error(not_written_error);
+            write_messages.print_errors();
+            return;
+        }
+
+        std::vector<archive_member> members;
 
-            if (work_size > average_file_size) {
-                work_size = 0;
+        for (code_generator& generator : code_generators) {
+            for (generated_module& current_module : generator.modules) {
+                if (!current_module.object) {
+                    write_messages.report_error(not_written_error);
+                    write_messages.print_errors();
+                    return;
+                }
+
+                members.push_back(std::move(current_module.object.value()));
 
-                // Go to next worker, wrapping if there aren't many worker threads.
-                if (thread_index < worker_thread_count - 1)
-                    thread_index += 1;
-                else
-                    thread_index = 0;
+                for (archive_member& procedure_object : current_module.procedure_objects) {
+                    members.push_back(std::move(procedure_object));
+                }
             }
         }
+
+        if (members.empty()) {
+            write_messages.report_error("No modules to write to \"" + object_file_name + "\".");
+            write_messages.print_errors();
+            return;
+        }
+
+        // Modules are spread over the threads in no particular order, sort them so that
+        // the same sources always give the same archive. Identical files of a module
+        // have the same name, but then their objects are the same as well.
+        std::sort(members.begin(), members.end(), [](const archive_member& a, const archive_member& b) {
+            return std::tie(a.name, a.contents) < std::tie(b.name, b.contents);
+        });
+
+        const std::string& contents = (members.size() == 1) ? members[0].contents : archive_create(members);
+
+        if (!file_write(object_file_name, contents)) {
+            write_messages.report_error("Could not write \"" + object_file_name + "\".");
+            write_messages.print_errors();
+        }
+    }
+
+    std::string builder::member_name(const masonc::parser::parser_instance_output& source)
+    {
+        // "::" separates the parts of module names, but may not be part of a file name.
+        std::string name = source.module_name;
+        std::replace(name.begin(), name.end(), ':', '_');
+
+        // Every file of a module is an object of its own, they are told apart by their contents,
+        // which unlike the order in which files are loaded is the same in every build.
+        char contents_hash[17];
+        std::snprintf(contents_hash, sizeof(contents_hash), "%016llx", static_cast<unsigned long long>(
+            robin_hood::hash_bytes(source.lexer_output.input, source.lexer_output.input_size)));
+
+        return name + "." + contents_hash;
     }
 
     std::vector<std::string> builder::concrete_file_paths(const std::vector<path>& sources) const
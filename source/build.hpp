@@ -3,36 +3,156 @@
 
 #include <common.hpp>
 #include <io.hpp>
+#include <lexer.hpp>
 #include <parser.hpp>
+#include <linker.hpp>
+#include <llvm_converter.hpp>
+#include <llvm_emitter.hpp>
+#include <llvm_jit.hpp>
+#include <thin_lto.hpp>
+#include <archive.hpp>
+#include <module_cache.hpp>
+#include <procedure_cache.hpp>
+#include <symbol_table.hpp>
+#include <scheduler.hpp>
+#include <bounded_queue.hpp>
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <thread>
 #include <mutex>
-#include <shared_mutex>
-#include <condition_variable>
+#include <optional>
 
 namespace masonc
 {
     // Highest level object that allows building object files, executables, and so on.
+    //
+    // The build runs as a pipeline. Workers lex and parse files as they are loaded,
+    // a link thread takes each parsed module and passes it on right away if it imports no other module,
+    // or else once every file is parsed, because only then are the modules it imports complete,
+    // and code generation threads convert linked modules while other files are still being parsed.
+    // A module that uses a name which no parsed file declares yet is converted once every file is parsed.
     struct builder
     {
         builder(std::vector<path> sources,
-                // Threads to use, must be either 0 or >= 2.
-                // If the value is 0, max(2, "std::thread::hardware_concurrency()") is assumed.
-                // If the value is 1, 2 is assumed.
+                // Threads to use, each of parsing and code generation gets as many.
+                // If the value is 0, "std::thread::hardware_concurrency()" is used, or 1 if that is unknown.
+                // Any other value is used as given.
                 u64 overwrite_thread_count = 0,
-                // How many bytes to read at minimum before synchronizing.
-                // If a line contains 40 characters on average, this will synchronize
-                // after reading at least 6553 lines.
-                u64 min_bytes_for_sync = 1024 * 256);
+                // Directory of a "masonc::cache::module_cache". Files whose contents
+                // are found in it are not lexed and parsed again.
+                // Without LTO, it also holds a "masonc::cache::procedure_cache",
+                // and procedures found in it are not compiled again.
+                std::optional<std::string> cache_directory = std::nullopt,
+                // File to write the compiled modules to. A single module is written as an object file,
+                // several are written as an archive of object files, one for each module.
+                // Nothing is written if the value is empty.
+                std::optional<std::string> object_file_name = std::nullopt,
+                // Like "-O0" to "-O3", see "masonc::llvm::llvm_emitter".
+                u32 optimization_level = 2,
+                // Whether procedures are inlined across modules, see "masonc::llvm::lto_mode".
+                masonc::llvm::lto_mode lto = masonc::llvm::lto_mode::NONE);
+
+        ~builder();
+
+        // Time every worker thread spent parsing and waiting during the build.
+        const std::vector<worker_stats>& stats() const;
+
+        // Whether any file or module failed at any stage, link errors included.
+        // The errors themselves are printed during the build.
+        bool has_errors() const;
+
+        // Hands every converted module to "jit", which owns them from then on, so this is only
+        // possible once and if no object file was written. The builder has to outlive "jit",
+        // because it owns the contexts of the modules.
+        // Returns false if the build has errors, see "has_errors", or a module could not be added,
+        // see "masonc::llvm::llvm_jit::error".
+        bool add_modules(masonc::llvm::llvm_jit* jit);
 
     private:
-        void do_work(u64 thread_index);
+        // How many modules can wait between two stages before the earlier stage blocks.
+        static constexpr u64 STAGE_QUEUE_CAPACITY = 64;
+
+        struct generated_module
+        {
+            masonc::llvm::llvm_converter converter;
+            masonc::llvm::llvm_converter_output output;
+
+            // Compiled module, if objects are emitted and emitting it worked.
+            std::optional<archive_member> object;
+
+            // With a procedure cache, every procedure definition is compiled into an object of its own
+            // and "object" only has the rest of the module.
+            std::vector<archive_member> procedure_objects;
+
+            // Module that was converted.
+            masonc::parser::parser_instance_output* source = nullptr;
+
+            // Only with "lto_mode::THIN", where modules are compiled once all are summarized.
+            std::optional<masonc::llvm::module_summary> summary;
+            std::vector<masonc::llvm::procedure_import> imports;
+        };
+
+        // State of one code generation thread. Every module it converts is an LLVM module
+        // of its own in the thread's context, which the thread also optimizes and compiles.
+        struct code_generator
+        {
+            explicit code_generator(u32 optimization_level)
+                : emitter{ optimization_level }
+            { }
+
+            masonc::llvm::llvm_context context;
+            masonc::llvm::llvm_emitter emitter;
+            std::deque<generated_module> modules;
+        };
+
+        // Lexes and parses one file on the worker with index "worker_index", unless it is cached,
+        // and hands the module to the link stage if there were no errors.
+        void parse_file(u64 worker_index, const char* file, u64 file_size);
+
+        // Keeps the errors of a file that could not be loaded, lexed or parsed, so that the build fails
+        // although the file never reaches the link stage. Can be called from several threads at once.
+        void report_failed_file(const message_list& messages);
+
+        // Adds the top-level declarations of "parse_output" to "declarations" and reports an error
+        // in its messages for every symbol that another file of the same module declared already.
+        void add_declarations(masonc::parser::parser_instance_output* parse_output);
+
+        // Runs on the link thread until "parsed_modules" is closed and empty.
+        void link_modules();
+
+        // Runs on the code generation thread with index "generator_index"
+        // until "linked_modules" is closed and empty.
+        void generate_code(u64 generator_index);
 
-        // Split remaining work in "file_queue" between threads as evenly as possible,
-        // increasing "file_queue_first" until the current queue is split and delegated to workers.
-        void split_work();
+        // Converts "current_module" on the code generation thread of "generator" and compiles it
+        // if objects are emitted. If "may_defer" is true and the module uses a name that no parsed file
+        // declares, which another file of its module may still declare, nothing is done and false is returned.
+        bool convert_module(code_generator* generator, generated_module* current_module, bool may_defer);
+
+        // Optimizes and compiles "current_module" on the code generation thread of "generator".
+        void emit_module(code_generator* generator, generated_module* current_module);
+
+        // Compiles every procedure definition of "current_module" on its own, unless its object
+        // is found in "procedure_objects_cache", and stores the objects of the ones that were compiled.
+        void emit_procedures(code_generator* generator, generated_module* current_module);
+
+        // Decides which procedures each module imports, looking only at the summaries of the modules
+        // it imports. Runs once all modules are summarized.
+        void link_thin();
+
+        // Runs on the code generation thread with index "generator_index" after "link_thin",
+        // imports procedures into each of the thread's modules and compiles them.
+        void emit_thin(u64 generator_index);
+
+        // Name of the archive member of "source", the module name and a hash of the file's contents.
+        // Procedure objects add the procedure to it.
+        static std::string member_name(const masonc::parser::parser_instance_output& source);
+
+        // Writes the objects of all generated modules to "object_file_name". Reports an error and writes nothing
+        // if any file or module failed at any stage, or if there are no modules.
+        void write_objects(const std::string& object_file_name);
 
         // Returns a list of file paths from a list of "path".
         //
@@ -42,26 +162,53 @@ namespace masonc
 
         u64 worker_thread_count;
 
-        // Protects "all_work", "file_queue", "file_sizes", "file_queue_first", and "no_more_work".
-        std::shared_mutex file_queue_mutex;
-        std::condition_variable_any file_queue_condition;
+        // Whether code generation threads compile the modules they convert.
+        bool emit_objects = false;
+
+        u32 optimization_level;
+        masonc::llvm::lto_mode lto;
+
+        // Only read from once the workers are started.
+        std::optional<masonc::cache::module_cache> cache;
+
+        // Only set if objects are emitted without LTO, which would need whole modules.
+        std::optional<masonc::cache::procedure_cache> procedure_objects_cache;
+
+        // Protects "mapped_files".
+        std::mutex mapped_files_mutex;
+
+        // Token values in "parse_output" point into these, so they have to outlive it,
+        // which is why they are declared before it.
+        std::vector<mapped_file> mapped_files;
+
+        // Each worker only touches the element at its own index, so these need no lock.
+        // Parse outputs are kept in deques, which do not move them, so the later stages can point to them.
+        std::vector<masonc::lexer::lexer_instance> worker_lexers;
+        std::vector<std::deque<masonc::parser::parser_instance_output>> worker_parse_output;
+
+        // Protects "failed_file_messages".
+        std::mutex failed_file_messages_mutex;
+
+        // Errors of every file passed to "report_failed_file",
+        // added to "link_output" by the link thread once every file is parsed.
+        message_list failed_file_messages;
+
+        // Top-level declarations of every parsed module, added by the workers before
+        // a module is handed to the link stage.
+        symbol_table declarations;
 
-        // Each thread has an index to an element here,
-        // and each element here says which elements of "file_queue" are work for the given thread.
-        std::vector<std::vector<u64>> all_work;
+        bounded_queue<masonc::parser::parser_instance_output*> parsed_modules{ STAGE_QUEUE_CAPACITY };
+        bounded_queue<masonc::parser::parser_instance_output*> linked_modules{ STAGE_QUEUE_CAPACITY };
 
-        // TODO: Free at some point.
-        // FIXME: Maybe switch to "cstring_collection"?
-        std::vector<const char*> file_queue;
-        std::vector<u64> file_sizes;
-        u64 file_queue_first = 0;
+        // Only used by the link thread until the build is done.
+        masonc::linker::linker module_linker;
+        masonc::linker::linker_output link_output;
 
-        // Quit condition for worker threads.
-        bool no_more_work = false;
+        // Each code generation thread only touches the element at its own index until the build is done.
+        // Kept in a deque, because LLVM contexts cannot be moved.
+        std::deque<code_generator> code_generators;
 
-        // Protects "parse_outputs".
-        std::mutex parse_output_mutex;
-        std::vector<masonc::parser::parser_instance_output> parse_output;
+        std::vector<worker_stats> worker_stats_list;
     };
 }
 
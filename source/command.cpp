@@ -3,6 +3,7 @@
 #include <logger.hpp>
 #include <io.hpp>
 #include <build.hpp>
+#include <test.hpp>
 
 #include <iostream>
 #include <cstdlib>
@@ -18,7 +19,7 @@ namespace masonc
         std::string output;
 
         for(auto it = COMMANDS.begin(); it != COMMANDS.end(); it++) {
-            std::string command_usage = "Command: " + std::string{ it->first };
+            std::string command_usage = "Command: " + std::string{ global_interner.at(it->first) };
             std::string command_description = "Description: " + std::string{ it->second.description } + "\n";
             std::string command_argument_list;
 
@@ -33,7 +34,7 @@ namespace masonc
             }
 
             for(auto option : it->second.options) {
-                const char* option_name = option.first;
+                const char* option_name = global_interner.at(option.first).data();
                 const char* option_type_name = command_argument_type_string(option.second.type);
                 const char* option_description = option.second.description;
 
@@ -55,8 +56,11 @@ namespace masonc
 
     void execute_command_usage(const command_parsed& command)
     {
-        const char* key = command.parsed_arguments[0].second.str;
-        auto find_command_it = COMMANDS.find(key);
+        std::string_view key = command.parsed_arguments[0].second.str.view();
+
+        // A name that was never interned cannot be a command either.
+        std::optional<string_id> key_id = global_interner.find(key);
+        auto find_command_it = key_id ? COMMANDS.find(key_id.value()) : COMMANDS.end();
 
         if (find_command_it == COMMANDS.end()) {
             std::cout << "Command \"" << key << "\" does not exist." << std::endl;
@@ -74,33 +78,139 @@ namespace masonc
         std::exit(0);
     }
 
+    // Splits the "sources" argument of a command into paths.
+    static std::vector<path> split_source_paths(std::string_view sources)
+    {
+        std::vector<path> split_sources;
+
+        while (true) {
+            u64 separator = sources.find('\n');
+            split_sources.push_back(path{ std::string{ sources.substr(0, separator) } });
+
+            if (separator == std::string_view::npos)
+                break;
+
+            sources.remove_prefix(separator + 1);
+        }
+
+        return split_sources;
+    }
+
+    // Stores the value of the "threads" option in "thread_count",
+    // returns false and prints why if it is not a valid thread count.
+    static bool parse_thread_count(s64 value, u64* thread_count)
+    {
+        if (value < 0) {
+            std::cout << "Thread count must not be negative." << std::endl;
+            return false;
+        }
+
+        *thread_count = static_cast<u64>(value);
+        return true;
+    }
+
     void execute_command_build(const command_parsed& command)
     {
         // TODO: Handle "add_extensions" option.
-        const char* sources = command.parsed_arguments[0].second.str;
-        const char* object_file_name = command.parsed_arguments[1].second.str;
+        std::vector<path> split_sources = split_source_paths(command.parsed_arguments[0].second.str.view());
+        std::string_view object_file_name = command.parsed_arguments[1].second.str.view();
 
-        std::vector<path> split_sources;
-        std::string temp;
+        std::optional<std::string> cache_directory;
+        u64 thread_count = 0;
+        u32 optimization_level = 2;
+        masonc::llvm::lto_mode lto = masonc::llvm::lto_mode::NONE;
 
-        const char* current_char = sources;
-        while (true) {
-            if (*current_char == '\n') {
-                split_sources.push_back(path{ temp });
-                temp = "";
-                current_char += 1;
+        for (const command_option_tuple& option : command.parsed_options) {
+            if (std::get<2>(option) == global_interner.intern("cache"))
+                cache_directory = std::string{ std::get<1>(option).str.view() };
+
+            if (std::get<2>(option) == global_interner.intern("threads")) {
+                if (!parse_thread_count(std::get<1>(option).integer, &thread_count))
+                    return;
             }
-            else if (*current_char == '\0') {
-                split_sources.push_back(path{ temp });
-                break;
+
+            if (std::get<2>(option) == global_interner.intern("optimization")) {
+                s64 level = std::get<1>(option).integer;
+
+                if (level < 0 || level > static_cast<s64>(masonc::llvm::MAX_OPTIMIZATION_LEVEL)) {
+                    std::cout << "Optimization level must be between 0 and "
+                              << masonc::llvm::MAX_OPTIMIZATION_LEVEL << "." << std::endl;
+                    return;
+                }
+
+                optimization_level = static_cast<u32>(level);
             }
-            else {
-                temp += *current_char;
-                current_char += 1;
+
+            if (std::get<2>(option) == global_interner.intern("lto")) {
+                std::string_view mode = std::get<1>(option).str.view();
+
+                if (mode == "thin") {
+                    lto = masonc::llvm::lto_mode::THIN;
+                }
+                else if (mode != "none") {
+                    std::cout << "LTO mode must be \"thin\" or \"none\"." << std::endl;
+                    return;
+                }
             }
         }
 
-        builder executable_builder{ split_sources, 1 };
+        builder executable_builder{ split_sources, thread_count, cache_directory,
+            std::string{ object_file_name }, optimization_level, lto };
+    }
+
+    void execute_command_run(const command_parsed& command)
+    {
+        std::vector<path> split_sources = split_source_paths(command.parsed_arguments[0].second.str.view());
+        std::string procedure_name{ command.parsed_arguments[1].second.str.view() };
+
+        std::optional<std::string> cache_directory;
+        u64 thread_count = 0;
+
+        for (const command_option_tuple& option : command.parsed_options) {
+            if (std::get<2>(option) == global_interner.intern("cache"))
+                cache_directory = std::string{ std::get<1>(option).str.view() };
+
+            if (std::get<2>(option) == global_interner.intern("threads")) {
+                if (!parse_thread_count(std::get<1>(option).integer, &thread_count))
+                    return;
+            }
+        }
+
+        // No object file is written, the modules are only converted.
+        builder program_builder{ split_sources, thread_count, cache_directory };
+
+        // The errors were printed by the builder.
+        if (program_builder.has_errors())
+            return;
+
+        // Declared after the builder, so that it is destroyed before the contexts of its modules.
+        masonc::llvm::llvm_jit jit;
+
+        if (!jit.is_valid()) {
+            std::cout << jit.error() << std::endl;
+            return;
+        }
+
+        if (!program_builder.add_modules(&jit)) {
+            if (!jit.error().empty())
+                std::cout << jit.error() << std::endl;
+
+            return;
+        }
+
+        std::optional<s64> result = jit.run(procedure_name);
+
+        if (!result) {
+            std::cout << jit.error() << std::endl;
+            return;
+        }
+
+        std::cout << "Procedure \"" << procedure_name << "\" returned " << result.value() << "." << std::endl;
+    }
+
+    void execute_command_benchmark(const command_parsed&)
+    {
+        masonc::test::perform_all_benchmarks();
     }
 
     bool execute_command(const std::string& input)
@@ -158,25 +268,24 @@ namespace masonc
 
     std::optional<command_name_pair*> find_command(masonc::lexer::lexer_instance_output* output)
     {
-        if(output->tokens.size() == 0) {
+        if(output->token_count() == 0) {
             // User entered nothing or whitespace only.
             std::cout << "Expected command name." << std::endl;
             return std::nullopt;
         }
-        masonc::lexer::token *command_token = &output->tokens[0];
+        masonc::lexer::token command_token = output->token_at(0);
 
-        if(command_token->type != masonc::lexer::TOKEN_IDENTIFIER) {
+        if(command_token.type != masonc::lexer::TOKEN_IDENTIFIER) {
             // User did not enter a valid command name.
             std::cout << "Expected command name." << std::endl;
             return std::nullopt;
         }
 
-        const char* command_name = output->identifiers.at(command_token->value_index);
-
-        auto find_command_it = COMMANDS.find(command_name);
+        auto find_command_it = COMMANDS.find(static_cast<string_id>(command_token.value_index));
         if(find_command_it == COMMANDS.end()) {
             // User entered a command that does not exist.
-            std::cout << "Command \"" << command_name << "\" does not exist." << std::endl;
+            std::cout << "Command \"" << output->identifier_at(command_token.value_index)
+                      << "\" does not exist." << std::endl;
             return std::nullopt;
         }
 
@@ -207,7 +316,7 @@ namespace masonc
 
         // Parse arguments.
         for(u64 i = 0; i < command.definition->arguments.size(); i += 1) {
-            if(token_index >= output->tokens.size()) {
+            if(token_index >= output->token_count()) {
                 std::cout << "Missing argument(s)." << std::endl;
                 return std::nullopt;
             }
@@ -222,7 +331,7 @@ namespace masonc
         }
 
         // Parse optional arguments.
-        while(token_index < output->tokens.size()) {
+        while(token_index < output->token_count()) {
             auto option_result = parse_command_option(&token_index,
                 output, command.definition->options);
 
@@ -240,7 +349,7 @@ namespace masonc
     {
         command_argument_value value;
 
-        masonc::lexer::token* current_token = &output->tokens[*token_index];
+        masonc::lexer::token current_token = output->token_at(*token_index);
         *token_index += 1;
 
         switch(argument_type) {
@@ -249,68 +358,71 @@ namespace masonc
                 return std::nullopt;
 
             case command_argument_type::INTEGER:
-                if(current_token->type != masonc::lexer::TOKEN_INTEGER) {
+                if(current_token.type != masonc::lexer::TOKEN_INTEGER) {
                     std::cout << "Mismatched type, expected an integer." << std::endl;
                     return std::nullopt;
                 }
 
-                value.integer = static_cast<s64>(std::stoll(output->integers.at(current_token->value_index)));
+                value.integer = static_cast<s64>(std::stoll(std::string{
+                    output->integer_at(current_token.value_index) }));
                 return std::make_optional(command_argument_pair{ command_argument_type::INTEGER, value });
 
             case command_argument_type::DECIMAL:
-                if(current_token->type != masonc::lexer::TOKEN_DECIMAL) {
+                if(current_token.type != masonc::lexer::TOKEN_DECIMAL) {
                     std::cout << "Mismatched type, expected a decimal." << std::endl;
                     return std::nullopt;
                 }
 
-                value.decimal = static_cast<f64>(std::stod(output->decimals.at(current_token->value_index)));
+                value.decimal = static_cast<f64>(std::stod(std::string{
+                    output->decimal_at(current_token.value_index) }));
                 return std::make_optional(command_argument_pair{ command_argument_type::DECIMAL, value });
 
             case command_argument_type::STRING:
-                if(current_token->type != masonc::lexer::TOKEN_STRING) {
+                if(current_token.type != masonc::lexer::TOKEN_STRING) {
                     std::cout << "Mismatched type, expected a string." << std::endl;
                     return std::nullopt;
                 }
 
-                value.str = output->strings.at(current_token->value_index);
+                std::string_view str = output->string_at(current_token.value_index);
+                value.str = command_string{ str.data(), str.length() };
                 return std::make_optional(command_argument_pair{ command_argument_type::STRING, value });
         }
     }
 
     std::optional<command_option_tuple> parse_command_option(u64* token_index,
-        masonc::lexer::lexer_instance_output* output, const std::map<const char*,
+        masonc::lexer::lexer_instance_output* output, const std::map<string_id,
         command_option_definition>& options)
     {
-        if(*token_index + 4 >= output->tokens.size()) {
+        if(*token_index + 4 >= output->token_count()) {
             std::cout << "Incomplete option." << std::endl;
             return std::nullopt;
         }
 
         // Relevant tokens of the option "-identifier=".
-        masonc::lexer::token* dash_token = &output->tokens[*token_index];
-        masonc::lexer::token* dash_token_2 = &output->tokens[*token_index + 1];
-        masonc::lexer::token* identifier_token = &output->tokens[*token_index + 2];
-        masonc::lexer::token* equals_token = &output->tokens[*token_index + 3];
+        masonc::lexer::token dash_token = output->token_at(*token_index);
+        masonc::lexer::token dash_token_2 = output->token_at(*token_index + 1);
+        masonc::lexer::token identifier_token = output->token_at(*token_index + 2);
+        masonc::lexer::token equals_token = output->token_at(*token_index + 3);
         *token_index += 4;
 
-        if(dash_token->type != '-') {
+        if(dash_token.type != '-') {
             std::cout << "Invalid option format, expected \"--\"." << std::endl;
             return std::nullopt;
         }
-        if(dash_token_2->type != '-') {
+        if(dash_token_2.type != '-') {
             std::cout << "Invalid option format, expected \"--\"." << std::endl;
             return std::nullopt;
         }
-        if(identifier_token->type != masonc::lexer::TOKEN_IDENTIFIER) {
+        if(identifier_token.type != masonc::lexer::TOKEN_IDENTIFIER) {
             std::cout << "Invalid option format, expected identifier." << std::endl;
             return std::nullopt;
         }
-        if(equals_token->type != '=') {
+        if(equals_token.type != '=') {
             std::cout << "Invalid option format, expected \"=\"." << std::endl;
             return std::nullopt;
         }
 
-        const char* option_name = output->identifiers.at(identifier_token->value_index);
+        string_id option_name = static_cast<string_id>(identifier_token.value_index);
         auto option_find_it = options.find(option_name);
 
         if(option_find_it == options.end()) {
@@ -4,6 +4,7 @@
 #include <common.hpp>
 #include <lexer.hpp>
 #include <containers.hpp>
+#include <interner.hpp>
 
 #include <map>
 #include <vector>
@@ -21,11 +22,20 @@ namespace masonc
         STRING
     };
 
+    // Non-owning view into the command input, not null-terminated.
+    struct command_string
+    {
+        const char* data;
+        u64 length;
+
+        std::string_view view() const { return std::string_view{ data, length }; }
+    };
+
     union command_argument_value
     {
         s64 integer;
         f64 decimal;
-        const char* str;
+        command_string str;
     };
 
     struct command_argument_definition
@@ -48,16 +58,17 @@ namespace masonc
         const char* description;
         void(*executor)(const command_parsed& command);
         std::vector<command_argument_definition> arguments;
-        std::map<const char*, command_option_definition> options;
+        // Keyed by the interned option name.
+        std::map<string_id, command_option_definition> options;
     };
 
     using command_argument_pair = std::pair<command_argument_type, command_argument_value>;
     using command_option_tuple = std::tuple<command_argument_type,
-        command_argument_value, const char*>;
+        command_argument_value, string_id>;
 
     struct command_parsed
     {
-        const char* name;
+        string_id name;
         const command_definition* definition;
         std::vector<command_argument_pair> parsed_arguments;
         std::vector<command_option_tuple> parsed_options;
@@ -67,6 +78,8 @@ namespace masonc
     void execute_command_usage(const command_parsed& command);
     void execute_command_exit(const command_parsed& command);
     void execute_command_build(const command_parsed& command);
+    void execute_command_run(const command_parsed& command);
+    void execute_command_benchmark(const command_parsed& command);
 
     // Parse "input" into a command and execute it.
     // Returns false if the input cannot be parsed nor executed.
@@ -82,7 +95,7 @@ namespace masonc
     const char* command_argument_type_string(command_argument_type argument_type);
 
     // Command name associated with command definition - key and value types of "COMMANDS".
-    using command_name_pair = const robin_hood::pair<const char* const, const command_definition>;
+    using command_name_pair = const robin_hood::pair<const string_id, const command_definition>;
 
     // Returns a pointer to a key-value pair in "COMMANDS"
     // that matches the command name found in the tokenizer's output.
@@ -97,13 +110,14 @@ namespace masonc
 
     // Parse optional argument of a command.
     std::optional<command_option_tuple> parse_command_option(u64* token_index,
-        masonc::lexer::lexer_instance_output* output, const std::map<const char*,
+        masonc::lexer::lexer_instance_output* output, const std::map<string_id,
         command_option_definition>& options);
 
-    inline const cstring_unordered_map<const command_definition> COMMANDS =
+    // Keyed by the interned command name, which is what the lexer hands out for identifiers.
+    inline const robin_hood::unordered_map<string_id, const command_definition> COMMANDS =
     {
         {
-            "help",
+            global_interner.intern("help"),
             command_definition {
                 0,
                 "Print a list of all available commands.",
@@ -111,7 +125,7 @@ namespace masonc
             }
         },
         {
-            "usage",
+            global_interner.intern("usage"),
             command_definition {
                 1,
                 "Print description and usage of a specific command.",
@@ -127,7 +141,7 @@ namespace masonc
             }
         },
         {
-            "exit",
+            global_interner.intern("exit"),
             command_definition {
                 2,
                 "Quit the program.",
@@ -135,7 +149,7 @@ namespace masonc
             }
         },
         {
-            "build",
+            global_interner.intern("build"),
             command_definition {
                 3,
                 "Build a list of source files into an object file.",
@@ -155,22 +169,106 @@ namespace masonc
                     },
                     command_argument_definition {
                         "object_file_name",
-                        "Name of the output object file.",
+                        "Name of the output object file. Several modules are written "
+                        "as an archive of object files.",
                         command_argument_type::STRING
                     }
                 },
-                std::map<const char*, command_option_definition>
+                std::map<string_id, command_option_definition>
                 {
                     {
-                        "add_extensions",
+                        global_interner.intern("add_extensions"),
                         command_option_definition {
                             "Additional file extensions to consider source files "
                             "separated by \"\\n\".",
                             command_argument_type::STRING
                         }
+                    },
+                    {
+                        global_interner.intern("cache"),
+                        command_option_definition {
+                            "Directory to keep lexed and parsed files in, "
+                            "unchanged files are loaded from it instead of parsed again.",
+                            command_argument_type::STRING
+                        }
+                    },
+                    {
+                        global_interner.intern("threads"),
+                        command_option_definition {
+                            "Number of threads to build with, "
+                            "one for every hardware thread by default or if it is 0.",
+                            command_argument_type::INTEGER
+                        }
+                    },
+                    {
+                        global_interner.intern("optimization"),
+                        command_option_definition {
+                            "Optimization level from 0 (none) to 3 (most), 2 by default.",
+                            command_argument_type::INTEGER
+                        }
+                    },
+                    {
+                        global_interner.intern("lto"),
+                        command_option_definition {
+                            "\"thin\" to inline small procedures of imported modules, "
+                            "\"none\" by default.",
+                            command_argument_type::STRING
+                        }
                     }
                 }
             }
+        },
+        {
+            global_interner.intern("run"),
+            command_definition {
+                4,
+                "Compile a list of source files in memory and run one of their procedures.",
+                &execute_command_run,
+                std::vector<command_argument_definition>
+                {
+                    command_argument_definition {
+                        "sources",
+                        "List of source directory and/or "
+                        "file paths, like for \"build\".",
+                        command_argument_type::STRING
+                    },
+                    command_argument_definition {
+                        "procedure_name",
+                        "Name of the procedure to run. It has to take no arguments "
+                        "and return nothing or an integer, which is printed, "
+                        "sign-extended unless its type is unsigned, \"bool\" or \"char\". "
+                        "Procedures are compiled when they are first called.",
+                        command_argument_type::STRING
+                    }
+                },
+                std::map<string_id, command_option_definition>
+                {
+                    {
+                        global_interner.intern("cache"),
+                        command_option_definition {
+                            "Directory to keep lexed and parsed files in, "
+                            "unchanged files are loaded from it instead of parsed again.",
+                            command_argument_type::STRING
+                        }
+                    },
+                    {
+                        global_interner.intern("threads"),
+                        command_option_definition {
+                            "Number of threads to build with, "
+                            "one for every hardware thread by default or if it is 0.",
+                            command_argument_type::INTEGER
+                        }
+                    }
+                }
+            }
+        },
+        {
+            global_interner.intern("benchmark"),
+            command_definition {
+                5,
+                "Measure and print the throughput of the lexer and parser.",
+                &execute_command_benchmark
+            }
         }
     };
 }
@@ -6,6 +6,6 @@ namespace masonc
 {
     void initialize_language()
     {
-        initialize_module_scope_template();
+        initialize_builtin_scope();
     }
 }
@@ -13,6 +13,14 @@ namespace masonc
     // Master initialize function, call before doing anything else.
     void initialize_language();
 
+    // Keywords are interned up front so they can be compared to identifiers by ID.
+    inline const symbol KEYWORD_PROC = global_interner.intern("proc");
+    inline const symbol KEYWORD_MODULE = global_interner.intern("module");
+    inline const symbol KEYWORD_IMPORT = global_interner.intern("import");
+    inline const symbol KEYWORD_RETURN = global_interner.intern("return");
+    inline const symbol KEYWORD_MUT = global_interner.intern("mut");
+    inline const symbol KEYWORD_CONST = global_interner.intern("const");
+
     /*
     struct value_t;
     struct procedure_t
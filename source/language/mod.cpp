@@ -4,24 +4,49 @@
 
 namespace masonc
 {
-    void initialize_module_scope_template()
+    static scope BUILTIN_SCOPE;
+
+    void initialize_builtin_scope()
+    {
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_VOID));
+
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_BOOL));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_CHAR));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_U8));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_S8));
+
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_U16));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_S16));
+
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_U32));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_S32));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_F32));
+
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_U64));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_S64));
+        BUILTIN_SCOPE.add_symbol(global_interner.intern(TYPE_F64));
+    }
+
+    const scope& builtin_scope()
     {
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_VOID);
+        return BUILTIN_SCOPE;
+    }
 
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_BOOL);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_CHAR);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_U8);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_S8);
+    u64 mod::add_import(std::string_view name)
+    {
+        module_imports.push_back(global_interner.intern(name));
 
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_U16);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_S16);
+        return module_import_names.copy_back(name.data(),
+            static_cast<u16>(name.length()));
+    }
 
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_U32);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_S32);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_F32);
+    scope& mod::module_scope()
+    {
+        return scopes[MODULE_SCOPE_HANDLE];
+    }
 
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_U64);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_S64);
-        MODULE_SCOPE_TEMPLATE.add_symbol(TYPE_F64);
+    const scope& mod::module_scope() const
+    {
+        return scopes[MODULE_SCOPE_HANDLE];
     }
 }
\ No newline at end of file
@@ -4,19 +4,36 @@
 #include <scope.hpp>
 #include <containers.hpp>
 
+#include <vector>
+#include <string_view>
+
 namespace masonc
 {
-    inline scope MODULE_SCOPE_TEMPLATE;
+    // Insert language-defined types into the scope returned by "builtin_scope".
+    // Must be called once before any module is parsed.
+    void initialize_builtin_scope();
 
-    // Insert language-defined types into "MODULE_SCOPE_TEMPLATE".
-    void initialize_module_scope_template();
+    // Scope of the language-defined types, which is the parent of every module scope.
+    // It is read-only after "initialize_builtin_scope", so any number of parser threads can share it.
+    const scope& builtin_scope();
 
     struct mod
     {
         cstring_collection module_import_names;
 
-        scope module_scope = MODULE_SCOPE_TEMPLATE;
-        cstring_collection scope_names;
+        // Interned "module_import_names", at the same indices, so that modules can be looked up
+        // by their import without interning the name again.
+        std::vector<symbol> module_imports;
+
+        // Adds an import of the module "name" and returns its index.
+        u64 add_import(std::string_view name);
+
+        // Every scope of the module, see "scope_handle". The module scope starts out empty,
+        // language-defined types are found through "builtin_scope".
+        std::vector<scope> scopes = { scope{} };
+
+        scope& module_scope();
+        const scope& module_scope() const;
     };
 }
 
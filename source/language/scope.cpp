@@ -9,9 +9,14 @@
 
 namespace masonc
 {
-    scope_index scope::index()
+    scope_handle scope::handle() const
     {
-        return m_index;
+        return m_handle;
+    }
+
+    std::optional<scope_handle> scope::parent() const
+    {
+        return m_parent;
     }
 
     const mod& scope::get_module()
@@ -22,55 +27,36 @@ namespace masonc
     const char* scope::name()
     {
         if (name_handle)
-            return m_module->scope_names.at(name_handle.value());
+            return global_interner.at(name_handle.value()).data();
         else
             return nullptr;
     }
 
-    void scope::set_name(const char* name, u16 name_length)
+    void scope::set_name(symbol name)
     {
         if (name_handle)
             return;
 
-        name_handle = m_module->scope_names.copy_back(name, name_length);
+        name_handle = name;
     }
 
-    // TODO: Instead of doing this, just keep a vector of pointers to parents in the scope.
-    std::vector<scope*> scope::parents()
+    void scope::set_module(mod* module)
     {
-        scope* current_scope = &m_module->module_scope;
-        std::vector<scope*> parents = { current_scope };
-
-        for (u64 i = 0; i < m_index.size(); i += 1) {
-            current_scope = &current_scope->children[m_index[i]];
-            parents.push_back(current_scope);
-        }
-
-        return parents;
+        m_module = module;
     }
 
-    scope_index scope::add_child(const scope& child)
+    scope_handle scope::add_child(scope child)
     {
-        u64 added_child_index = children.size();
-        scope* added_child = &children.emplace_back(child);
+        mod* module = m_module;
 
-        added_child->m_index = m_index;
-        added_child->m_index.push_back(added_child_index);
+        child.m_handle = static_cast<scope_handle>(module->scopes.size());
+        child.m_parent = m_handle;
+        child.m_module = module;
 
-        added_child->m_module = m_module;
+        // May move this scope, so nothing of it is used afterwards.
+        module->scopes.push_back(std::move(child));
 
-        return added_child->m_index;
-    }
-
-    scope* scope::get_child(const scope_index& index)
-    {
-        scope* child = this;
-
-        for (u64 i = child->m_index.size(); i < index.size(); i += 1) {
-            child = &child->children[index[i]];
-        }
-
-        return child;
+        return module->scopes.back().m_handle;
     }
 
     bool scope::add_symbol(symbol element)
@@ -78,34 +64,57 @@ namespace masonc
         if (is_symbol_defined(element))
             return false;
 
+        // Module scopes do not hold language-defined types, but they must not be redefined either.
+        if (!m_parent && this != &builtin_scope() && builtin_scope().is_symbol_defined(element))
+            return false;
+
         symbols.insert(element);
 
         return true;
     }
 
-    bool scope::find_symbol(symbol element, u64 offset)
+    bool scope::remove_symbol(symbol element)
     {
-        auto parent_scopes = parents();
+        return symbols.erase(element) > 0;
+    }
 
-        // TODO: Look at imported modules as well.
+    bool scope::find_symbol(symbol element, u64 offset) const
+    {
+        const scope* current_scope = this;
 
-        if (parent_scopes.size() <= offset)
-            return false;
+        for (u64 i = 0; i < offset; i += 1) {
+            current_scope = current_scope->enclosing_scope();
 
-        for (u64 i = parent_scopes.size() - offset; i >= 0; i -= 1) {
-            scope* current_parent_scope = parent_scopes[i];
-            auto symbol_search = current_parent_scope->symbols.find(element);
+            if (!current_scope)
+                return false;
+        }
+
+        // Imported modules are not searched here, see "symbol_table::find_imported".
 
-            if (symbol_search != current_parent_scope->symbols.end())
+        while (current_scope) {
+            if (current_scope->is_symbol_defined(element))
                 return true;
+
+            current_scope = current_scope->enclosing_scope();
         }
 
         return false;
     }
 
-    bool scope::is_symbol_defined(symbol element)
+    bool scope::is_symbol_defined(symbol element) const
     {
         return (symbols.find(element) != symbols.end());
         //return (symbols_lookup.find(element) != symbols_lookup.end());
     }
+
+    const scope* scope::enclosing_scope() const
+    {
+        if (m_parent)
+            return &m_module->scopes[m_parent.value()];
+
+        if (this == &builtin_scope())
+            return nullptr;
+
+        return &builtin_scope();
+    }
 }
\ No newline at end of file
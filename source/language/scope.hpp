@@ -6,15 +6,14 @@
 #include <symbol.hpp>
 #include <containers.hpp>
 
-#include <vector>
 #include <optional>
 
 namespace masonc
 {
-    // Indices on each level of the scope tree, starting at the module scope
-    // which is an empty vector. The first element refers to a scope at the first level,
-    // e.g. a top-level function scope, and it goes deeper with each subsequent index.
-    using scope_index = std::vector<u64>;
+    // Index of a scope in "mod::scopes". The module scope is always the first one.
+    using scope_handle = u32;
+
+    constexpr scope_handle MODULE_SCOPE_HANDLE = 0;
 
     namespace parser
     {
@@ -23,11 +22,18 @@ namespace masonc
 
     struct mod;
 
+    // The scopes of a module are stored next to each other in "mod::scopes" and refer to
+    // their parent by handle, so getting a scope is an index and walking up to the module scope
+    // neither allocates nor starts over at the top.
     struct scope
     {
         friend masonc::parser::parser_instance;
 
-        scope_index index();
+        scope_handle handle() const;
+
+        // Scope that this scope is defined in, empty for the module scope
+        // (whose parent is "builtin_scope", which is not part of any module).
+        std::optional<scope_handle> parent() const;
 
         // Module in which this scope is defined.
         const mod& get_module();
@@ -37,41 +43,47 @@ namespace masonc
 
         // If this scope already has a name, this function does nothing.
         // Otherwise, give it a name.
-        void set_name(const char* name, u16 name_length);
+        void set_name(symbol name);
 
-        // Retrieve this scope's parents ordered from top to bottom (module scope until this scope).
-        std::vector<scope*> parents();
+        // Only needed for module scopes, "add_child" sets the module of other scopes.
+        void set_module(mod* module);
 
-        // Add and initialize a child scope, and return a copy of its "scope_index".
-        scope_index add_child(const scope& child);
-        scope* get_child(const scope_index& index);
+        // Add "child" to the scopes of the module and return its handle.
+        // References to scopes of the module are invalidated, because they may move.
+        scope_handle add_child(scope child);
 
-        // Returns false if the symbol is already defined in this scope.
+        // Returns false if the symbol is already defined in this scope,
+        // or if this is a module scope and the symbol is a language-defined type.
         bool add_symbol(symbol element);
 
-        // Search for a symbol from bottom to top (this scope until module scope),
-        // including search in all imported modules.
+        // Returns false if the symbol is not defined in this scope.
+        bool remove_symbol(symbol element);
+
+        // Search for a symbol from bottom to top (this scope until "builtin_scope").
+        // Symbols of imported modules are found through "symbol_table".
         // "offset" can be used to skip a number of scopes from the bottom.
-        bool find_symbol(symbol element, u64 offset = 0);
+        bool find_symbol(symbol element, u64 offset = 0) const;
 
     private:
         // Usually set by "add_child".
-        scope_index m_index;
+        scope_handle m_handle = MODULE_SCOPE_HANDLE;
+        std::optional<scope_handle> m_parent;
 
         // Module in which this scope is defined.
         // Usually set by "add_child", unless this is a top-level module scope.
-        mod* m_module;
+        mod* m_module = nullptr;
 
         // Variable names, function names, type names, and so on.
-        cstring_unordered_set symbols;
+        robin_hood::unordered_flat_set<symbol> symbols;
 
-        std::vector<scope> children;
-
-        // Optional name handle for named scopes.
-        std::optional<symbol_handle> name_handle;
+        // Optional name for named scopes.
+        std::optional<symbol> name_handle;
 
         // Whether or not a specific symbol is defined in this scope.
-        bool is_symbol_defined(symbol element);
+        bool is_symbol_defined(symbol element) const;
+
+        // Scope that this scope is defined in, or null if this is "builtin_scope".
+        const scope* enclosing_scope() const;
     };
 }
 
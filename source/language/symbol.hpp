@@ -2,11 +2,14 @@
 #define MASONC_SYMBOL_HPP
 
 #include <common.hpp>
+#include <interner.hpp>
 
 namespace masonc
 {
-    using symbol = const char*;
-    using symbol_handle = u64;
+    // Names are interned into "global_interner" by the lexer,
+    // so a symbol is simply the "string_id" of its name.
+    using symbol = string_id;
+    using symbol_handle = symbol;
 }
 
 #endif
\ No newline at end of file
@@ -2,13 +2,15 @@
 #define MASONC_TYPE_HPP
 
 #include <common.hpp>
+#include <interner.hpp>
 
 #include <string>
 
 namespace masonc
 {
     using type = const char*;
-    using type_handle = u64;
+    // "string_id" of the type name.
+    using type_handle = string_id;
 
     // Types defined and built into the programming language.
     inline const type TYPE_VOID = "void";
@@ -7,6 +7,9 @@
 #include <string>
 #include <iostream>
 #include <optional>
+#include <algorithm>
+#include <limits>
+#include <thread>
 
 namespace masonc::lexer
 {
@@ -37,7 +40,7 @@ namespace masonc::lexer
 
     bool is_space(char c)
     {
-        return (c == ' ' || c == '\n' || c == '\t');
+        return classify(c) == CHAR_SPACE;
     }
 
     std::string get_composed_token(token_type type)
@@ -54,22 +57,159 @@ namespace masonc::lexer
         return "";
     }
 
-    std::optional<char> lexer_instance::get_char()
+    std::string_view lexer_instance_output::identifier_at(u64 index) const
     {
-        char c = this->input[this->char_index];
-        if(c == '\0')
-            return std::optional<char>{};
+        return global_interner.at(static_cast<string_id>(index));
+    }
+
+    std::string_view lexer_instance_output::integer_at(u64 index) const
+    {
+        const source_span& span = integers[index];
+        return std::string_view{ input + span.offset, span.length };
+    }
+
+    std::string_view lexer_instance_output::decimal_at(u64 index) const
+    {
+        const source_span& span = decimals[index];
+        return std::string_view{ input + span.offset, span.length };
+    }
+
+    std::string_view lexer_instance_output::string_at(u64 index) const
+    {
+        const string_value& value = strings[index];
+
+        if (value.escaped_index) {
+            return std::string_view{ escaped_strings.at(value.escaped_index.value()),
+                escaped_strings.length_at(value.escaped_index.value()) };
+        }
+
+        return std::string_view{ input + value.span.offset, value.span.length };
+    }
+
+    u64 lexer_instance_output::token_count() const
+    {
+        return token_types.size();
+    }
+
+    token lexer_instance_output::token_at(u64 token_index) const
+    {
+        return token{ token_values[token_index], token_types[token_index] };
+    }
+
+    token_location lexer_instance_output::location_at(u64 token_index) const
+    {
+        return location_of(token_offsets[token_index], token_end(token_index));
+    }
+
+    token_location lexer_instance_output::location_of(u64 start, u64 end) const
+    {
+        if (line_starts.empty())
+            build_line_starts();
+
+        // Index of the last line that starts at or before the offsets.
+        u64 start_line = static_cast<u64>(
+            std::upper_bound(line_starts.begin(), line_starts.end(), start) - line_starts.begin()) - 1;
+
+        u64 end_line = static_cast<u64>(
+            std::upper_bound(line_starts.begin(), line_starts.end(), end) - line_starts.begin()) - 1;
+
+        return token_location{
+            start_line + 1,
+            column_of(line_starts[start_line], start),
+            column_of(line_starts[end_line], end)
+        };
+    }
 
-        if (c == '\n') {
-            line_number += 1;
-            this->column_number = 1;
+    u64 lexer_instance_output::hash_tokens(u64 first_token, u64 token_count) const
+    {
+        u64 hash = 0;
+
+        for (u64 i = first_token; i < first_token + token_count; i += 1) {
+            u64 value_hash;
+
+            switch (token_types[i]) {
+                default:
+                    value_hash = 0;
+                    break;
+                case TOKEN_IDENTIFIER:
+                    value_hash = token_values[i];
+                    break;
+                case TOKEN_INTEGER:
+                    value_hash = robin_hood::hash<std::string_view>{}(integer_at(token_values[i]));
+                    break;
+                case TOKEN_DECIMAL:
+                    value_hash = robin_hood::hash<std::string_view>{}(decimal_at(token_values[i]));
+                    break;
+                case TOKEN_STRING:
+                    value_hash = robin_hood::hash<std::string_view>{}(string_at(token_values[i]));
+                    break;
+            }
+
+            // One multiply per token, the types and values are mixed once more at the end.
+            value_hash ^= static_cast<u64>(static_cast<u8>(token_types[i])) << 56;
+            hash = ((hash << 5) | (hash >> 59)) ^ value_hash;
+            hash *= 0x517cc1b727220a95;
         }
-        else if(c == '\t') {
-            this->column_number += this->tab_size;
+
+        return robin_hood::hash_int(hash);
+    }
+
+    void lexer_instance_output::build_line_starts() const
+    {
+        const scanner& line_scanner = active_scanner();
+        line_starts.push_back(0);
+
+        u64 index = line_scanner.find_line_end(input, 0, input_size);
+        while (index < input_size && input[index] == '\n') {
+            line_starts.push_back(static_cast<u32>(index + 1));
+            index = line_scanner.find_line_end(input, index + 1, input_size);
         }
-        else {
-            this->column_number += 1;
+    }
+
+    u64 lexer_instance_output::column_of(u64 line_start, u64 offset) const
+    {
+        u64 column = 1;
+
+        for (u64 i = line_start; i < offset; i += 1) {
+            if (input[i] == '\t')
+                column += tab_size;
+            else
+                column += 1;
+        }
+
+        return column;
+    }
+
+    u64 lexer_instance_output::token_end(u64 token_index) const
+    {
+        u64 offset = token_offsets[token_index];
+
+        switch (token_types[token_index]) {
+            default:
+                return offset;
+            case TOKEN_IDENTIFIER:
+                return offset + identifier_at(token_values[token_index]).length() - 1;
+            case TOKEN_INTEGER:
+                return offset + integers[token_values[token_index]].length - 1;
+            case TOKEN_DECIMAL:
+                return offset + decimals[token_values[token_index]].length - 1;
+            case TOKEN_STRING: {
+                // The closing '"'.
+                const source_span& span = strings[token_values[token_index]].span;
+                return span.offset + span.length;
+            }
+            case TOKEN_DOUBLECOLON:
+            case TOKEN_RIGHT_POINTER:
+                return offset + 1;
         }
+    }
+
+    std::optional<char> lexer_instance::get_char()
+    {
+        if (is_end(this->char_index))
+            return std::optional<char>{};
+
+        char c = this->input[this->char_index];
 
         this->char_index += 1;
         return std::optional<char>{ c };
@@ -77,83 +217,509 @@ namespace masonc::lexer
 
     std::optional<char> lexer_instance::peek_char()
     {
-        char c = this->input[this->char_index];
-        if(c == '\0')
+        if (is_end(this->char_index))
             return std::optional<char>{};
 
+        char c = this->input[this->char_index];
+
         return std::optional<char>{ c };
     }
 
-    void lexer_instance::add_identifier(const std::string& identifier, u64 start_column, u64 end_column)
+    void lexer_instance::add_token(s8 type, u32 value_index, u64 offset)
+    {
+        this->output->token_types.push_back(type);
+        this->output->token_values.push_back(value_index);
+        this->output->token_offsets.push_back(static_cast<u32>(offset));
+    }
+
+    void lexer_instance::add_identifier(u64 offset, u64 length)
     {
-        token tok = { this->output->identifiers.size(), TOKEN_IDENTIFIER };
-        token_location location = { this->line_number, start_column, end_column };
+        std::string_view identifier{ this->input + offset, length };
+        string_id id;
 
-        this->output->tokens.push_back(tok);
-        this->output->locations.push_back(location);
-        this->output->identifiers.copy_back(identifier);
+        auto find_it = interned_identifiers.find(identifier);
+        if (find_it != interned_identifiers.end()) {
+            id = find_it->second;
+        }
+        else {
+            id = global_interner.intern(identifier);
+            interned_identifiers.emplace(global_interner.at(id), id);
+        }
+
+        add_token(TOKEN_IDENTIFIER, id, offset);
     }
 
-    void lexer_instance::add_number(const std::string& number, bool dot, u64 start_column, u64 end_column)
+    void lexer_instance::add_number(u64 offset, u64 length, bool dot)
     {
         if (dot) {
-            if (number.back() == '.') {
+            if (this->input[offset + length - 1] == '.') {
                 // Error
-                token_location error_location{ this->line_number, this->char_index, this->char_index };
-                output->messages.report_error(
-                    "Expected digit after \".\" in decimal.",
-                    build_stage::LEXER,
-                    error_location
-                );
-
+                report_error("Expected digit after \".\" in decimal.", offset, offset + length - 1);
                 return;
             }
 
-            token tok = { this->output->decimals.size(), TOKEN_DECIMAL };
-            this->output->tokens.push_back(tok);
-            this->output->decimals.copy_back(number);
+            add_token(TOKEN_DECIMAL, static_cast<u32>(this->output->decimals.size()), offset);
+            this->output->decimals.push_back(source_span{ offset, length });
         }
         else {
-            token tok = { this->output->integers.size(), TOKEN_INTEGER };
-            this->output->tokens.push_back(tok);
-            this->output->integers.copy_back(number);
+            add_token(TOKEN_INTEGER, static_cast<u32>(this->output->integers.size()), offset);
+            this->output->integers.push_back(source_span{ offset, length });
         }
+    }
 
-        token_location location = { this->line_number, start_column, end_column };
-        this->output->locations.push_back(location);
+    void lexer_instance::report_error(const std::string& msg, u64 start, u64 end)
+    {
+        output->messages.report_error(msg, build_stage::LEXER, this->output->location_of(start, end));
     }
 
     void lexer_instance::tokenize(const char* input, u64 input_size, lexer_instance_output* output, u8 tab_size)
     {
         // Reset the lexer.
-        prepare(input, input_size, output, tab_size);
+        prepare(input, input_size, 0, input_size, output, tab_size);
+        reserve_tokens(input_size);
+
+        if (input_size >= parallel_min_input_size) {
+            u64 chunk_count = parallel_chunk_count;
+            if (chunk_count == 0)
+                chunk_count = static_cast<u64>(std::thread::hardware_concurrency());
+
+            if (chunk_count > 1) {
+                analyze_parallel(chunk_count);
+                return;
+            }
+        }
 
         // Do the actual work.
-        return analyze();
+        analyze();
+    }
+
+    // Replaces "removed_count" values at "index" with all of "inserted".
+    template <typename value_t>
+    static void splice(std::vector<value_t>& values, u64 index, u64 removed_count,
+        const std::vector<value_t>& inserted)
+    {
+        if (inserted.size() > removed_count)
+            values.insert(values.begin() + index + removed_count, inserted.size() - removed_count, value_t{});
+        else
+            values.erase(values.begin() + index + inserted.size(), values.begin() + index + removed_count);
+
+        std::copy(inserted.begin(), inserted.end(), values.begin() + index);
+    }
+
+    token_edit lexer_instance::retokenize(const char* input, u64 input_size, lexer_instance_output* output,
+        const input_edit& edit)
+    {
+        assume(edit.offset + edit.removed_length <= output->input_size, "\"edit\" exceeds the previous input");
+        assume(edit.offset + edit.inserted_length <= input_size, "\"edit\" exceeds the input");
+
+        const u64 old_token_count = output->token_count();
+
+        // An error might have stopped lexing, so tokens after it are unknown.
+        if (output->messages.errors.size() > 0) {
+            u8 tab_size = output->tab_size;
+
+            *output = lexer_instance_output{};
+            tokenize(input, input_size, output, tab_size);
+
+            return token_edit{ 0, old_token_count, output->token_count() };
+        }
+
+        const std::vector<u32>& offsets = output->token_offsets;
+        const s64 shift = static_cast<s64>(edit.inserted_length) - static_cast<s64>(edit.removed_length);
+
+        // Start at the last token before the edit, the edit might continue it.
+        // Everything before that token is tokenized the same as before.
+        u64 first_token = static_cast<u64>(
+            std::lower_bound(offsets.begin(), offsets.end(), edit.offset) - offsets.begin());
+
+        u64 begin = 0;
+        if (first_token > 0) {
+            first_token -= 1;
+            begin = offsets[first_token];
+        }
+
+        // The first old token that begins after the removed characters.
+        u64 end_token = static_cast<u64>(std::lower_bound(offsets.begin() + first_token, offsets.end(),
+            edit.offset + edit.removed_length) - offsets.begin());
+
+        lexer_instance_output region;
+        prepare(input, input_size, begin, input_size, &region, output->tab_size);
+
+        // Lexing both inputs from the start of the same unchanged characters gives the same tokens,
+        // so once the new tokens get to where an old token begins, the rest is already known.
+        while (true) {
+            if (end_token == old_token_count) {
+                this->stop_offset = std::numeric_limits<u64>::max();
+                analyze();
+                break;
+            }
+
+            this->stop_offset = static_cast<u64>(static_cast<s64>(offsets[end_token]) + shift);
+            this->stopped = false;
+            analyze();
+
+            if (!this->stopped) {
+                // Lexing reached the end or stopped at an error, no old token is left to keep.
+                end_token = old_token_count;
+                break;
+            }
+
+            if (this->char_index == this->stop_offset)
+                break;
+
+            // A new token covers the beginning of the old one, try the next old token after it.
+            end_token = static_cast<u64>(std::lower_bound(offsets.begin() + end_token, offsets.end(),
+                static_cast<u64>(static_cast<s64>(this->char_index) - shift)) - offsets.begin());
+        }
+
+        this->stop_offset = std::numeric_limits<u64>::max();
+        this->output = output;
+
+        // Kept tokens after the edit moved by "shift" characters, and so did their values.
+        for (u64 i = end_token; i < old_token_count; i += 1) {
+            output->token_offsets[i] = static_cast<u32>(static_cast<s64>(output->token_offsets[i]) + shift);
+
+            u32 value_index = output->token_values[i];
+
+            switch (output->token_types[i]) {
+                default:
+                    break;
+                case TOKEN_INTEGER:
+                    output->integers[value_index].offset += shift;
+                    break;
+                case TOKEN_DECIMAL:
+                    output->decimals[value_index].offset += shift;
+                    break;
+                case TOKEN_STRING:
+                    output->strings[value_index].span.offset += shift;
+                    break;
+            }
+        }
+
+        // New values are appended, so that the indices of kept values stay the same.
+        const u32 integers_base = static_cast<u32>(output->integers.size());
+        const u32 decimals_base = static_cast<u32>(output->decimals.size());
+        const u32 strings_base = static_cast<u32>(output->strings.size());
+
+        for (u64 i = 0; i < region.token_count(); i += 1) {
+            switch (region.token_types[i]) {
+                default:
+                    break;
+                case TOKEN_INTEGER:
+                    region.token_values[i] += integers_base;
+                    break;
+                case TOKEN_DECIMAL:
+                    region.token_values[i] += decimals_base;
+                    break;
+                case TOKEN_STRING:
+                    region.token_values[i] += strings_base;
+                    break;
+            }
+        }
+
+        output->integers.insert(output->integers.end(), region.integers.begin(), region.integers.end());
+        output->decimals.insert(output->decimals.end(), region.decimals.begin(), region.decimals.end());
+
+        for (string_value value : region.strings) {
+            if (value.escaped_index) {
+                u64 escaped_index = value.escaped_index.value();
+                value.escaped_index = output->escaped_strings.copy_back(
+                    region.escaped_strings.at(escaped_index), region.escaped_strings.length_at(escaped_index));
+            }
+
+            output->strings.push_back(value);
+        }
+
+        const u64 removed_count = end_token - first_token;
+
+        splice(output->token_types, first_token, removed_count, region.token_types);
+        splice(output->token_values, first_token, removed_count, region.token_values);
+        splice(output->token_offsets, first_token, removed_count, region.token_offsets);
+
+        output->input = input;
+        output->input_size = input_size;
+        output->line_starts.clear();
+
+        // Only errors, which there were none of before.
+        output->messages.errors = std::move(region.messages.errors);
+
+        return token_edit{ first_token, removed_count, region.token_count() };
+    }
+
+    void lexer_instance::set_scanner(const scanner& character_scanner)
+    {
+        this->character_scanner = &character_scanner;
     }
 
-    void lexer_instance::prepare(const char* input, u64 input_size, lexer_instance_output* output, u8 tab_size)
+    void lexer_instance::set_parallel_lexing(u64 min_input_size, u64 chunk_count)
+    {
+        this->parallel_min_input_size = min_input_size;
+        this->parallel_chunk_count = chunk_count;
+    }
+
+    void lexer_instance::prepare(const char* input, u64 input_size, u64 begin, u64 end,
+        lexer_instance_output* output, u8 tab_size)
     {
         this->input = input;
+        this->input_size = end;
         this->output = output;
-        this->tab_size = tab_size;
 
-        this->char_index = 0;
-        this->line_number = 1;
-        this->column_number = 1;
+        assume(input_size <= std::numeric_limits<u32>::max(), "\"input_size\" exceeds size of \"u32\"");
+
+        // Offsets and locations always refer to the whole input.
+        output->input = input;
+        output->input_size = input_size;
+        output->tab_size = tab_size;
+
+        this->char_index = begin;
+    }
 
+    void lexer_instance::reserve_tokens(u64 character_count)
+    {
         try {
             // Guess how many characters will end up being 1 token on average to avoid reallocations.
-            const u64 characters_per_token_guess = input_size / 3 + 32;
+            const u64 characters_per_token_guess = character_count / 3 + 32;
 
-            output->tokens.reserve(characters_per_token_guess);
-            output->locations.reserve(characters_per_token_guess);
+            output->token_types.reserve(characters_per_token_guess);
+            output->token_values.reserve(characters_per_token_guess);
+            output->token_offsets.reserve(characters_per_token_guess);
         }
         catch (...) {
             global_logger.log_error("Could not reserve space for token vector");
         }
     }
 
+    void lexer_instance::analyze_parallel(u64 chunk_count)
+    {
+        std::vector<u64> bounds = find_chunk_bounds(chunk_count);
+        chunk_count = bounds.size() - 1;
+
+        // No safe place to split the input at.
+        if (chunk_count < 2) {
+            analyze();
+            return;
+        }
+
+        if (chunk_lexers.size() < chunk_count)
+            chunk_lexers.resize(chunk_count);
+
+        std::vector<lexer_instance_output> chunk_outputs(chunk_count);
+
+        // Whether a chunk was tokenized up until its end. If not, lexing stopped at an error
+        // or a null terminator and everything after that chunk has to be dropped.
+        std::vector<u8> chunks_completed(chunk_count, 0);
+
+        auto tokenize_chunk = [&](u64 i) {
+            lexer_instance& chunk_lexer = chunk_lexers[i];
+
+            chunk_lexer.character_scanner = this->character_scanner;
+            chunk_lexer.prepare(this->input, this->input_size, bounds[i], bounds[i + 1],
+                &chunk_outputs[i], this->output->tab_size);
+            chunk_lexer.reserve_tokens(bounds[i + 1] - bounds[i]);
+
+            chunk_lexer.analyze();
+            chunks_completed[i] = chunk_lexer.char_index >= bounds[i + 1];
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(chunk_count - 1);
+
+        for (u64 i = 1; i < chunk_count; i += 1) {
+            threads.emplace_back(tokenize_chunk, i);
+        }
+
+        tokenize_chunk(0);
+
+        for (u64 i = 0; i < threads.size(); i += 1) {
+            threads[i].join();
+        }
+
+        for (u64 i = 0; i < chunk_count; i += 1) {
+            append_chunk(chunk_outputs[i]);
+
+            if (!chunks_completed[i])
+                break;
+        }
+    }
+
+    std::vector<u64> lexer_instance::find_chunk_bounds(u64 chunk_count) const
+    {
+        std::vector<u64> bounds{ 0 };
+
+        // Aim for chunks of the same size.
+        u64 target = this->input_size / chunk_count;
+        u64 index = 0;
+
+        while (bounds.size() < chunk_count) {
+            // Characters up until "special" are neither inside a string nor a comment,
+            // so any newline among them is a safe place to split at.
+            u64 special = character_scanner->find_string_or_comment(this->input, index, this->input_size);
+
+            while (bounds.size() < chunk_count && target < special) {
+                u64 line_end = character_scanner->find_line_end(this->input, std::max(index, target), special);
+                if (line_end >= special || line_end + 1 >= this->input_size)
+                    break;
+
+                bounds.push_back(line_end + 1);
+                target = std::max(this->input_size * bounds.size() / chunk_count, line_end + 1);
+            }
+
+            if (is_end(special))
+                break;
+
+            index = special + 1;
+
+            if (this->input[special] == '"') {
+                index = skip_string(index);
+            }
+            else if (!is_end(index) && this->input[index] == '/') {
+                // Line comment, continue after the newline.
+                u64 line_end = character_scanner->find_line_end(this->input, index + 1, this->input_size);
+                index = is_end(line_end) ? this->input_size : line_end + 1;
+            }
+            else if (!is_end(index) && this->input[index] == '*') {
+                index = skip_block_comment(index + 1);
+            }
+
+            if (is_end(index))
+                break;
+        }
+
+        bounds.push_back(this->input_size);
+        return bounds;
+    }
+
+    u64 lexer_instance::skip_string(u64 index) const
+    {
+        while (true) {
+            index = character_scanner->find_string_special(this->input, index, this->input_size);
+            if (is_end(index))
+                return this->input_size;
+
+            char c = this->input[index];
+            index += 1;
+
+            if (c == '"')
+                return index;
+
+            if (c == ESCAPE_BEGIN) {
+                if (is_end(index))
+                    return this->input_size;
+
+                char sequence = this->input[index];
+                index += 1;
+
+                // An invalid escape sequence skips everything up until the next '"',
+                // but does not end the string.
+                if (!is_escape_sequence(sequence) && sequence != '"') {
+                    do {
+                        if (is_end(index))
+                            return this->input_size;
+
+                        c = this->input[index];
+                        index += 1;
+                    } while (c != '"');
+                }
+            }
+        }
+    }
+
+    u64 lexer_instance::skip_block_comment(u64 index) const
+    {
+        u64 nests = 1;
+
+        do {
+            index = character_scanner->find_block_comment_special(this->input, index, this->input_size);
+            if (is_end(index))
+                return this->input_size;
+
+            char c = this->input[index];
+            index += 1;
+
+            if (c == '/' || c == '*') {
+                if (is_end(index))
+                    return this->input_size;
+
+                if (c == '/' && this->input[index] == '*')
+                    nests += 1;
+                else if (c == '*' && this->input[index] == '/')
+                    nests -= 1;
+
+                // The character after either of them is always eaten.
+                index += 1;
+            }
+
+        } while (nests > 0);
+
+        return index;
+    }
+
+    bool lexer_instance::is_end(u64 index) const
+    {
+        return index >= this->input_size || this->input[index] == '\0';
+    }
+
+    void lexer_instance::append_chunk(const lexer_instance_output& chunk_output)
+    {
+        const u32 integers_base = static_cast<u32>(this->output->integers.size());
+        const u32 decimals_base = static_cast<u32>(this->output->decimals.size());
+        const u32 strings_base = static_cast<u32>(this->output->strings.size());
+        const u64 escaped_strings_base = this->output->escaped_strings.size();
+
+        for (u64 i = 0; i < chunk_output.token_count(); i += 1) {
+            s8 type = chunk_output.token_types[i];
+            u32 value_index = chunk_output.token_values[i];
+
+            // Identifiers are "string_id"s, which are the same for every chunk.
+            switch (type) {
+                default:
+                    break;
+                case TOKEN_INTEGER:
+                    value_index += integers_base;
+                    break;
+                case TOKEN_DECIMAL:
+                    value_index += decimals_base;
+                    break;
+                case TOKEN_STRING:
+                    value_index += strings_base;
+                    break;
+            }
+
+            // Offsets are relative to the whole input already.
+            add_token(type, value_index, chunk_output.token_offsets[i]);
+        }
+
+        this->output->integers.insert(this->output->integers.end(),
+            chunk_output.integers.begin(), chunk_output.integers.end());
+
+        this->output->decimals.insert(this->output->decimals.end(),
+            chunk_output.decimals.begin(), chunk_output.decimals.end());
+
+        for (u64 i = 0; i < chunk_output.escaped_strings.size(); i += 1) {
+            this->output->escaped_strings.copy_back(chunk_output.escaped_strings.at(i),
+                chunk_output.escaped_strings.length_at(i));
+        }
+
+        for (string_value value : chunk_output.strings) {
+            if (value.escaped_index)
+                value.escaped_index = value.escaped_index.value() + escaped_strings_base;
+
+            this->output->strings.push_back(value);
+        }
+
+        const message_list& chunk_messages = chunk_output.messages;
+        message_list& messages = this->output->messages;
+
+        messages.messages.insert(messages.messages.end(),
+            chunk_messages.messages.begin(), chunk_messages.messages.end());
+
+        messages.warnings.insert(messages.warnings.end(),
+            chunk_messages.warnings.begin(), chunk_messages.warnings.end());
+
+        messages.errors.insert(messages.errors.end(),
+            chunk_messages.errors.begin(), chunk_messages.errors.end());
+    }
+
     void lexer_instance::analyze()
     {
         // Get the first character.
@@ -162,395 +728,360 @@ namespace masonc::lexer
             return;
 
         while (true) {
-            // Skip whitespace / newline etc.
-            while (is_space(char_result.value())) {
-                char_result = get_char();
-                if (!char_result)
-                    return;
+            // In between two tokens, "char_result" is the next character to look at.
+            if (this->char_index > this->stop_offset) {
+                this->char_index -= 1;
+                this->stopped = true;
+                return;
             }
 
-            // String
-            if(char_result.value() == '"') {
-                u64 string_start_column = this->column_number - 1;
-                std::string str;
-                char prev_char = char_result.value();
+            switch (classify(char_result.value())) {
+                case CHAR_END:
+                    return;
+
+                // Skip whitespace / newline etc.
+                case CHAR_SPACE: {
+                    this->char_index = character_scanner->skip_whitespace(this->input, this->char_index,
+                        this->input_size);
 
-                while(true) {
                     char_result = get_char();
-                    if(!char_result) {
-                        // Error
-                        token_location error_location{ this->line_number, string_start_column,
-                            this->column_number - 1 };
+                    if (!char_result)
+                        return;
 
-                        output->messages.report_error("Expected '\"'", build_stage::LEXER,
-                            error_location);
+                    continue;
+                }
 
-                        return;
-                    }
+                // String
+                case CHAR_QUOTE: {
+                    u64 string_start = this->char_index;
+
+                    // Only strings with escape sequences are copied,
+                    // all others are used straight from the input.
+                    bool escaped = false;
+                    std::string str;
+
+                    while(true) {
+                        u64 run_end = character_scanner->find_string_special(this->input, this->char_index,
+                            this->input_size);
 
-                    // Lex escape sequence.
-                    if(char_result.value() == ESCAPE_BEGIN) {
-                        u64 escape_start_column = this->column_number - 1;
+                        if (escaped)
+                            str.append(this->input + this->char_index, run_end - this->char_index);
+
+                        this->char_index = run_end;
 
                         char_result = get_char();
                         if(!char_result) {
                             // Error
-                            token_location error_location{ this->line_number, string_start_column,
-                                this->column_number - 1 };
-
-                            output->messages.report_error("Expected '\"'", build_stage::LEXER,
-                                error_location);
+                            report_error("Expected '\"'", string_start - 1, this->char_index - 1);
 
                             return;
                         }
 
-                        // TODO: Continue work here
-
-                        if(!is_escape_sequence(char_result.value()) && char_result.value() != '"') {
-                            // Error: Not valid escape sequence.
-                            token_location error_location{ this->line_number, escape_start_column,
-                                this->column_number - 1 };
+                        // Lex escape sequence.
+                        if(char_result.value() == ESCAPE_BEGIN) {
+                            u64 escape_start = this->char_index - 1;
 
-                            output->messages.report_error(
-                                "'\\"
-                                + std::string{ char_result.value() }
-                                + "' is not a valid escape sequence",
-                                build_stage::LEXER,
-                                error_location
-                            );
+                            if (!escaped) {
+                                // Copy everything before the first escape sequence.
+                                str.assign(this->input + string_start, this->char_index - 1 - string_start);
+                                escaped = true;
+                            }
 
-                            // Skip until end of string.
-                            do {
-                                char_result = get_char();
-                                if(!char_result) {
-                                    // Error
-                                    error_location = token_location{ this->line_number, string_start_column,
-                                        this->column_number - 1};
+                            char_result = get_char();
+                            if(!char_result) {
+                                // Error
+                                report_error("Expected '\"'", string_start - 1, this->char_index - 1);
 
-                                    output->messages.report_error(
-                                        "Expected '\"'",
-                                        build_stage::LEXER,
-                                        error_location
-                                    );
+                                return;
+                            }
 
-                                    return;
-                                }
+                            // TODO: Continue work here
 
-                            } while(char_result.value() != '"');
+                            if(!is_escape_sequence(char_result.value()) && char_result.value() != '"') {
+                                // Error: Not valid escape sequence.
+                                report_error(
+                                    "'\\"
+                                    + std::string{ char_result.value() }
+                                    + "' is not a valid escape sequence",
+                                    escape_start,
+                                    this->char_index - 1
+                                );
 
-                            // Successfully skipped string, lex the next token.
-                            continue;
-                        }
+                                // Skip until end of string.
+                                do {
+                                    char_result = get_char();
+                                    if(!char_result) {
+                                        // Error
+                                        report_error("Expected '\"'", string_start - 1, this->char_index - 1);
 
-                        char escape_char = get_escape_char(char_result.value());
-                        str.push_back(escape_char);
-                        prev_char = escape_char;
-                        continue;
-                    }
+                                        return;
+                                    }
 
-                    if(char_result.value() == '"')
-                        break;
+                                } while(char_result.value() != '"');
 
-                    str.push_back(char_result.value());
-                    prev_char = char_result.value();
-                }
+                                // Successfully skipped string, lex the next token.
+                                continue;
+                            }
 
-                token tok = { this->output->strings.size(), TOKEN_STRING };
+                            str.push_back(get_escape_char(char_result.value()));
+                            continue;
+                        }
 
-                token_location location = {
-                    this->line_number,
-                    string_start_column,
-                    this->column_number - 1
-                };
+                        if(char_result.value() == '"')
+                            break;
 
-                this->output->tokens.push_back(tok);
-                this->output->strings.copy_back(str);
-                this->output->locations.push_back(location);
+                        if (escaped)
+                            str.push_back(char_result.value());
+                    }
 
-                char_result = get_char();
-                if(!char_result)
-                    return;
+                    add_token(TOKEN_STRING, static_cast<u32>(this->output->strings.size()), string_start - 1);
 
-                // Done lexing constant string literal
-                continue;
-            }
+                    // The span ends before the closing '"'.
+                    string_value value{ source_span{ string_start, this->char_index - 1 - string_start }, std::nullopt };
 
-            // Identifier starting with an alpha character (a-z, A-Z) or underscore and
-            // further characters being alpha, underscores or numeric (0-9).
-            if (is_alpha(char_result.value())) //|| char_result.value() == '_')
-            {
-                u64 identifier_start_column = this->column_number - 1;
-                std::string identifier;
+                    if (escaped)
+                        value.escaped_index = this->output->escaped_strings.copy_back(str);
 
-                // Read the identifier.
-                do {
-                    identifier.push_back(char_result.value());
+                    this->output->strings.push_back(value);
 
                     char_result = get_char();
-                    if (!char_result) {
-                        // Add identifier as it is.
-                        add_identifier(identifier, identifier_start_column, this->column_number - 1);
+                    if(!char_result)
                         return;
-                    }
-
-                } while (is_alnum(char_result.value())); //|| char_result.value() == '_');
 
-                // TODO: Potentially check if it's a language-defined identifier.
-
-                // Done lexing identifier.
-                add_identifier(identifier, identifier_start_column, this->column_number - 1);
-                continue;
-            }
+                    // Done lexing constant string literal
+                    continue;
+                }
 
-            // Number (integer or decimal)
-            if (is_num(char_result.value())) {
-                u64 number_start_column = this->column_number - 1;
-                std::string number;
+                // Identifier starting with an alpha character (a-z, A-Z) or underscore and
+                // further characters being alpha, underscores or numeric (0-9).
+                case CHAR_ALPHA: {
+                    u64 identifier_start = this->char_index - 1;
 
-                // There can only be one "." in a decimal.
-                bool dot = false;
+                    // Read the identifier.
+                    this->char_index = character_scanner->skip_alnum(this->input, this->char_index,
+                        this->input_size);
 
-                // Read the number.
-                do {
-                    number.push_back(char_result.value());
+                    // TODO: Potentially check if it's a language-defined identifier.
 
+                    add_identifier(identifier_start, this->char_index - identifier_start);
                     char_result = get_char();
-                    if (!char_result) {
-                        // Add number as it is
-                        add_number(number, dot, number_start_column, this->column_number - 1);
+
+                    if (!char_result)
                         return;
-                    }
 
-                    if (char_result.value() == '.') {
-                        // A second dot in this number?
-                        if (dot) {
-                            // Error
-                            token_location error_location{ this->line_number, number_start_column,
-                                this->column_number - 1 };
+                    // Done lexing identifier.
+                    continue;
+                }
 
-                            output->messages.report_error(
-                                "Decimal contains two '.'",
-                                build_stage::LEXER,
-                                error_location
-                            );
+                // Number (integer or decimal)
+                case CHAR_DIGIT: {
+                    u64 number_start = this->char_index - 1;
 
-                            return;
-                        }
+                    // There can only be one "." in a decimal.
+                    bool dot = false;
 
-                        dot = true;
-                        number.push_back(char_result.value());
+                    // Read the number, one run of digits at a time.
+                    while (true) {
+                        this->char_index = character_scanner->skip_num(this->input, this->char_index,
+                            this->input_size);
+                        u64 number_end = this->char_index;
 
                         char_result = get_char();
                         if (!char_result) {
-                            // Add number as it is.
-                            add_number(number, dot, number_start_column, this->column_number - 1);
+                            // Add number as it is
+                            add_number(number_start, number_end - number_start, dot);
                             return;
                         }
-                    }
 
-                } while (is_num(char_result.value()));
+                        if (char_result.value() == '.') {
+                            // A second dot in this number?
+                            if (dot) {
+                                // Error
+                                report_error("Decimal contains two '.'", number_start, this->char_index - 1);
 
-                // Done lexing number.
-                add_number(number, dot, number_start_column, this->column_number - 1);
-                continue;
-            }
+                                return;
+                            }
 
-            // Comments
-            if (char_result.value() == '/') {
-                std::optional<char> peek_token_result = peek_char();
-                if (peek_token_result) {
-                    // Comment until end of line.
-                    if (peek_token_result.value() == '/') {
-                        // Eat the peeked token.
-                        get_char();
+                            dot = true;
+                            number_end = this->char_index;
 
-                        do {
                             char_result = get_char();
-                            if (!char_result)
+                            if (!char_result) {
+                                // Add number as it is.
+                                add_number(number_start, number_end - number_start, dot);
                                 return;
+                            }
 
-                        } while (char_result.value() != '\n');
-
-                        // Eat the "\n".
-                        char_result = get_char();
-                        if (!char_result)
-                            return;
+                            // Digits after the ".".
+                            if (is_num(char_result.value()))
+                                continue;
+                        }
 
-                        // Done lexing line comment.
-                        continue;
+                        // Done lexing number.
+                        add_number(number_start, number_end - number_start, dot);
+                        break;
                     }
 
-                    // Block comment
-                    if (peek_token_result.value() == '*') {
-                        // Eat the peeked token.
-                        get_char();
+                    continue;
+                }
+
+                // Comments
+                case CHAR_SLASH: {
+                    std::optional<char> peek_token_result = peek_char();
+                    if (peek_token_result) {
+                        // Comment until end of line.
+                        if (peek_token_result.value() == '/') {
+                            // Eat the peeked token.
+                            get_char();
 
-                        u64 nests = 1;
+                            this->char_index = character_scanner->find_line_end(this->input, this->char_index,
+                                this->input_size);
 
-                        do {
                             char_result = get_char();
                             if (!char_result)
                                 return;
 
-                            if (char_result.value() == '/') {
-                                peek_token_result = peek_char();
-                                if (!peek_token_result)
-                                    return;
-
-                                // Nested block comment.
-                                if (peek_token_result.value() == '*') {
-                                    nests += 1;
-                                }
+                            // Eat the "\n".
+                            char_result = get_char();
+                            if (!char_result)
+                                return;
 
-                                // Eat the peeked token.
-                                get_char();
-                            }
-                            else if (char_result.value() == '*') {
-                                peek_token_result = peek_char();
-                                if (!peek_token_result)
-                                    return;
+                            // Done lexing line comment.
+                            continue;
+                        }
 
-                                // End of a block comment.
-                                if (peek_token_result.value() == '/') {
-                                    nests -= 1;
-                                }
+                        // Block comment
+                        if (peek_token_result.value() == '*') {
+                            // Eat the peeked token.
+                            get_char();
 
-                                // Eat the peeked token.
-                                get_char();
-                            }
+                            u64 nests = 1;
 
-                        } while (nests > 0);
+                            do {
+                                this->char_index = character_scanner->find_block_comment_special(this->input,
+                                    this->char_index, this->input_size);
 
-                        char_result = get_char();
-                        if (!char_result)
-                            return;
+                                char_result = get_char();
+                                if (!char_result)
+                                    return;
 
-                        // Done lexing block comment(s).
-                        continue;
-                    }
-                }
-            }
+                                if (char_result.value() == '/') {
+                                    peek_token_result = peek_char();
+                                    if (!peek_token_result)
+                                        return;
 
-            // Composed tokens
-            u64 i = 0;
-            bool is_composed = false;
-            while (i < COMPOSED_TOKENS_LENGTH) {
-                if (char_result.value() == COMPOSED_TOKENS[i]) {
-                    // It could be a composed token.
+                                    // Nested block comment.
+                                    if (peek_token_result.value() == '*') {
+                                        nests += 1;
+                                    }
 
-                    std::optional<char> peek_token_result = peek_char();
-                    if (!peek_token_result) {
-                        // Not a composed token, create an ASCII token.
-                        token tok;
-                        tok.type = char_result.value();
+                                    // Eat the peeked token.
+                                    get_char();
+                                }
+                                else if (char_result.value() == '*') {
+                                    peek_token_result = peek_char();
+                                    if (!peek_token_result)
+                                        return;
+
+                                    // End of a block comment.
+                                    if (peek_token_result.value() == '/') {
+                                        nests -= 1;
+                                    }
+
+                                    // Eat the peeked token.
+                                    get_char();
+                                }
 
-                        token_location location = {
-                            this->line_number,
-                            this->column_number - 1,	// current token column
-                            this->column_number - 1
-                        };
+                            } while (nests > 0);
 
-                        this->output->tokens.push_back(tok);
-                        this->output->locations.push_back(location);
+                            char_result = get_char();
+                            if (!char_result)
+                                return;
 
-                        return;
+                            // Done lexing block comment(s).
+                            continue;
+                        }
                     }
 
-                    if (peek_token_result.value() == COMPOSED_TOKENS[i + 1]) {
-                        // It is a composed token.
-                        token tok;
-                        tok.type = COMPOSED_TOKEN_TYPES[i / 2];
+                    // Not a comment, lex "/" like any other character.
+                    [[fallthrough]];
+                }
+
+                default: {
+                    // Composed tokens
+                    s8 composed_type = composed_token_type(char_result.value(), this->input[this->char_index]);
 
-                        token_location location = {
-                            this->line_number,
-                            this->column_number - 1,	// current token column
-                            this->column_number			// peeked token column
-                        };
+                    if (composed_type != 0) {
+                        add_token(composed_type, 0, this->char_index - 1);
 
-                        this->output->tokens.push_back(tok);
-                        this->output->locations.push_back(location);
+                        // Eat the second character of the composed token.
+                        this->char_index += 1;
 
-                        // Eat the current token and the peeked token.
-                        get_char();
                         char_result = get_char();
                         if (!char_result)
                             return;
 
-                        is_composed = true;
-                        break;
+                        // Done lexing composed token.
+                        continue;
                     }
-                }
-
-                i += 2;
-            }
-
-            // Done lexing composed token.
-            if (is_composed)
-                continue;
-
-            // Otherwise just create an ASCII token.
-            token tok;
-            tok.type = char_result.value();
 
-            token_location location = {
-                this->line_number,
-                this->column_number - 1,	// current token column
-                this->column_number - 1
-            };
+                    // Otherwise just create an ASCII token.
+                    add_token(char_result.value(), 0, this->char_index - 1);
 
-            this->output->tokens.push_back(tok);
-            this->output->locations.push_back(location);
+                    char_result = get_char();
+                    if (!char_result)
+                        return;
 
-            char_result = get_char();
-            if (!char_result)
-                return;
+                    continue;
+                }
+            }
         }
     }
 
     void lexer_instance::print_tokens()
     {
-        for(u64 i = 0; i < output->tokens.size(); i += 1) {
-            token* current_token = &this->output->tokens[i];
-            token_location* location = &this->output->locations[i];
+        for(u64 i = 0; i < output->token_count(); i += 1) {
+            token current_token = this->output->token_at(i);
+            token_location location = this->output->location_at(i);
 
-            if(current_token->type < 0) {
-                switch(current_token->type) {
+            if(current_token.type < 0) {
+                switch(current_token.type) {
                     default:
                         std::cout << "Unknown Token" << std::endl;
                         break;
                     case TOKEN_IDENTIFIER:
-                        std::cout << "Identifier Token (l. " << location->line_number << "): " <<
-                                      this->output->identifiers.at(current_token->value_index) <<
+                        std::cout << "Identifier Token (l. " << location.line_number << "): " <<
+                                      this->output->identifier_at(current_token.value_index) <<
                                       std::endl;
                         break;
                     case TOKEN_INTEGER:
-                        std::cout << "Integer Token (l. " << location->line_number << "): " <<
-                                      this->output->integers.at(current_token->value_index) <<
+                        std::cout << "Integer Token (l. " << location.line_number << "): " <<
+                                      this->output->integer_at(current_token.value_index) <<
                                       std::endl;
                         break;
                     case TOKEN_DECIMAL:
-                        std::cout << "Decimal Token (l. " << location->line_number << "): " <<
-                                      this->output->decimals.at(current_token->value_index) <<
+                        std::cout << "Decimal Token (l. " << location.line_number << "): " <<
+                                      this->output->decimal_at(current_token.value_index) <<
                                       std::endl;
                         break;
                     case TOKEN_STRING:
-                        std::cout << "String Token (l. " << location->line_number << "): " <<
-                                      this->output->strings.at(current_token->value_index) <<
+                        std::cout << "String Token (l. " << location.line_number << "): " <<
+                                      this->output->string_at(current_token.value_index) <<
                                       std::endl;
                         break;
                     case TOKEN_DOUBLECOLON:
                     case TOKEN_RIGHT_POINTER:
-                        std::cout << "Composed Token (l. " << location->line_number << "): " <<
+                        std::cout << "Composed Token (l. " << location.line_number << "): " <<
                                       get_composed_token(
-                                          static_cast<token_type>(current_token->type)
+                                          static_cast<token_type>(current_token.type)
                                       ) <<
                                       std::endl;
                         break;
                 }
             }
             else {
-                std::cout << "ASCII Token (l. " << location->line_number << "): " <<
-                              static_cast<char>(current_token->type) << std::endl;
+                std::cout << "ASCII Token (l. " << location.line_number << "): " <<
+                              static_cast<char>(current_token.type) << std::endl;
             }
         }
     }
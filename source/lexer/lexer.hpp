@@ -6,11 +6,16 @@
 #include <logger.hpp>
 #include <message.hpp>
 #include <containers.hpp>
+#include <scanner.hpp>
+#include <interner.hpp>
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <array>
 #include <optional>
+#include <thread>
+#include <limits>
 
 namespace masonc::lexer
 {
@@ -26,10 +31,12 @@ namespace masonc::lexer
         TOKEN_RIGHT_POINTER = -6
     };
 
+    // A single token of the token stream, see "lexer_instance_output::token_at".
     struct token
     {
-        // Index of value if type is identifier, integer, decimal.
-        u64 value_index;
+        // Index of value if type is integer, decimal or string,
+        // or the "string_id" if type is identifier.
+        u32 value_index;
         s8 type;
     };
 
@@ -41,7 +48,7 @@ namespace masonc::lexer
         '-', '>'
     };
 
-    const token_type COMPOSED_TOKEN_TYPES[] =
+    constexpr token_type COMPOSED_TOKEN_TYPES[] =
     {
         TOKEN_DOUBLECOLON,
         TOKEN_RIGHT_POINTER
@@ -65,122 +72,337 @@ namespace masonc::lexer
 
     bool is_space(char c);
 
+    // Characters of a token value in the lexer input.
+    struct source_span
+    {
+        u64 offset;
+        u64 length;
+    };
+
+    struct string_value
+    {
+        // Span of the characters between the quotes in the lexer input.
+        source_span span;
+
+        // If the string contains escape sequences, index into "escaped_strings"
+        // where the string with resolved escape sequences is stored.
+        std::optional<u64> escaped_index;
+    };
+
+    // Change of an input: "removed_length" characters at byte offset "offset"
+    // were replaced by "inserted_length" characters.
+    struct input_edit
+    {
+        u64 offset;
+        u64 removed_length;
+        u64 inserted_length;
+    };
+
+    // Change of a token stream: "removed_count" tokens at index "first_token"
+    // were replaced by "inserted_count" tokens.
+    struct token_edit
+    {
+        u64 first_token;
+        u64 removed_count;
+        u64 inserted_count;
+    };
+
+    struct lexer_instance;
+
     struct lexer_instance_output
     {
-        std::vector<token> tokens;
+        friend lexer_instance;
+
+        // Input that was tokenized. Not owned, it has to outlive this output
+        // because token values are not copied but point into it.
+        const char* input = nullptr;
+        u64 input_size = 0;
+        u8 tab_size = 4;
+
+        // The token stream is split into one array per field so that the parser,
+        // which mostly looks at types, touches as little memory as possible.
+        // Use "token_count" and "token_at" to read tokens.
+        std::vector<s8> token_types;
+        std::vector<u32> token_values;
 
-        // Locations of tokens that might be needed for error reporting.
-        std::vector<token_location> locations;
+        // Byte offset of the first character of each token in "input".
+        // Line and column are only computed from it when a location is needed.
+        std::vector<u32> token_offsets;
 
-        cstring_collection identifiers;
-        cstring_collection integers;
-        cstring_collection decimals;
-        cstring_collection strings;
+        // Identifiers are interned into "global_interner" and their tokens' "value_index"
+        // is the "string_id", so no per-output storage is needed for them.
+        std::vector<source_span> integers;
+        std::vector<source_span> decimals;
+        std::vector<string_value> strings;
+
+        // The only token values that need storage of their own.
+        cstring_collection escaped_strings;
 
         message_list messages;
+
+        // Values are not null-terminated unless they are identifiers,
+        // assumes that the index is in range.
+        std::string_view identifier_at(u64 index) const;
+        std::string_view integer_at(u64 index) const;
+        std::string_view decimal_at(u64 index) const;
+        std::string_view string_at(u64 index) const;
+
+        u64 token_count() const;
+
+        // Assumes that the index is in range.
+        token token_at(u64 token_index) const;
+
+        // Both functions build the line-start table on the first call,
+        // which is why they must not be called from multiple threads at once.
+        //
+        // Location of a token, from its first to its last character.
+        token_location location_at(u64 token_index) const;
+
+        // Location of the characters from byte offset "start" to "end", both inclusive.
+        token_location location_of(u64 start, u64 end) const;
+
+        // Hash of the types and values of "token_count" tokens starting at "first_token".
+        // It does not depend on where the tokens are in the input, or on value indices.
+        u64 hash_tokens(u64 first_token, u64 token_count) const;
+
+    private:
+        // Byte offset of the first character of each line, built on demand.
+        mutable std::vector<u32> line_starts;
+
+        void build_line_starts() const;
+        u64 column_of(u64 line_start, u64 offset) const;
+
+        // Byte offset of the last character of a token.
+        u64 token_end(u64 token_index) const;
     };
 
+    // Inputs of at least this many characters are split into chunks that are tokenized in parallel.
+    constexpr u64 PARALLEL_LEXING_MIN_INPUT_SIZE = 1024 * 1024;
+
     struct lexer_instance
     {
         // 'input': Null-terminated string that will be split into tokens.
         // 'input_size': Number of characters in input.
         // 'output' is expected to be allocated and empty.
         // 'tab_size' should be set to get correct error message column numbers.
+        // 'input_size' must fit into 32 bits, token offsets are stored as "u32".
         //
         // This function can be called multiple times just fine.
         void tokenize(const char* input, u64 input_size, lexer_instance_output* output, u8 tab_size = 4);
 
+        // Updates "output", which holds the tokens of the input before "edit", to the edited "input".
+        // Only the characters from the last token before the edit up until the first token after it
+        // that comes out the same are tokenized, the tokens around them are kept.
+        // Returns which tokens were replaced.
+        //
+        // Values of kept tokens keep their indices, values of replaced tokens are left unused.
+        // If "output" has errors, everything is tokenized again and all tokens are replaced.
+        token_edit retokenize(const char* input, u64 input_size, lexer_instance_output* output,
+            const input_edit& edit);
+
+        // Use a specific scanner instead of "active_scanner()", mostly useful for testing.
+        void set_scanner(const scanner& character_scanner);
+
+        // Inputs of at least "min_input_size" characters are split into "chunk_count" chunks
+        // that are tokenized on separate threads. The output is the same as if the input
+        // was tokenized in one go.
+        // A "chunk_count" of 0 uses one chunk per hardware thread.
+        void set_parallel_lexing(u64 min_input_size, u64 chunk_count = 0);
+
         // Print all tokens for debug purposes.
         void print_tokens();
 
     private:
         const char* input;
+
+        // Where lexing stops, which is the end of the chunk when tokenizing in parallel.
+        u64 input_size;
+
         lexer_instance_output* output;
 
+        // Finds the end of whitespace, identifiers, numbers, strings and comments in bulk.
+        const scanner* character_scanner = &active_scanner();
+
+        // Identifiers this lexer has already interned, which spares most lookups
+        // from going through the locks of "global_interner".
+        // Keys point into the interner, so they stay valid across inputs.
+        robin_hood::unordered_flat_map<std::string_view, string_id> interned_identifiers;
+
         u64 char_index;
-        u64 line_number;
 
-        // The "column_number" always points to one column behind the last character.
-        u64 column_number;
+        // "analyze" returns in between two tokens once it got past this offset and sets "stopped",
+        // see "retokenize".
+        u64 stop_offset = std::numeric_limits<u64>::max();
+        bool stopped = false;
+
+        u64 parallel_min_input_size = PARALLEL_LEXING_MIN_INPUT_SIZE;
+        u64 parallel_chunk_count = 0;
+
+        // Lexers of the chunks, kept around so that their identifier caches stay warm.
+        std::vector<lexer_instance> chunk_lexers;
 
-        u8 tab_size;
+        // Resets the lexer to tokenize the characters from byte offset "begin" up until "end".
+        void prepare(const char* input, u64 input_size, u64 begin, u64 end,
+            lexer_instance_output* output, u8 tab_size);
+
+        // Reserves space in the output for the tokens of "character_count" characters.
+        void reserve_tokens(u64 character_count);
 
-        // Resets the lexer.
-        void prepare(const char* input, u64 input_size, lexer_instance_output* output, u8 tab_size);
         void analyze();
 
+        // Tokenizes the input in up to "chunk_count" chunks at once and appends them to the output.
+        void analyze_parallel(u64 chunk_count);
+
+        // Returns the offsets at which chunks begin, followed by the input size.
+        // A chunk only begins after a newline that is neither inside a string nor a comment,
+        // so no token can span two chunks.
+        std::vector<u64> find_chunk_bounds(u64 chunk_count) const;
+
+        // Both return the offset after the end of a string or block comment that begins right
+        // before "index", skipping exactly what "analyze" would skip.
+        // Return "input_size" if the input ends first.
+        u64 skip_string(u64 index) const;
+        u64 skip_block_comment(u64 index) const;
+
+        // True if lexing stops at "index".
+        bool is_end(u64 index) const;
+
+        // Appends the output of a chunk, rebasing the indices of its values.
+        void append_chunk(const lexer_instance_output& chunk_output);
+
         // Returns true if next char is valid and increment "i".
-        // Returns false if next char is the null terminator.
+        // Returns false if next char is the null terminator or at "input_size".
         std::optional<char> get_char();
 
         // Returns true if next char is valid, but do not increment "i".
-        // Returns false if next char is the null terminator.
+        // Returns false if next char is the null terminator or at "input_size".
         std::optional<char> peek_char();
 
         // Utility functions
-        void add_identifier(const std::string& identifier, u64 start_column, u64 end_column);
-        void add_number(const std::string& number, bool dot, u64 start_column, u64 end_column);
+        void add_token(s8 type, u32 value_index, u64 offset);
+        void add_identifier(u64 offset, u64 length);
+        void add_number(u64 offset, u64 length, bool dot);
+
+        // Report an error spanning the characters from byte offset "start" to "end", both inclusive.
+        void report_error(const std::string& msg, u64 start, u64 end);
     };
 
-    constexpr std::array<bool, 127> build_alpha_lookup()
+    // Character classes the lexer dispatches on, one per kind of token a character can begin.
+    enum char_class : u8
     {
-        // All values are default-initialized to false.
-        std::array<bool, 127> result{};
+        CHAR_OTHER = 0,
+        CHAR_END,
+        CHAR_SPACE,
+        CHAR_ALPHA,
+        CHAR_DIGIT,
+        CHAR_QUOTE,
+        CHAR_SLASH
+    };
 
-        // [A-Z]
-        for (u64 i = 65; i <= 90; i += 1)
-        {
-            result[i] = true;
-        }
+    constexpr std::array<char_class, 256> build_char_classes()
+    {
+        // All values are default-initialized to "CHAR_OTHER".
+        std::array<char_class, 256> result{};
 
-        // [a-z]
-        for (u64 i = 97; i <= 122; i += 1)
-        {
-            result[i] = true;
-        }
+        result['\0'] = CHAR_END;
 
-        // '_'
-        result[95] = true;
+        // Must match what "scanner::skip_whitespace" skips.
+        result[' '] = CHAR_SPACE;
+        result['\t'] = CHAR_SPACE;
+        result['\n'] = CHAR_SPACE;
 
-        return result;
-    }
+        // [A-Z]
+        for (u64 i = 'A'; i <= 'Z'; i += 1)
+            result[i] = CHAR_ALPHA;
 
-    constexpr std::array<bool, 127> build_num_lookup()
-    {
-        // All values are default-initialized to false.
-        std::array<bool, 127> result{};
+        // [a-z]
+        for (u64 i = 'a'; i <= 'z'; i += 1)
+            result[i] = CHAR_ALPHA;
+
+        result['_'] = CHAR_ALPHA;
 
         // [0-9]
-        for (u64 i = 48; i <= 57; i += 1)
-        {
-            result[i] = true;
-        }
+        for (u64 i = '0'; i <= '9'; i += 1)
+            result[i] = CHAR_DIGIT;
+
+        result['"'] = CHAR_QUOTE;
+        result['/'] = CHAR_SLASH;
 
         return result;
     }
 
-    //constexpr std::array<bool, 127> build_alpha_lookup();
-    constexpr std::array<bool, 127> ALPHA_LOOKUP = build_alpha_lookup();
-    //constexpr std::array<bool, 127> build_num_lookup();
-    constexpr std::array<bool, 127> NUM_LOOKUP = build_num_lookup();
+    // Covers all 256 byte values, so that any input byte can be classified without a range check.
+    constexpr std::array<char_class, 256> CHAR_CLASSES = build_char_classes();
+
+    constexpr char_class classify(char c)
+    {
+        return CHAR_CLASSES[static_cast<u8>(c)];
+    }
 
     // Is alpha [a-z], [A-Z] or underscore "_".
-    constexpr bool is_alpha(s8 c)
+    constexpr bool is_alpha(char c)
     {
-        return ALPHA_LOOKUP[c];
+        return classify(c) == CHAR_ALPHA;
     }
 
     // Is digit [0-9].
-    constexpr bool is_num(s8 c)
+    constexpr bool is_num(char c)
     {
-        return NUM_LOOKUP[c];
+        return classify(c) == CHAR_DIGIT;
     }
 
     // Is alpha, underscore or digit [a-z], [A-Z], "_", [0-9].
-    constexpr bool is_alnum(s8 c)
+    constexpr bool is_alnum(char c)
+    {
+        return is_alpha(c) || is_num(c);
+    }
+
+    // Transition table recognizing the composed tokens in "COMPOSED_TOKENS".
+    // "first" maps a character to the state after reading it, where 0 means that no composed token
+    // begins with that character. "second" maps a state and the next character to the type of the
+    // composed token, or 0 if the two characters do not form one.
+    struct composed_token_table
+    {
+        static constexpr u64 STATE_COUNT = COMPOSED_TOKENS_LENGTH / 2 + 1;
+
+        std::array<u8, 256> first;
+        std::array<std::array<s8, 256>, STATE_COUNT> second;
+    };
+
+    constexpr composed_token_table build_composed_token_table()
+    {
+        // All values are default-initialized to 0.
+        composed_token_table result{};
+        u8 state_count = 1;
+
+        for (u64 i = 0; i < COMPOSED_TOKENS_LENGTH / 2; i += 1) {
+            u8 first = static_cast<u8>(COMPOSED_TOKENS[i * 2]);
+            u8 second = static_cast<u8>(COMPOSED_TOKENS[i * 2 + 1]);
+
+            // Composed tokens sharing their first character share a state.
+            if (result.first[first] == 0) {
+                result.first[first] = state_count;
+                state_count += 1;
+            }
+
+            result.second[result.first[first]][second] = COMPOSED_TOKEN_TYPES[i];
+        }
+
+        return result;
+    }
+
+    constexpr composed_token_table COMPOSED_TOKEN_TABLE = build_composed_token_table();
+
+    // Returns the type of the composed token made of "first" and "second", or 0 if there is none.
+    constexpr s8 composed_token_type(char first, char second)
     {
-        return ALPHA_LOOKUP[c] || NUM_LOOKUP[c];
+        return COMPOSED_TOKEN_TABLE.second[COMPOSED_TOKEN_TABLE.first[static_cast<u8>(first)]]
+            [static_cast<u8>(second)];
     }
+
+    static_assert(composed_token_type(':', ':') == TOKEN_DOUBLECOLON);
+    static_assert(composed_token_type('-', '>') == TOKEN_RIGHT_POINTER);
+    static_assert(composed_token_type('-', '\0') == 0);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,406 @@
+#include <scanner.hpp>
+
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define MASONC_SCANNER_X86
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(MASONC_SCANNER_X86) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define MASONC_SCANNER_SSE2
+#endif
+
+#if defined(MASONC_SCANNER_X86)
+    #define MASONC_SCANNER_AVX2
+
+    // MSVC allows using intrinsics of any instruction set without further ado,
+    // GCC and Clang have to be told per function.
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #define MASONC_TARGET_AVX2
+    #else
+        #define MASONC_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace masonc::lexer
+{
+    enum class scan_kind : u8
+    {
+        WHITESPACE,
+        ALNUM,
+        NUM,
+        STRING_SPECIAL,
+        LINE_END,
+        BLOCK_COMMENT_SPECIAL,
+        STRING_OR_COMMENT
+    };
+
+    // Bit flags of "SCAN_STOP_LOOKUP", one for each "scan_kind".
+    constexpr u8 scan_kind_bit(scan_kind kind)
+    {
+        return static_cast<u8>(1 << static_cast<u8>(kind));
+    }
+
+    // For every byte value, which scan kinds it ends the run of.
+    constexpr std::array<u8, 256> build_scan_stop_lookup()
+    {
+        std::array<u8, 256> result{};
+
+        for (u64 i = 0; i < 256; i += 1) {
+            bool is_space = (i == ' ' || i == '\n' || i == '\t');
+            bool is_num = (i >= '0' && i <= '9');
+            bool is_alnum = is_num || (i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z') || i == '_';
+
+            u8 stop = 0;
+
+            if (!is_space)
+                stop |= scan_kind_bit(scan_kind::WHITESPACE);
+            if (!is_alnum)
+                stop |= scan_kind_bit(scan_kind::ALNUM);
+            if (!is_num)
+                stop |= scan_kind_bit(scan_kind::NUM);
+            if (i == '"' || i == '\\' || i == '\n' || i == '\t' || i == '\0')
+                stop |= scan_kind_bit(scan_kind::STRING_SPECIAL);
+            if (i == '\n' || i == '\0')
+                stop |= scan_kind_bit(scan_kind::LINE_END);
+            if (i == '/' || i == '*' || i == '\n' || i == '\t' || i == '\0')
+                stop |= scan_kind_bit(scan_kind::BLOCK_COMMENT_SPECIAL);
+            if (i == '"' || i == '/' || i == '\0')
+                stop |= scan_kind_bit(scan_kind::STRING_OR_COMMENT);
+
+            result[i] = stop;
+        }
+
+        return result;
+    }
+
+    constexpr std::array<u8, 256> SCAN_STOP_LOOKUP = build_scan_stop_lookup();
+
+    template <scan_kind kind>
+    static u64 scalar_scan(const char* input, u64 index, u64 input_size)
+    {
+        while (index < input_size) {
+            if (SCAN_STOP_LOOKUP[static_cast<u8>(input[index])] & scan_kind_bit(kind))
+                return index;
+
+            index += 1;
+        }
+
+        return input_size;
+    }
+
+#if defined(MASONC_SCANNER_X86)
+    static u32 count_trailing_zeros(u32 mask)
+    {
+        #if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long result;
+            _BitScanForward(&result, mask);
+            return static_cast<u32>(result);
+        #else
+            return static_cast<u32>(__builtin_ctz(mask));
+        #endif
+    }
+#endif
+
+#if defined(MASONC_SCANNER_SSE2)
+    // Every byte is set to 0xFF if it is in the range "[low, high]", otherwise 0.
+    // Bytes of 128 and above are negative and therefore never in range.
+    static inline __m128i sse2_in_range(__m128i chunk, char low, char high)
+    {
+        return _mm_and_si128(
+            _mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(low - 1))),
+            _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(high + 1)))
+        );
+    }
+
+    static inline __m128i sse2_equals(__m128i chunk, char c)
+    {
+        return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c));
+    }
+
+    // Returns a bit mask in which every set bit is a character that ends the run.
+    template <scan_kind kind>
+    static inline u32 sse2_stop_mask(__m128i chunk)
+    {
+        __m128i match;
+
+        if constexpr (kind == scan_kind::WHITESPACE) {
+            match = _mm_or_si128(_mm_or_si128(sse2_equals(chunk, ' '), sse2_equals(chunk, '\n')),
+                sse2_equals(chunk, '\t'));
+
+            return ~static_cast<u32>(_mm_movemask_epi8(match)) & 0xFFFFu;
+        }
+        else if constexpr (kind == scan_kind::ALNUM) {
+            // Setting bit 0x20 maps [A-Z] onto [a-z] without mapping anything else onto it.
+            __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+
+            match = _mm_or_si128(sse2_in_range(lower, 'a', 'z'), sse2_in_range(chunk, '0', '9'));
+            match = _mm_or_si128(match, sse2_equals(chunk, '_'));
+
+            return ~static_cast<u32>(_mm_movemask_epi8(match)) & 0xFFFFu;
+        }
+        else if constexpr (kind == scan_kind::NUM) {
+            match = sse2_in_range(chunk, '0', '9');
+
+            return ~static_cast<u32>(_mm_movemask_epi8(match)) & 0xFFFFu;
+        }
+        else if constexpr (kind == scan_kind::STRING_SPECIAL) {
+            match = _mm_or_si128(sse2_equals(chunk, '"'), sse2_equals(chunk, '\\'));
+            match = _mm_or_si128(match, _mm_or_si128(sse2_equals(chunk, '\n'), sse2_equals(chunk, '\t')));
+            match = _mm_or_si128(match, sse2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::LINE_END) {
+            match = _mm_or_si128(sse2_equals(chunk, '\n'), sse2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::STRING_OR_COMMENT) {
+            match = _mm_or_si128(sse2_equals(chunk, '"'), sse2_equals(chunk, '/'));
+            match = _mm_or_si128(match, sse2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm_movemask_epi8(match));
+        }
+        else {
+            match = _mm_or_si128(sse2_equals(chunk, '/'), sse2_equals(chunk, '*'));
+            match = _mm_or_si128(match, _mm_or_si128(sse2_equals(chunk, '\n'), sse2_equals(chunk, '\t')));
+            match = _mm_or_si128(match, sse2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm_movemask_epi8(match));
+        }
+    }
+
+    template <scan_kind kind>
+    static u64 sse2_scan(const char* input, u64 index, u64 input_size)
+    {
+        while (index + 16 <= input_size) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index));
+            u32 mask = sse2_stop_mask<kind>(chunk);
+
+            if (mask != 0)
+                return index + count_trailing_zeros(mask);
+
+            index += 16;
+        }
+
+        // Less than a full chunk is left.
+        return scalar_scan<kind>(input, index, input_size);
+    }
+#endif
+
+#if defined(MASONC_SCANNER_AVX2)
+    MASONC_TARGET_AVX2
+    static inline __m256i avx2_in_range(__m256i chunk, char low, char high)
+    {
+        return _mm256_and_si256(
+            _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(static_cast<char>(low - 1))),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), chunk)
+        );
+    }
+
+    MASONC_TARGET_AVX2
+    static inline __m256i avx2_equals(__m256i chunk, char c)
+    {
+        return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c));
+    }
+
+    // Returns a bit mask in which every set bit is a character that ends the run.
+    template <scan_kind kind>
+    MASONC_TARGET_AVX2
+    static inline u32 avx2_stop_mask(__m256i chunk)
+    {
+        __m256i match;
+
+        if constexpr (kind == scan_kind::WHITESPACE) {
+            match = _mm256_or_si256(_mm256_or_si256(avx2_equals(chunk, ' '), avx2_equals(chunk, '\n')),
+                avx2_equals(chunk, '\t'));
+
+            return ~static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::ALNUM) {
+            __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+
+            match = _mm256_or_si256(avx2_in_range(lower, 'a', 'z'), avx2_in_range(chunk, '0', '9'));
+            match = _mm256_or_si256(match, avx2_equals(chunk, '_'));
+
+            return ~static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::NUM) {
+            match = avx2_in_range(chunk, '0', '9');
+
+            return ~static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::STRING_SPECIAL) {
+            match = _mm256_or_si256(avx2_equals(chunk, '"'), avx2_equals(chunk, '\\'));
+            match = _mm256_or_si256(match, _mm256_or_si256(avx2_equals(chunk, '\n'), avx2_equals(chunk, '\t')));
+            match = _mm256_or_si256(match, avx2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::LINE_END) {
+            match = _mm256_or_si256(avx2_equals(chunk, '\n'), avx2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+        else if constexpr (kind == scan_kind::STRING_OR_COMMENT) {
+            match = _mm256_or_si256(avx2_equals(chunk, '"'), avx2_equals(chunk, '/'));
+            match = _mm256_or_si256(match, avx2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+        else {
+            match = _mm256_or_si256(avx2_equals(chunk, '/'), avx2_equals(chunk, '*'));
+            match = _mm256_or_si256(match, _mm256_or_si256(avx2_equals(chunk, '\n'), avx2_equals(chunk, '\t')));
+            match = _mm256_or_si256(match, avx2_equals(chunk, '\0'));
+
+            return static_cast<u32>(_mm256_movemask_epi8(match));
+        }
+    }
+
+    template <scan_kind kind>
+    MASONC_TARGET_AVX2
+    static u64 avx2_scan(const char* input, u64 index, u64 input_size)
+    {
+        while (index + 32 <= input_size) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + index));
+            u32 mask = avx2_stop_mask<kind>(chunk);
+
+            if (mask != 0)
+                return index + count_trailing_zeros(mask);
+
+            index += 32;
+        }
+
+        // Less than a full chunk is left.
+        return scalar_scan<kind>(input, index, input_size);
+    }
+
+    static bool cpu_supports_avx2()
+    {
+        #if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            // The CPU has to support AVX and the operating system has to save YMM registers.
+            __cpuid(info, 1);
+            bool os_uses_xsave = (info[2] & (1 << 27)) != 0;
+            bool cpu_has_avx = (info[2] & (1 << 28)) != 0;
+
+            if (!os_uses_xsave || !cpu_has_avx || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+        #else
+            return __builtin_cpu_supports("avx2");
+        #endif
+    }
+#endif
+
+    const char* scanner_isa_name(scanner_isa isa)
+    {
+        switch (isa) {
+            default:
+                return "";
+            case scanner_isa::SCALAR:
+                return "Scalar";
+            case scanner_isa::SSE2:
+                return "SSE2";
+            case scanner_isa::AVX2:
+                return "AVX2";
+        }
+    }
+
+    const scanner& scalar_scanner()
+    {
+        static const scanner SCALAR_SCANNER = {
+            scanner_isa::SCALAR,
+            &scalar_scan<scan_kind::WHITESPACE>,
+            &scalar_scan<scan_kind::ALNUM>,
+            &scalar_scan<scan_kind::NUM>,
+            &scalar_scan<scan_kind::STRING_SPECIAL>,
+            &scalar_scan<scan_kind::LINE_END>,
+            &scalar_scan<scan_kind::BLOCK_COMMENT_SPECIAL>,
+            &scalar_scan<scan_kind::STRING_OR_COMMENT>
+        };
+
+        return SCALAR_SCANNER;
+    }
+
+    const scanner* scanner_for(scanner_isa isa)
+    {
+        switch (isa) {
+            default:
+                return nullptr;
+
+            case scanner_isa::SCALAR:
+                return &scalar_scanner();
+
+            case scanner_isa::SSE2: {
+            #if defined(MASONC_SCANNER_SSE2)
+                static const scanner SSE2_SCANNER = {
+                    scanner_isa::SSE2,
+                    &sse2_scan<scan_kind::WHITESPACE>,
+                    &sse2_scan<scan_kind::ALNUM>,
+                    &sse2_scan<scan_kind::NUM>,
+                    &sse2_scan<scan_kind::STRING_SPECIAL>,
+                    &sse2_scan<scan_kind::LINE_END>,
+                    &sse2_scan<scan_kind::BLOCK_COMMENT_SPECIAL>,
+                    &sse2_scan<scan_kind::STRING_OR_COMMENT>
+                };
+
+                return &SSE2_SCANNER;
+            #else
+                return nullptr;
+            #endif
+            }
+
+            case scanner_isa::AVX2: {
+            #if defined(MASONC_SCANNER_AVX2)
+                static const scanner AVX2_SCANNER = {
+                    scanner_isa::AVX2,
+                    &avx2_scan<scan_kind::WHITESPACE>,
+                    &avx2_scan<scan_kind::ALNUM>,
+                    &avx2_scan<scan_kind::NUM>,
+                    &avx2_scan<scan_kind::STRING_SPECIAL>,
+                    &avx2_scan<scan_kind::LINE_END>,
+                    &avx2_scan<scan_kind::BLOCK_COMMENT_SPECIAL>,
+                    &avx2_scan<scan_kind::STRING_OR_COMMENT>
+                };
+
+                static const bool supported = cpu_supports_avx2();
+                return supported ? &AVX2_SCANNER : nullptr;
+            #else
+                return nullptr;
+            #endif
+            }
+        }
+    }
+
+    const scanner& active_scanner()
+    {
+        static const scanner* selected = []() {
+            const scanner* result = scanner_for(scanner_isa::AVX2);
+            if (result != nullptr)
+                return result;
+
+            result = scanner_for(scanner_isa::SSE2);
+            if (result != nullptr)
+                return result;
+
+            return &scalar_scanner();
+        }();
+
+        return *selected;
+    }
+}
\ No newline at end of file
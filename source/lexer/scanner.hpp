@@ -0,0 +1,66 @@
+#ifndef MASONC_SCANNER_HPP
+#define MASONC_SCANNER_HPP
+
+#include <common.hpp>
+
+namespace masonc::lexer
+{
+    // Instruction set a scanner is implemented with.
+    enum class scanner_isa : u8
+    {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    // Returns the name of an instruction set as a string.
+    const char* scanner_isa_name(scanner_isa isa);
+
+    // Table of functions that find the end of a run of characters in bulk,
+    // so the lexer does not have to look at every character on its own.
+    //
+    // Every function starts looking at "index" and returns the index of the first character
+    // that ends the run, or "input_size" if no such character exists before it.
+    // The null terminator always ends a run.
+    //
+    // "input" must be readable up until "input_size", nothing beyond it is ever read.
+    struct scanner
+    {
+        using scan_function = u64(*)(const char* input, u64 index, u64 input_size);
+
+        scanner_isa isa;
+
+        // Stops at the first character that is not ' ', '\n' or '\t'.
+        scan_function skip_whitespace;
+
+        // Stops at the first character that is not [a-z], [A-Z], "_" or [0-9].
+        scan_function skip_alnum;
+
+        // Stops at the first character that is not [0-9].
+        scan_function skip_num;
+
+        // Stops at the first '"', '\\', '\n' or '\t'.
+        scan_function find_string_special;
+
+        // Stops at the first '\n'.
+        scan_function find_line_end;
+
+        // Stops at the first '/', '*', '\n' or '\t'.
+        scan_function find_block_comment_special;
+
+        // Stops at the first '"' or '/', the only characters that can begin a string or comment.
+        scan_function find_string_or_comment;
+    };
+
+    // Portable implementation that looks at one character at a time.
+    const scanner& scalar_scanner();
+
+    // Returns "nullptr" if the instruction set is neither supported by the build target
+    // nor by the CPU the compiler is running on.
+    const scanner* scanner_for(scanner_isa isa);
+
+    // Widest scanner the CPU supports, selected once on the first call.
+    const scanner& active_scanner();
+}
+
+#endif
\ No newline at end of file
@@ -3,10 +3,13 @@
 #include <parser_expressions.hpp>
 #include <mod_handle.hpp>
 #include <build_stage.hpp>
+#include <interner.hpp>
 
+#include <string>
 #include <vector>
 #include <optional>
 #include <algorithm>
+#include <string_view>
 
 namespace masonc::linker
 {
@@ -34,6 +37,155 @@ namespace masonc::linker
         this->linker_output->parser_outputs = parser_outputs;
     }
 
+    std::vector<masonc::parser::parser_instance_output*> linker::add_module(
+        masonc::parser::parser_instance_output* parser_output)
+    {
+        std::vector<masonc::parser::parser_instance_output*> ready_modules;
+
+        u64 module_index = pending_modules.size();
+        pending_modules.push_back(pending_module{ parser_output, 0 });
+
+        symbol module_name = global_interner.intern(parser_output->module_name);
+        added_module_names.insert(module_name);
+
+        u64 vertex_index = module_vertex(module_name);
+        vertex_modules[vertex_index].push_back(parser_output);
+
+        bool imports_other_modules = false;
+
+        for (symbol import_symbol : parser_output->file_module.module_imports) {
+            // Importing itself is allowed, it is not a cycle and there is nothing to wait for.
+            if (import_symbol == module_name)
+                continue;
+
+            module_vertex(import_symbol);
+            module_graph.add_adjacency(module_name, import_symbol);
+
+            imports_other_modules = true;
+        }
+
+        if (imports_other_modules) {
+            held_modules.push_back(module_index);
+        }
+        else {
+            ready_modules.push_back(parser_output);
+        }
+
+        return ready_modules;
+    }
+
+    std::vector<masonc::parser::parser_instance_output*> linker::complete_modules()
+    {
+        std::vector<masonc::parser::parser_instance_output*> ready_modules;
+
+        for (u64 module_index : held_modules) {
+            pending_module& held_module = pending_modules[module_index];
+
+            for (symbol import_name : held_module.parser_output->file_module.module_imports) {
+                if (added_module_names.find(import_name) == added_module_names.end())
+                    held_module.missing_import_count += 1;
+            }
+
+            if (held_module.missing_import_count == 0)
+                ready_modules.push_back(held_module.parser_output);
+        }
+
+        held_modules.clear();
+
+        return ready_modules;
+    }
+
+    void linker::report_unresolved_imports(masonc::linker::linker_output* linker_output)
+    {
+        using namespace masonc::parser;
+
+        this->linker_output = linker_output;
+
+        for (const pending_module& current_module : pending_modules) {
+            if (current_module.missing_import_count == 0)
+                continue;
+
+            const parser_instance_output* parser_output = current_module.parser_output;
+
+            for (expression_handle top_level_handle : parser_output->AST) {
+                const expression& expr = parser_output->expression_at(top_level_handle);
+                if (expr.type != EXPR_MODULE_IMPORT)
+                    continue;
+
+                const expression_module_import& import = expr.module_import;
+                symbol import_name = parser_output->file_module.module_imports[import.import_index];
+
+                if (added_module_names.find(import_name) != added_module_names.end())
+                    continue;
+
+                report_link_error("Module \"" + std::string{ global_interner.at(import_name) } +
+                    "\" is imported but never declared.",
+                    parser_output->lexer_output.location_at(import.name_token_index));
+            }
+        }
+    }
+
+    void linker::report_import_cycles(masonc::linker::linker_output* linker_output)
+    {
+        using namespace masonc::parser;
+
+        this->linker_output = linker_output;
+
+        module_graph.find_cycles();
+
+        for (const std::vector<u64>& cycle : module_graph.cycles()) {
+            robin_hood::unordered_flat_set<symbol> cycle_names;
+            std::string cycle_text;
+
+            for (u64 vertex_index : cycle) {
+                symbol name = module_graph.at(vertex_index).value;
+                cycle_names.insert(name);
+
+                if (!cycle_text.empty())
+                    cycle_text += ", ";
+
+                cycle_text += "\"" + std::string{ global_interner.at(name) } + "\"";
+            }
+
+            // Report every import that leads from one module of the cycle to another.
+            for (u64 vertex_index : cycle) {
+                for (const parser_instance_output* parser_output : vertex_modules[vertex_index]) {
+                    for (expression_handle top_level_handle : parser_output->AST) {
+                        const expression& expr = parser_output->expression_at(top_level_handle);
+                        if (expr.type != EXPR_MODULE_IMPORT)
+                            continue;
+
+                        symbol import_name = parser_output->file_module.module_imports[expr.module_import.import_index];
+
+                        if (import_name == module_graph.at(vertex_index).value ||
+                            cycle_names.find(import_name) == cycle_names.end())
+                        {
+                            continue;
+                        }
+
+                        const expression_module_import& import = expr.module_import;
+
+                        report_link_error("Module \"" + parser_output->module_name +
+                            "\" is part of an import cycle between the modules " + cycle_text + ".",
+                            parser_output->lexer_output.location_at(import.name_token_index));
+                    }
+                }
+            }
+        }
+    }
+
+    u64 linker::module_vertex(symbol module_name)
+    {
+        std::optional<u64> vertex_index = module_graph.find_index(module_name);
+        if (vertex_index)
+            return vertex_index.value();
+
+        module_graph.add_vertex(module_name);
+        vertex_modules.emplace_back();
+
+        return module_graph.size() - 1;
+    }
+
     void linker::report_link_error(const std::string& msg, const masonc::lexer::token_location& location)
     {
         this->linker_output->messages.report_error(msg, build_stage::LINKER, location);
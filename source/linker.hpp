@@ -10,7 +10,10 @@
 #include <message.hpp>
 #include <dependency_list.hpp>
 
+#include <robin_hood.hpp>
+
 #include <string>
+#include <vector>
 
 namespace masonc::linker
 {
@@ -23,7 +26,8 @@ namespace masonc::linker
 
     // The linker resolves module dependencies, any circular dependencies are reported as errors.
     //
-    // The linker requires that the lexer and parser stages finished completely.
+    // "link" requires that the lexer and parser stages finished completely.
+    // "add_module" takes one module at a time instead, as soon as it is parsed.
     struct linker
     {
         // Returns "nullptr" if module is not defined.
@@ -35,9 +39,54 @@ namespace masonc::linker
         void link(std::vector<masonc::parser::parser_instance_output>* parser_outputs,
             linker_output* linker_output);
 
+        // Adds one parsed file of a module and returns it if it imports no other module.
+        // A file that imports other modules is held until "complete_modules", because any module
+        // can have more files that are not parsed yet.
+        std::vector<masonc::parser::parser_instance_output*> add_module(
+            masonc::parser::parser_instance_output* parser_output);
+
+        // Returns every held file whose imports were all added. Call once every file is added.
+        // Every file is returned exactly once by "add_module" and "complete_modules",
+        // unless one of its imports is never added.
+        std::vector<masonc::parser::parser_instance_output*> complete_modules();
+
+        // Reports an error for every import of a module that was never added.
+        // Call once all modules are added.
+        void report_unresolved_imports(linker_output* linker_output);
+
+        // Reports an error for every import that is part of an import cycle. Modules in a cycle
+        // are never returned by "add_module". Call once all modules are added.
+        void report_import_cycles(linker_output* linker_output);
+
     private:
+        struct pending_module
+        {
+            masonc::parser::parser_instance_output* parser_output;
+
+            // Imports that were not added yet, only known once "complete_modules" was called.
+            u64 missing_import_count;
+        };
+
         linker_output* linker_output;
-        //dependency_graph<mod*> module_graph;
+
+        // Interned names of all added modules.
+        robin_hood::unordered_flat_set<symbol> added_module_names;
+
+        // Every added module, in the order of "add_module" calls.
+        std::vector<pending_module> pending_modules;
+
+        // Indices into "pending_modules" of the modules held until "complete_modules".
+        std::vector<u64> held_modules;
+
+        // Interned module names, each pointing to the names of the modules it imports.
+        // Imported modules get a vertex before they are added.
+        dependency_list<symbol> module_graph;
+
+        // Added modules by the index of the vertex of their name in "module_graph".
+        std::vector<std::vector<masonc::parser::parser_instance_output*>> vertex_modules;
+
+        // Returns the index of the vertex of "module_name" in "module_graph", adding it if needed.
+        u64 module_vertex(symbol module_name);
 
         void report_link_error(const std::string& msg, const masonc::lexer::token_location& location);
     };
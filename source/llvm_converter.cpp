@@ -2,64 +2,173 @@
 
 #include <logger.hpp>
 #include <type.hpp>
+#include <binary_operator.hpp>
+#include <build_stage.hpp>
 
 #include <iostream>
 #include <string>
 #include <vector>
 #include <limits>
+#include <string_view>
 
 namespace masonc::llvm
 {
-    void initialize_llvm_converter()
+    llvm_context::llvm_context()
     {
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_VOID, LLVMVoidType() });
+        context = LLVMContextCreate();
+
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_VOID),
+            LLVMVoidTypeInContext(context) });
+
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_BOOL),
+            LLVMInt1TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_CHAR),
+            LLVMInt8TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_U8),
+            LLVMInt8TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_S8),
+            LLVMInt8TypeInContext(context) });
+
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_U16),
+            LLVMInt16TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_S16),
+            LLVMInt16TypeInContext(context) });
+
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_U32),
+            LLVMInt32TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_S32),
+            LLVMInt32TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_F32),
+            LLVMFloatTypeInContext(context) });
+
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_U64),
+            LLVMInt64TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_S64),
+            LLVMInt64TypeInContext(context) });
+        type_map.insert(robin_hood::pair<string_id, LLVMTypeRef>{ global_interner.intern(TYPE_F64),
+            LLVMDoubleTypeInContext(context) });
+
+        for (type unsigned_type : { TYPE_BOOL, TYPE_CHAR, TYPE_U8, TYPE_U16, TYPE_U32, TYPE_U64 }) {
+            unsigned_types.insert(global_interner.intern(unsigned_type));
+        }
+    }
 
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_BOOL, LLVMInt1Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_CHAR, LLVMInt8Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_U8, LLVMInt8Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_S8, LLVMInt8Type() });
+    llvm_context::~llvm_context()
+    {
+        LLVMContextDispose(context);
+    }
 
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_U16, LLVMInt16Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_S16, LLVMInt16Type() });
+    void llvm_converter::convert(llvm_context* context, masonc::lexer::lexer_instance_output* input_lexer,
+        masonc::parser::parser_instance_output* input_parser, llvm_converter_output* output,
+        bool procedure_definitions, const symbol_table* declarations)
+    {
+        convert_definitions = procedure_definitions;
+        this->declarations = declarations;
+        begin_module(context, input_lexer, input_parser, output, input_parser->module_name);
 
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_U32, LLVMInt32Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_S32, LLVMInt32Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_F32, LLVMFloatType() });
+        // Procedures can be called and globals referred to before they are defined.
+        declare_module_scope(true);
 
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_U64, LLVMInt64Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_S64, LLVMInt64Type() });
-        type_map.insert(robin_hood::pair<const char*, LLVMTypeRef>{ TYPE_F64, LLVMDoubleType() });
+        for (masonc::parser::expression_handle top_level : input_parser->AST) {
+            convert_top_level(&input_parser->expression_at(top_level));
+        }
+
+        verify_module();
     }
 
-    void llvm_converter::convert(masonc::lexer::lexer_instance_output* input_lexer,
-        masonc::parser::parser_instance_output* input_parser, llvm_converter_output* output)
+    void llvm_converter::convert_procedure_definition(llvm_context* context,
+        masonc::lexer::lexer_instance_output* input_lexer, masonc::parser::parser_instance_output* input_parser,
+        masonc::parser::expression_handle definition, llvm_converter_output* output,
+        const symbol_table* declarations)
     {
+        this->declarations = declarations;
+
+        masonc::parser::expression* expr = &input_parser->expression_at(definition);
+        symbol name = input_parser->expression_at(expr->procedure_definition.prototype).procedure_prototype.name_handle;
+
+        begin_module(context, input_lexer, input_parser, output,
+            input_parser->module_name + "." + std::string{ global_interner.at(name) });
+
+        // Global variables are defined by the module, this only refers to them.
+        declare_module_scope(false);
+        convert_procedure(&expr->procedure_definition);
+
+        verify_module();
+    }
+
+    void llvm_converter::begin_module(llvm_context* context, masonc::lexer::lexer_instance_output* input_lexer,
+        masonc::parser::parser_instance_output* input_parser, llvm_converter_output* output,
+        const std::string& module_name)
+    {
+        this->context = context;
         this->input_lexer = input_lexer;
         this->input_parser = input_parser;
         this->output = output;
-        output->llvm_module = LLVMModuleCreateWithName("main_module");
+        output->llvm_module = LLVMModuleCreateWithNameInContext(module_name.c_str(), context->context);
 
-        llvm_builder = LLVMCreateBuilder();
-        llvm_sub_builder = LLVMCreateBuilder();
+        llvm_builder = LLVMCreateBuilderInContext(context->context);
+        llvm_sub_builder = LLVMCreateBuilderInContext(context->context);
 
         add_built_in_procedures();
+    }
+
+    void llvm_converter::declare_module_scope(bool define_globals)
+    {
+        for (masonc::parser::expression_handle top_level : input_parser->AST) {
+            masonc::parser::expression* expr = &input_parser->expression_at(top_level);
 
-        //for (size_t i = 0; i < input_parser->; i += 1) {
-        //    expression* expr = &input->expressions[i];
-        //    convert_top_level(expr);
-        //}
+            switch (expr->type) {
+                default:
+                    break;
+                case masonc::parser::EXPR_PROC_PROTOTYPE:
+                    convert_procedure_prototype(&expr->procedure_prototype);
+                    break;
+                case masonc::parser::EXPR_PROC_DEFINITION:
+                    convert_procedure_prototype(
+                        &input_parser->expression_at(expr->procedure_definition.prototype).procedure_prototype);
+                    break;
+                case masonc::parser::EXPR_VAR_DECLARATION:
+                    convert_global_variable(&expr->variable_declaration, nullptr, define_globals);
+                    break;
+                case masonc::parser::EXPR_BINARY: {
+                    masonc::parser::expression* declaration = &input_parser->expression_at(expr->binary.left);
 
-        //char* msg = LLVMCreateMessage("");
-        //LLVMBool llvm_verify = LLVMVerifyModule(output->llvm_module, LLVMPrintMessageAction, &msg);
+                    if (expr->binary.op_code == OP_EQUALS.op_code &&
+                        declaration->type == masonc::parser::EXPR_VAR_DECLARATION)
+                    {
+                        convert_global_variable(&declaration->variable_declaration,
+                            &input_parser->expression_at(expr->binary.right), define_globals);
+                    }
 
-        //LLVMDisposeMessage(msg);
+                    break;
+                }
+            }
+        }
+    }
+
+    void llvm_converter::verify_module()
+    {
+        // Only valid modules are checked, what failed to convert is reported already.
+        if (output->messages.errors.size() != 0)
+            return;
+
+        char* message = nullptr;
+
+        if (LLVMVerifyModule(output->llvm_module, LLVMReturnStatusAction, &message)) {
+            report_convert_error("Module \"" + input_parser->module_name + "\" is not valid: " + message);
+        }
+
+        LLVMDisposeMessage(message);
     }
 
     void llvm_converter::free()
     {
         LLVMDisposeBuilder(llvm_sub_builder);
         LLVMDisposeBuilder(llvm_builder);
-        LLVMDisposeModule(output->llvm_module);
+
+        // Modules handed to a JIT are owned by it.
+        if (output->llvm_module)
+            LLVMDisposeModule(output->llvm_module);
     }
 
     void llvm_converter::print_IR()
@@ -73,10 +182,15 @@ namespace masonc::llvm
     {
     }
 
-    LLVMTypeRef llvm_converter::llvm_type_by_name(const char* type_name)
+    void llvm_converter::report_convert_error(const std::string& msg)
     {
-        const auto find_it = type_map.find(type_name);
-        if (find_it == type_map.end())
+        output->messages.report_error(msg, build_stage::CODE_GENERATOR);
+    }
+
+    LLVMTypeRef llvm_converter::llvm_type_by_name(string_id type_name)
+    {
+        const auto find_it = context->type_map.find(type_name);
+        if (find_it == context->type_map.end())
             return nullptr;
 
         return find_it->second;
@@ -87,6 +201,23 @@ namespace masonc::llvm
         return LLVMPointerType(llvm_element_type, 0);
     }
 
+    LLVMTypeRef llvm_converter::llvm_variable_type(const masonc::parser::expression_variable_declaration* expr)
+    {
+        LLVMTypeRef llvm_type = llvm_type_by_name(expr->type_handle);
+
+        if (llvm_type == nullptr) {
+            report_convert_error("Type \"" + std::string{ global_interner.at(expr->type_handle) } +
+                "\" does not exist.");
+
+            return nullptr;
+        }
+
+        if (expr->is_pointer)
+            return llvm_pointer_type(llvm_type);
+
+        return llvm_type;
+    }
+
     LLVMValueRef llvm_converter::build_alloca_at_entry(LLVMValueRef llvm_function,
         LLVMTypeRef llvm_variable_type, const char* variable_name)
     {
@@ -94,459 +225,629 @@ namespace masonc::llvm
 
         // Position the sub-builder at the start of the function's entry block.
         LLVMValueRef llvm_entry_first_instruction = LLVMGetFirstInstruction(llvm_function_entry_block);
-        LLVMPositionBuilder(llvm_sub_builder, llvm_function_entry_block, llvm_entry_first_instruction);
+
+        if (llvm_entry_first_instruction == nullptr) {
+            LLVMPositionBuilderAtEnd(llvm_sub_builder, llvm_function_entry_block);
+        }
+        else {
+            LLVMPositionBuilder(llvm_sub_builder, llvm_function_entry_block, llvm_entry_first_instruction);
+        }
 
         return LLVMBuildAlloca(llvm_sub_builder, llvm_variable_type, variable_name);
     }
 
+    LLVMValueRef llvm_converter::build_cast(LLVMValueRef llvm_value, LLVMTypeRef llvm_type)
+    {
+        if (llvm_value == nullptr)
+            return nullptr;
+
+        LLVMTypeRef llvm_value_type = LLVMTypeOf(llvm_value);
+        if (llvm_value_type == llvm_type)
+            return llvm_value;
+
+        // Mason types do not tell LLVM types whether they are signed, every integer is treated as signed.
+        LLVMTypeKind from = LLVMGetTypeKind(llvm_value_type);
+        LLVMTypeKind to = LLVMGetTypeKind(llvm_type);
+
+        bool from_real = from == LLVMFloatTypeKind || from == LLVMDoubleTypeKind;
+        bool to_real = to == LLVMFloatTypeKind || to == LLVMDoubleTypeKind;
+
+        if (from == LLVMIntegerTypeKind && to == LLVMIntegerTypeKind)
+            return LLVMBuildIntCast2(llvm_builder, llvm_value, llvm_type, true, "casttmp");
+
+        if (from == LLVMIntegerTypeKind && to_real)
+            return LLVMBuildSIToFP(llvm_builder, llvm_value, llvm_type, "casttmp");
+
+        if (from_real && to == LLVMIntegerTypeKind)
+            return LLVMBuildFPToSI(llvm_builder, llvm_value, llvm_type, "casttmp");
+
+        if (from_real && to_real)
+            return LLVMBuildFPCast(llvm_builder, llvm_value, llvm_type, "casttmp");
+
+        if (from == LLVMPointerTypeKind && to == LLVMPointerTypeKind)
+            return LLVMBuildBitCast(llvm_builder, llvm_value, llvm_type, "casttmp");
+
+        report_convert_error("A value cannot be converted to the type it is used as.");
+        return nullptr;
+    }
+
     LLVMValueRef llvm_converter::convert_top_level(masonc::parser::expression* expr)
     {
-        switch (expr->value.empty.type) {
+        switch (expr->type) {
             default:
-                global_logger.log_error(
-                    std::string{ "Cannot generate code for expression of type " +
-                    std::to_string(expr->value.empty.type) }.c_str()
-                );
+                report_convert_error("Cannot generate code for top-level expression of type " +
+                    std::to_string(expr->type) + ".");
                 return nullptr;
-            case masonc::parser::EXPR_VAR_DECLARATION:
+            case masonc::parser::EXPR_MODULE_DECLARATION:
+            case masonc::parser::EXPR_MODULE_IMPORT:
                 return nullptr;
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                return convert_global_variable(&expr->variable_declaration, nullptr, true);
+            case masonc::parser::EXPR_BINARY: {
+                masonc::parser::expression* declaration = &input_parser->expression_at(expr->binary.left);
+
+                if (expr->binary.op_code != OP_EQUALS.op_code ||
+                    declaration->type != masonc::parser::EXPR_VAR_DECLARATION)
+                {
+                    report_convert_error("Only declarations are allowed at the top level of a module.");
+                    return nullptr;
+                }
+
+                return convert_global_variable(&declaration->variable_declaration,
+                    &input_parser->expression_at(expr->binary.right), true);
+            }
             case masonc::parser::EXPR_PROC_PROTOTYPE:
-                return convert_procedure_prototype(&expr->value.procedure_prototype.value);
+                return convert_procedure_prototype(&expr->procedure_prototype);
             case masonc::parser::EXPR_PROC_DEFINITION:
-                return convert_procedure(&expr->value.procedure_definition.value);
+                if (!convert_definitions) {
+                    return convert_procedure_prototype(
+                        &input_parser->expression_at(expr->procedure_definition.prototype).procedure_prototype);
+                }
+
+                return convert_procedure(&expr->procedure_definition);
         }
     }
 
     LLVMValueRef llvm_converter::convert_statement(masonc::parser::expression* expr, LLVMValueRef llvm_function)
     {
-        if(expr->value.empty.type == masonc::parser::EXPR_VAR_DECLARATION)
-            return convert_local_variable(&expr->value.variable_declaration.value, llvm_function);
-        else if(expr->value.empty.type == masonc::parser::EXPR_PROC_CALL)
-            return convert_call(&expr->value.procedure_call.value);
+        switch (expr->type) {
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                return convert_local_variable(&expr->variable_declaration, llvm_function);
+            case masonc::parser::EXPR_PROC_CALL:
+                return convert_call(&expr->procedure_call);
+            case masonc::parser::EXPR_BINARY: {
+                masonc::parser::expression* declaration = &input_parser->expression_at(expr->binary.left);
+
+                if (expr->binary.op_code != OP_EQUALS.op_code ||
+                    declaration->type != masonc::parser::EXPR_VAR_DECLARATION)
+                {
+                    break;
+                }
 
-        global_logger.log_error(
-            std::string{ "Cannot generate code for expression of type " +
-            std::to_string(expr->value.empty.type) }.c_str()
-        );
+                LLVMValueRef llvm_variable = convert_local_variable(&declaration->variable_declaration,
+                    llvm_function);
 
-        return nullptr;
+                if (llvm_variable == nullptr)
+                    return nullptr;
+
+                LLVMValueRef llvm_value = build_cast(
+                    convert_expression(&input_parser->expression_at(expr->binary.right)),
+                    LLVMGetAllocatedType(llvm_variable));
+
+                if (llvm_value == nullptr)
+                    return nullptr;
+
+                return LLVMBuildStore(llvm_builder, llvm_value, llvm_variable);
+            }
+            default:
+                break;
+        }
+
+        // The parser keeps no expression for "return", any other statement is the value that is returned.
+        return convert_return(convert_expression(expr), llvm_function);
     }
 
-    LLVMValueRef llvm_converter::convert_expression(masonc::parser::expression* expr)
+    LLVMValueRef llvm_converter::convert_return(LLVMValueRef llvm_value, LLVMValueRef llvm_function)
     {
-        if (expr->value.empty.type == masonc::parser::EXPR_BINARY ||
-            expr->value.empty.type == masonc::parser::EXPR_PARENTHESES)
-        {
-            return convert_term(expr);
+        if (llvm_value == nullptr)
+            return nullptr;
+
+        LLVMTypeRef llvm_return_type = LLVMGetReturnType(LLVMGlobalGetValueType(llvm_function));
+
+        if (LLVMGetTypeKind(llvm_return_type) == LLVMVoidTypeKind) {
+            report_convert_error("A procedure without a return type cannot return a value.");
+            return nullptr;
         }
 
-        return convert_primary(expr);
+        LLVMValueRef llvm_return_value = build_cast(llvm_value, llvm_return_type);
+        if (llvm_return_value == nullptr)
+            return nullptr;
+
+        procedure_returned = true;
+        return LLVMBuildRet(llvm_builder, llvm_return_value);
+    }
+
+    LLVMValueRef llvm_converter::convert_expression(masonc::parser::expression* expr)
+    {
+        masonc::parser::expression_binary* binary = masonc::parser::get_binary_expression(expr);
+        if (binary == nullptr)
+            return convert_primary(expr);
+
+        // The parser already applied operator precedence,
+        // so operands are evaluated before the operation that uses them.
+        LLVMValueRef llvm_left = convert_expression(&input_parser->expression_at(binary->left));
+        LLVMValueRef llvm_right = convert_expression(&input_parser->expression_at(binary->right));
+
+        if (llvm_left == nullptr || llvm_right == nullptr)
+            return nullptr;
+
+        return convert_binary(binary->op_code, llvm_left, llvm_right);
     }
 
     LLVMValueRef llvm_converter::convert_primary(masonc::parser::expression* expr)
     {
-        /*
-        switch (expr->value.empty.type) {
+        switch (expr->type) {
             default:
+                report_convert_error("Cannot generate code for expression of type " +
+                    std::to_string(expr->type) + ".");
                 return nullptr;
-            case EXPR_UNARY:
-                switch(expr->value.unary.value.op_code) {
+            case masonc::parser::EXPR_UNARY:
+                switch (expr->unary.op_code) {
                     default:
-                        // TODO: Report error.
+                        report_convert_error("Unknown unary operator \"" +
+                            std::string{ static_cast<char>(expr->unary.op_code) } + "\".");
                         return nullptr;
                     case '&':
-                        return convert_reference_of(expr->value.unary.value.expr);
+                        return convert_reference_of(&input_parser->expression_at(expr->unary.expr));
                     case '^':
-                        return convert_dereference(expr->value.unary.value.expr);
+                        return convert_dereference(&input_parser->expression_at(expr->unary.expr));
                 }
-            case EXPR_REFERENCE:
-                return convert_reference(&expr->value.reference.value);
-            case EXPR_NUMBER_LITERAL:
-                return convert_number_literal(&expr->value.number.value);
-            case EXPR_STRING_LITERAL:
+            case masonc::parser::EXPR_REFERENCE:
+                return convert_reference(&expr->reference);
+            case masonc::parser::EXPR_NUMBER_LITERAL:
+                return convert_number_literal(&expr->number);
+            case masonc::parser::EXPR_STRING_LITERAL:
                 // TODO: Implement string literal.
+                report_convert_error("String literals cannot be converted yet.");
                 return nullptr;
-            case EXPR_PROC_CALL:
-                return convert_call(&expr->value.procedure_call.value);
+            case masonc::parser::EXPR_PROC_CALL:
+                return convert_call(&expr->procedure_call);
         }
-        */
-        return nullptr;
     }
 
     LLVMValueRef llvm_converter::convert_number_literal(masonc::parser::expression_number_literal* expr)
     {
-        /*
+        std::string_view value = input_parser->number_value(*expr);
+
         switch (expr->type) {
             default:
-                // TODO: Report error.
+                report_convert_error("Unknown number literal type.");
                 return nullptr;
-            case NUMBER_INTEGER:
+            case masonc::parser::NUMBER_INTEGER:
                 // Const integer literals have 64 bit precision.
                 return LLVMConstIntOfStringAndSize(
-                    LLVMInt64Type(),
-                    expr->value,
-                    static_cast<unsigned int>(expr->value_length),
+                    LLVMInt64TypeInContext(context->context),
+                    value.data(),
+                    static_cast<unsigned int>(value.length()),
                     10u
                 );
-            case NUMBER_DECIMAL:
+            case masonc::parser::NUMBER_DECIMAL:
                 // Const decimal literals have 64 bit precision.
                 return LLVMConstRealOfStringAndSize(
-                    LLVMDoubleType(),
-                    expr->value,
-                    static_cast<unsigned int>(expr->value_length)
+                    LLVMDoubleTypeInContext(context->context),
+                    value.data(),
+                    static_cast<unsigned int>(value.length())
                 );
         }
-        */
-        return nullptr;
     }
 
     LLVMValueRef llvm_converter::convert_local_variable(masonc::parser::expression_variable_declaration* expr,
         LLVMValueRef llvm_function)
     {
-        /*
-        LLVMTypeRef llvm_variable_type;
+        LLVMTypeRef llvm_type = llvm_variable_type(expr);
+        if (llvm_type == nullptr)
+            return nullptr;
 
-        if(expr->is_pointer)
-            llvm_variable_type = llvm_pointer_type(llvm_type_by_name(expr->));
-        else
-            llvm_variable_type = llvm_type_by_name(expr->type_name);
+        std::string name{ global_interner.at(expr->name_handle) };
+        LLVMValueRef llvm_variable = build_alloca_at_entry(llvm_function, llvm_type, name.c_str());
 
-        return build_alloca_at_entry(llvm_function, llvm_variable_type, expr->name.name.c_str());
-        */
-        return nullptr;
+        local_variables.insert_or_assign(expr->name_handle, llvm_variable);
+
+        return llvm_variable;
+    }
+
+    LLVMValueRef llvm_converter::variable_pointer(symbol name)
+    {
+        auto find_it = local_variables.find(name);
+        if (find_it != local_variables.end())
+            return find_it->second;
+
+        std::string name_text{ global_interner.at(name) };
+
+        LLVMValueRef llvm_global = LLVMGetNamedGlobal(output->llvm_module, name_text.c_str());
+        if (llvm_global != nullptr)
+            return llvm_global;
+
+        llvm_global = declare_external(name);
+
+        if (llvm_global == nullptr || !LLVMIsAGlobalVariable(llvm_global)) {
+            report_convert_error("Variable \"" + name_text + "\" is not declared.");
+            return nullptr;
+        }
+
+        return llvm_global;
+    }
+
+    LLVMTypeRef llvm_converter::variable_type(LLVMValueRef llvm_pointer)
+    {
+        if (LLVMIsAAllocaInst(llvm_pointer))
+            return LLVMGetAllocatedType(llvm_pointer);
+
+        return LLVMGlobalGetValueType(llvm_pointer);
     }
 
     LLVMValueRef llvm_converter::convert_reference(masonc::parser::expression_reference* expr)
     {
-        return nullptr;
+        LLVMValueRef llvm_pointer = variable_pointer(expr->name_handle);
+        if (llvm_pointer == nullptr)
+            return nullptr;
+
+        return LLVMBuildLoad2(llvm_builder, variable_type(llvm_pointer), llvm_pointer, "loadtmp");
     }
 
-    LLVMValueRef llvm_converter::convert_reference_of(LLVMValueRef llvm_value,
-        LLVMValueRef llvm_pointer)
+    LLVMValueRef llvm_converter::convert_reference_of(masonc::parser::expression* expr)
     {
-        return LLVMBuildStore(llvm_builder, llvm_value, llvm_pointer);
+        if (expr->type != masonc::parser::EXPR_REFERENCE) {
+            report_convert_error("Only the address of a variable can be taken.");
+            return nullptr;
+        }
+
+        return variable_pointer(expr->reference.name_handle);
     }
 
     LLVMValueRef llvm_converter::convert_dereference(masonc::parser::expression* expr)
     {
-        /*
-        return LLVMBuildLoad2(llvm_builder,
-            LLVMTypeRef Ty, LLVMValueRef PointerVal, const char *Name);
-            */
-        return nullptr;
+        LLVMValueRef llvm_pointer = convert_expression(expr);
+        if (llvm_pointer == nullptr)
+            return nullptr;
+
+        LLVMTypeRef llvm_pointer_type = LLVMTypeOf(llvm_pointer);
+
+        if (LLVMGetTypeKind(llvm_pointer_type) != LLVMPointerTypeKind) {
+            report_convert_error("Only pointers can be dereferenced.");
+            return nullptr;
+        }
+
+        return LLVMBuildLoad2(llvm_builder, LLVMGetElementType(llvm_pointer_type), llvm_pointer, "loadtmp");
+    }
+
+    LLVMValueRef llvm_converter::convert_global_variable(const masonc::parser::expression_variable_declaration* expr,
+        masonc::parser::expression* value, bool define)
+    {
+        std::string name{ global_interner.at(expr->name_handle) };
+
+        LLVMValueRef llvm_global = LLVMGetNamedGlobal(output->llvm_module, name.c_str());
+        if (llvm_global != nullptr)
+            return llvm_global;
+
+        LLVMTypeRef llvm_type = llvm_variable_type(expr);
+        if (llvm_type == nullptr)
+            return nullptr;
+
+        llvm_global = LLVMAddGlobal(output->llvm_module, llvm_type, name.c_str());
+
+        // Without an initializer, the global is only declared and defined by another object.
+        if (!define)
+            return llvm_global;
+
+        LLVMValueRef llvm_initializer = LLVMConstNull(llvm_type);
+
+        if (value != nullptr) {
+            if (value->type != masonc::parser::EXPR_NUMBER_LITERAL) {
+                report_convert_error("Global variable \"" + name + "\" can only be initialized with a number.");
+                return nullptr;
+            }
+
+            // Casting a constant gives a constant, nothing is inserted into a block.
+            llvm_initializer = build_cast(convert_number_literal(&value->number), llvm_type);
+            if (llvm_initializer == nullptr)
+                return nullptr;
+        }
+
+        LLVMSetInitializer(llvm_global, llvm_initializer);
+
+        return llvm_global;
     }
 
     LLVMValueRef llvm_converter::convert_call(masonc::parser::expression_procedure_call* expr)
     {
-        /*
-        LLVMValueRef llvm_function = LLVMGetNamedFunction(output->llvm_module, expr->name.name.c_str());
+        std::string name{ global_interner.at(expr->name_handle) };
+
+        LLVMValueRef llvm_function = LLVMGetNamedFunction(output->llvm_module, name.c_str());
+
+        if (llvm_function == nullptr)
+            llvm_function = declare_external(expr->name_handle);
+
+        if (llvm_function == nullptr || !LLVMIsAFunction(llvm_function)) {
+            report_convert_error("Procedure \"" + name + "\" is not declared.");
+            return nullptr;
+        }
 
-        // No error checking because the linker should have figured out already if
-        // the function is visible from here or not.
-        LLVMTypeRef llvm_function_type = output->function_type_map[expr->name.name];
+        LLVMTypeRef llvm_function_type = LLVMGlobalGetValueType(llvm_function);
+        u32 parameter_count = LLVMCountParamTypes(llvm_function_type);
 
-        u64 args_count = expr->argument_list.size();
-        LLVMValueRef* args = static_cast<LLVMValueRef*>(alloca(sizeof(LLVMValueRef) * args_count));
+        if (parameter_count != expr->argument_list.count) {
+            report_convert_error("Procedure \"" + name + "\" takes " + std::to_string(parameter_count) +
+                " arguments, but " + std::to_string(expr->argument_list.count) + " are passed.");
+
+            return nullptr;
+        }
+
+        std::vector<LLVMTypeRef> llvm_parameter_types(parameter_count);
+        LLVMGetParamTypes(llvm_function_type, llvm_parameter_types.data());
+
+        std::vector<LLVMValueRef> llvm_arguments;
+        llvm_arguments.reserve(parameter_count);
+
+        for (u32 i = 0; i < parameter_count; i += 1) {
+            LLVMValueRef llvm_argument = build_cast(
+                convert_expression(&input_parser->expression_at(input_parser->list_at(expr->argument_list, i))),
+                llvm_parameter_types[i]);
+
+            if (llvm_argument == nullptr)
+                return nullptr;
 
-        for(u64 i = 0; i < args_count; i += 1) {
-            args[i] = convert_expression(&expr->argument_list[i]);
+            llvm_arguments.push_back(llvm_argument);
         }
 
-        // Overflow check before casting `args_count` from `u64` to `unsigned int`
-        std::numeric_limits<unsigned int> unsigned_int_limit;
-        assume(unsigned_int_limit.max() >= args_count);
+        // Calls that return nothing cannot be named.
+        bool returns_void = LLVMGetTypeKind(LLVMGetReturnType(llvm_function_type)) == LLVMVoidTypeKind;
 
         return LLVMBuildCall2(
             llvm_builder,
             llvm_function_type,
             llvm_function,
-            args,
-            static_cast<unsigned int>(args_count),
-            ""
+            llvm_arguments.data(),
+            parameter_count,
+            returns_void ? "" : "calltmp"
         );
-        */
-       return nullptr;
     }
 
     LLVMValueRef llvm_converter::convert_procedure(masonc::parser::expression_procedure_definition* expr)
     {
-        LLVMValueRef llvm_function = convert_procedure_prototype(&expr->prototype);
+        LLVMValueRef llvm_function = convert_procedure_prototype(
+            &input_parser->expression_at(expr->prototype).procedure_prototype);
+
+        if (llvm_function == nullptr)
+            return nullptr;
+
         convert_procedure_body(llvm_function, expr);
 
         return llvm_function;
     }
 
-    LLVMValueRef llvm_converter::convert_procedure_prototype(masonc::parser::expression_procedure_prototype* expr)
+    LLVMValueRef llvm_converter::declare_external(symbol name)
     {
-        /*
-        std::vector<LLVMTypeRef> llvm_argument_types;
+        std::optional<declaration> found;
 
-        for (u64 i = 0; i < expr->argument_list.size(); i += 1)
-        {
-            expression_variable_declaration* arg =
-                &expr->argument_list[i].value.variable_declaration.value;
-
-            LLVMTypeRef llvm_arg_type = llvm_type_by_name(arg->type_name);
-            if (llvm_arg_type == nullptr)
-            {
-                global_logger.log_error(
-                    std::string{ "Argument type '" + arg->type_name +
-                    "' could not be found" }.c_str()
-                );
-
-                return nullptr;
-            }
+        if (declarations != nullptr) {
+            found = declarations->find(global_interner.intern(input_parser->module_name), name);
 
-            llvm_argument_types.push_back(llvm_arg_type);
+            if (!found)
+                found = declarations->find_imported(input_parser, name);
         }
 
-        LLVMTypeRef llvm_return_type = llvm_type_by_name(expr->return_type_name);
-        if (llvm_return_type == nullptr)
-        {
-            global_logger.log_error(
-                std::string{ "Return type '" + expr->return_type_name +
-                "' could not be found" }.c_str()
-            );
-
+        if (!found) {
+            output->unresolved_names = true;
             return nullptr;
         }
 
-        // Overflow check before casting "llvm_argument_types.size()" from "size_t" to "unsigned int".
-        std::numeric_limits<unsigned int> unsigned_int_limit;
-        assume(unsigned_int_limit.max() >= llvm_argument_types.size());
-
-        LLVMTypeRef llvm_function_type = LLVMFunctionType(
-            llvm_return_type,
-            llvm_argument_types.data(),
-            static_cast<unsigned int>(llvm_argument_types.size()),
-            false
-        );
+        const masonc::parser::parser_instance_output* module = found->module;
+        const masonc::parser::expression& expr = module->expression_at(module->AST[found->top_level_index]);
 
-        output->function_type_map.insert(std::make_pair(expr->name.name, llvm_function_type));
+        switch (expr.type) {
+            default:
+                return nullptr;
+            case masonc::parser::EXPR_PROC_PROTOTYPE:
+                return declare_procedure(module, &expr.procedure_prototype);
+            case masonc::parser::EXPR_PROC_DEFINITION:
+                return declare_procedure(module,
+                    &module->expression_at(expr.procedure_definition.prototype).procedure_prototype);
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                return convert_global_variable(&expr.variable_declaration, nullptr, false);
+            case masonc::parser::EXPR_BINARY:
+                // The initializer is part of the definition in the other file.
+                return convert_global_variable(&module->expression_at(expr.binary.left).variable_declaration,
+                    nullptr, false);
+        }
+    }
 
-        return LLVMAddFunction(output->llvm_module, expr->name.name.c_str(), llvm_function_type);
-        */
-       return nullptr;
+    LLVMValueRef llvm_converter::convert_procedure_prototype(masonc::parser::expression_procedure_prototype* expr)
+    {
+        return declare_procedure(input_parser, expr);
     }
 
-    void llvm_converter::convert_procedure_body(LLVMValueRef llvm_function,
-        masonc::parser::expression_procedure_definition* expr)
+    LLVMValueRef llvm_converter::declare_procedure(const masonc::parser::parser_instance_output* module,
+        const masonc::parser::expression_procedure_prototype* expr)
     {
-        LLVMBasicBlockRef llvm_function_block = LLVMAppendBasicBlock(llvm_function, "entry");
-        LLVMPositionBuilderAtEnd(llvm_builder, llvm_function_block);
+        std::string name{ global_interner.at(expr->name_handle) };
 
-        // Generate IR for all statements in the procedure's body.
-        for(size_t i = 0; i < expr->body.size(); i += 1) {
-            convert_statement(&expr->body[i], llvm_function);
-        }
+        // Declared already, by "declare_module_scope" or by an earlier prototype.
+        LLVMValueRef llvm_function = LLVMGetNamedFunction(output->llvm_module, name.c_str());
+        if (llvm_function != nullptr)
+            return llvm_function;
 
-        // Generate terminator for basic block.
-        LLVMValueRef llvm_return = LLVMBuildRetVoid(llvm_builder);
+        std::vector<LLVMTypeRef> llvm_argument_types;
 
-        assume(LLVMVerifyFunction(llvm_function, LLVMPrintMessageAction),
-            "LLVM function verification failed.");
-    }
+        for (u32 i = 0; i < expr->argument_list.count; i += 1) {
+            const masonc::parser::expression& argument =
+                module->expression_at(module->list_at(expr->argument_list, i));
 
-    LLVMValueRef llvm_converter::convert_binary(s8 op_code, LLVMValueRef left, LLVMValueRef right)
-    {
-        // TODO: Type checking
-        switch(op_code) {
-            default:
-                // TODO: Report error
+            LLVMTypeRef llvm_argument_type = llvm_variable_type(&argument.variable_declaration);
+            if (llvm_argument_type == nullptr)
                 return nullptr;
-            case '=':
 
-                break;
-            case '+':
-                return LLVMBuildAdd(llvm_builder, left, right, "addtmp");
-            case '-':
-                return LLVMBuildSub(llvm_builder, left, right, "subtmp");
-            case '*':
-                return LLVMBuildMul(llvm_builder, left, right, "multmp");
-            case '/':
-                return LLVMBuildSDiv(llvm_builder, left, right, "divtmp");
+            llvm_argument_types.push_back(llvm_argument_type);
         }
-    }
 
-    LLVMValueRef llvm_converter::convert_term(masonc::parser::expression* term_start)
-    {
-        std::vector<term_element> infix;
-        std::vector<term_element> RPN;
+        LLVMTypeRef llvm_return_type = LLVMVoidTypeInContext(context->context);
 
-        ast_to_infix(term_start, infix);
-        RPN = infix_to_RPN(infix);
+        if (expr->return_type_handle) {
+            llvm_return_type = llvm_type_by_name(expr->return_type_handle.value());
 
-        while(RPN.size() > 1) {
-            for(u64 i = 0; i < RPN.size(); i += 1) {
-                term_element& element = RPN[i];
+            if (llvm_return_type == nullptr) {
+                report_convert_error("Return type \"" +
+                    std::string{ global_interner.at(expr->return_type_handle.value()) } + "\" does not exist.");
 
-                if(element.type == term_element::VARIANT_OP) {
-                    term_element& left = RPN[i - 2];
-                    term_element& right = RPN[i - 1];
+                return nullptr;
+            }
+        }
 
-                    LLVMValueRef llvm_left;
-                    LLVMValueRef llvm_right;
+        LLVMTypeRef llvm_function_type = LLVMFunctionType(
+            llvm_return_type,
+            llvm_argument_types.data(),
+            static_cast<unsigned int>(llvm_argument_types.size()),
+            false
+        );
 
-                    // Operands either have to be evaluated or already have been evaluated.
-                    if(left.type == term_element::VARIANT_PRIMARY)
-                        llvm_left = convert_primary(left.expr);
-                    else
-                        llvm_left = left.llvm_value;
+        output->function_type_map.insert_or_assign(name, llvm_function_type);
 
-                    if(right.type == term_element::VARIANT_PRIMARY)
-                        llvm_right = convert_primary(right.expr);
-                    else
-                        llvm_right = right.llvm_value;
+        llvm_function = LLVMAddFunction(output->llvm_module, name.c_str(), llvm_function_type);
 
-                    // Evaluate binary operation.
-                    LLVMValueRef llvm_binary_result = convert_binary(element.op->op_code,
-                        llvm_left, llvm_right);
+        // Tells callers, among them "llvm_jit", how a returned integer is extended to the width of a register.
+        if (LLVMGetTypeKind(llvm_return_type) == LLVMIntegerTypeKind) {
+            bool is_unsigned = context->unsigned_types.find(expr->return_type_handle.value()) !=
+                context->unsigned_types.end();
 
-                    // Change the variant of the operator to our LLVM value result and
-                    // remove the now evaluated left and right operands.
-                    element.type = term_element::VARIANT_LLVM_VALUE;
-                    element.llvm_value = llvm_binary_result;
-                    RPN.erase(RPN.begin() + i - 2, RPN.begin() + i);
+            std::string_view attribute_name = is_unsigned ? "zeroext" : "signext";
+            LLVMAttributeRef llvm_attribute = LLVMCreateEnumAttribute(context->context,
+                LLVMGetEnumAttributeKindForName(attribute_name.data(), attribute_name.length()), 0);
 
-                    break;
-                }
-            }
+            LLVMAddAttributeAtIndex(llvm_function, LLVMAttributeReturnIndex, llvm_attribute);
         }
 
-        // The last remaining element is the result of the chain of binary operations.
-        return RPN[0].llvm_value;
+        return llvm_function;
     }
 
-    void llvm_converter::ast_to_infix(masonc::parser::expression* term_start, std::vector<term_element>& term)
+    void llvm_converter::convert_procedure_body(LLVMValueRef llvm_function,
+        masonc::parser::expression_procedure_definition* expr)
     {
-        masonc::parser::expression_binary* expr;
+        LLVMBasicBlockRef llvm_function_block = LLVMAppendBasicBlockInContext(context->context,
+            llvm_function, "entry");
+        LLVMPositionBuilderAtEnd(llvm_builder, llvm_function_block);
+
+        local_variables.clear();
+        procedure_returned = false;
 
-        if(term_start->value.empty.type == masonc::parser::EXPR_BINARY) {
-            expr = &term_start->value.binary.value;
+        // A statement that failed to convert may have been the return, which is not reported again.
+        u64 body_error_count = output->messages.errors.size();
 
-            // Left-hand side
-            ast_to_infix(expr->left, term);
+        const masonc::parser::expression_procedure_prototype& prototype =
+            input_parser->expression_at(expr->prototype).procedure_prototype;
 
-            // Operator
-            term_element op;
-            op.type = term_element::VARIANT_OP;
-            op.op = expr->op;
-            term.push_back(op);
+        // Arguments are copied into local variables, so that their address can be taken like any other.
+        for (u32 i = 0; i < prototype.argument_list.count; i += 1) {
+            masonc::parser::expression& argument =
+                input_parser->expression_at(input_parser->list_at(prototype.argument_list, i));
 
-            // Right-hand side
-            ast_to_infix(expr->right, term);
+            LLVMValueRef llvm_variable = convert_local_variable(&argument.variable_declaration, llvm_function);
+            LLVMBuildStore(llvm_builder, LLVMGetParam(llvm_function, i), llvm_variable);
         }
-        else if (term_start->value.empty.type == masonc::parser::EXPR_PARENTHESES) {
-            expr = &term_start->value.parentheses.value.expr;
 
-            // "("
-            term_element parenthesis_begin;
-            parenthesis_begin.type = term_element::VARIANT_PARENTHESIS_BEGIN;
-            term.push_back(parenthesis_begin);
+        bool returns_value =
+            LLVMGetTypeKind(LLVMGetReturnType(LLVMGlobalGetValueType(llvm_function))) != LLVMVoidTypeKind;
 
-            // Left-hand side
-            ast_to_infix(expr->left, term);
+        // Generate IR for all statements in the procedure's body, nothing after a return is reached.
+        for (u32 i = 0; i < expr->body.count && !procedure_returned; i += 1) {
+            masonc::parser::expression* statement = &input_parser->expression_at(input_parser->list_at(expr->body, i));
 
-            // Operator
-            term_element op;
-            op.type = term_element::VARIANT_OP;
-            op.op = expr->op;
-            term.push_back(op);
+            // The parser keeps no expression for "return", so "return f(x);" looks like the call "f(x);".
+            // As the last statement of a procedure that returns a value, a call that returns one can only
+            // be its return value, since the procedure would not return anything otherwise.
+            if (returns_value && i + 1 == expr->body.count && statement->type == masonc::parser::EXPR_PROC_CALL) {
+                LLVMValueRef llvm_value = convert_call(&statement->procedure_call);
 
-            // Right-hand side
-            ast_to_infix(expr->right, term);
+                if (llvm_value != nullptr && LLVMGetTypeKind(LLVMTypeOf(llvm_value)) != LLVMVoidTypeKind)
+                    convert_return(llvm_value, llvm_function);
+
+                continue;
+            }
 
-            // ")"
-            term_element parenthesis_end;
-            parenthesis_end.type = term_element::VARIANT_PARENTHESIS_END;
-            term.push_back(parenthesis_end);
+            convert_statement(statement, llvm_function);
         }
-        else {
-            term_element primary;
-            primary.type = term_element::VARIANT_PRIMARY;
-            primary.expr = term_start;
-            term.push_back(primary);
+
+        // Generate terminator for basic block.
+        if (!procedure_returned) {
+            if (!returns_value) {
+                LLVMBuildRetVoid(llvm_builder);
+            }
+            else {
+                if (output->messages.errors.size() == body_error_count) {
+                    report_convert_error("Procedure \"" + std::string{ global_interner.at(prototype.name_handle) } +
+                        "\" does not return a value.");
+                }
+
+                // Keeps the function valid, it is never compiled because of the error.
+                LLVMBuildUnreachable(llvm_builder);
+            }
         }
     }
 
-    std::vector<term_element> llvm_converter::infix_to_RPN(
-        const std::vector<term_element>& term)
+    LLVMValueRef llvm_converter::convert_binary(s8 op_code, LLVMValueRef left, LLVMValueRef right)
     {
-        // https://en.wikipedia.org/wiki/Shunting-yard_algorithm
-        // https://en.wikipedia.org/wiki/Reverse_Polish_notation
+        LLVMTypeRef llvm_left_type = LLVMTypeOf(left);
+        LLVMTypeRef llvm_right_type = LLVMTypeOf(right);
 
-        std::vector<term_element> output_queue;
-        std::vector<term_element> operator_stack;
+        LLVMTypeKind left_kind = LLVMGetTypeKind(llvm_left_type);
+        LLVMTypeKind right_kind = LLVMGetTypeKind(llvm_right_type);
 
-        for(u64 i = 0; i < term.size(); i += 1) {
-            const term_element& element = term[i];
+        bool left_real = left_kind == LLVMFloatTypeKind || left_kind == LLVMDoubleTypeKind;
+        bool right_real = right_kind == LLVMFloatTypeKind || right_kind == LLVMDoubleTypeKind;
 
-            if(element.type == term_element::VARIANT_PRIMARY) {
-                output_queue.push_back(element);
-            }
-            else if(element.type == term_element::VARIANT_OP) {
-                while(operator_stack.size() > 0 &&
-                      operator_stack.back().type != term_element::VARIANT_PARENTHESIS_BEGIN &&
-                      operator_stack.back().op->precedence >= element.op->precedence)
-                {
-                    output_queue.push_back(operator_stack.back());
-                    operator_stack.pop_back();
-                }
+        if ((!left_real && left_kind != LLVMIntegerTypeKind) || (!right_real && right_kind != LLVMIntegerTypeKind)) {
+            report_convert_error("Operator \"" + std::string{ static_cast<char>(op_code) } +
+                "\" can only be used with numbers.");
 
-                operator_stack.push_back(element);
-            }
-            else if(element.type == term_element::VARIANT_PARENTHESIS_BEGIN) {
-                operator_stack.push_back(element);
-            }
-            else if(element.type == term_element::VARIANT_PARENTHESIS_END) {
-                u64 j = operator_stack.size() - 1;
-
-                while(operator_stack[j].type != term_element::VARIANT_PARENTHESIS_BEGIN) {
-                    output_queue.push_back(operator_stack[j]);
-                    operator_stack.pop_back();
+            return nullptr;
+        }
 
-                    j -= 1;
-                    //if(j < 0) {
-                        // Mismatched parentheses
-                    //}
-                }
+        // Both operands are converted to the wider of their types, integers to a real if the other one is.
+        LLVMTypeRef llvm_type = llvm_left_type;
 
-                // Discard the left parenthesis.
-                operator_stack.pop_back();
-            }
+        if (left_real != right_real) {
+            llvm_type = left_real ? llvm_left_type : llvm_right_type;
         }
-
-        // Push remaining operators onto the output queue.
-        for(u64 i = 0; i < operator_stack.size(); i += 1) {
-            output_queue.push_back(operator_stack[i]);
+        else if (left_real) {
+            if (right_kind == LLVMDoubleTypeKind)
+                llvm_type = llvm_right_type;
+        }
+        else if (LLVMGetIntTypeWidth(llvm_right_type) > LLVMGetIntTypeWidth(llvm_left_type)) {
+            llvm_type = llvm_right_type;
         }
 
-        return output_queue;
-    }
+        left = build_cast(left, llvm_type);
+        right = build_cast(right, llvm_type);
 
-    void llvm_converter::print_term(const std::vector<term_element>& term)
-    {
-        std::cout << std::endl;
-        for (u64 i = 0; i < term.size(); i += 1) {
-            const term_element& element = term[i];
-            switch (element.type) {
-                case term_element::VARIANT_OP:
-                    std::cout << static_cast<char>(element.op->op_code) << " ";
-                    break;
-                case term_element::VARIANT_PRIMARY:
-                    std::cout << element.expr->value.number.value.value << " ";
-                    break;
-                case term_element::VARIANT_PARENTHESIS_BEGIN:
-                    std::cout << "( ";
-                    break;
-                case term_element::VARIANT_PARENTHESIS_END:
-                    std::cout << ") ";
-                    break;
-                case term_element::VARIANT_LLVM_VALUE:
-                    std::cout << "LLVMValueRef ";
-                    break;
-            }
+        bool real = left_real || right_real;
+
+        switch(op_code) {
+            default:
+                report_convert_error("Operator \"" + std::string{ static_cast<char>(op_code) } +
+                    "\" cannot be used here.");
+
+                return nullptr;
+            case '+':
+                return real ? LLVMBuildFAdd(llvm_builder, left, right, "addtmp") :
+                    LLVMBuildAdd(llvm_builder, left, right, "addtmp");
+            case '-':
+                return real ? LLVMBuildFSub(llvm_builder, left, right, "subtmp") :
+                    LLVMBuildSub(llvm_builder, left, right, "subtmp");
+            case '*':
+                return real ? LLVMBuildFMul(llvm_builder, left, right, "multmp") :
+                    LLVMBuildMul(llvm_builder, left, right, "multmp");
+            case '/':
+                return real ? LLVMBuildFDiv(llvm_builder, left, right, "divtmp") :
+                    LLVMBuildSDiv(llvm_builder, left, right, "divtmp");
         }
-        std::cout << std::endl;
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <parser.hpp>
 #include <message.hpp>
+#include <symbol_table.hpp>
 
 #include <llvm-c/Core.h>
 #include <llvm-c/Analysis.h>
@@ -12,29 +13,24 @@
 
 namespace masonc::llvm
 {
-    inline robin_hood::unordered_map<const char*, LLVMTypeRef> type_map;
+    // An LLVM context with the built-in types in it. Nothing in one context may be used from another,
+    // so every thread that generates code owns one and converts any number of modules with it.
+    // Modules converted in a context have to be disposed before the context.
+    struct llvm_context
+    {
+        llvm_context();
+        ~llvm_context();
 
-    void initialize_llvm_converter();
+        llvm_context(const llvm_context& other) = delete;
+        llvm_context& operator=(const llvm_context& other) = delete;
 
-    // A term element is either a primary expression, a binary operator token, a parenthesis token
-    // or an evaluated LLVM value reference.
-    struct term_element
-    {
-        enum
-        {
-            VARIANT_PRIMARY,
-            VARIANT_OP,
-            VARIANT_PARENTHESIS_BEGIN,
-            VARIANT_PARENTHESIS_END,
-            VARIANT_LLVM_VALUE
-        } type;
-
-        union
-        {
-            masonc::parser::expression* expr;
-            const binary_operator* op;
-            LLVMValueRef llvm_value;
-        };
+        LLVMContextRef context;
+
+        // Built-in types by their interned name.
+        robin_hood::unordered_map<string_id, LLVMTypeRef> type_map;
+
+        // Interned names of the built-in integer types that are zero-extended, all others are sign-extended.
+        robin_hood::unordered_flat_set<string_id> unsigned_types;
     };
 
     struct llvm_converter_output
@@ -44,26 +40,50 @@ namespace masonc::llvm
 
         LLVMModuleRef llvm_module;
         message_list messages;
+
+        // Set if a name was found neither in the file nor in "declarations". Converting the module again
+        // once more files are parsed may find it, see "llvm_converter::convert".
+        bool unresolved_names = false;
     };
 
     // The struct layout models the layout of the parser closely.
     // See the parser header for documentation about the terminology
     // and what each function generates.
     //
-    // Many converter functions can return "nullptr" on error,
-    // though that should not be happening if the parser finished successfully.
+    // Many converter functions can return "nullptr" on error, which they report in the output.
+    //
+    // Procedures, global variables initialized with numbers, local variables, arithmetic,
+    // pointers and calls are converted. Strings cannot be converted yet. Procedures and global variables
+    // of other files of the module and of imported modules are declared in the LLVM module when used.
     //
     // "llvm_converter" is responsible for IR generation of a specific module.
+    // Every mason module is converted into an LLVM module of its own, named after it,
+    // so modules can be converted in parallel as long as each thread uses its own "llvm_context".
     struct llvm_converter
     {
-        void convert(masonc::lexer::lexer_instance_output* input_lexer, masonc::parser::parser_instance_output* input_parser,
-            llvm_converter_output* output);
+        // If "procedure_definitions" is false, procedures defined in the module are only declared,
+        // because they are converted on their own with "convert_procedure_definition".
+        //
+        // Names that the file does not declare are looked up in "declarations", first in the module
+        // of the file and then in the modules it imports. Without "declarations", they are errors.
+        void convert(llvm_context* context, masonc::lexer::lexer_instance_output* input_lexer,
+            masonc::parser::parser_instance_output* input_parser, llvm_converter_output* output,
+            bool procedure_definitions = true, const symbol_table* declarations = nullptr);
+
+        // Converts only the procedure definition "definition" into an LLVM module of its own,
+        // named after the module and the procedure. Whatever it calls is only declared,
+        // so the result is the same no matter how the rest of the module changes.
+        void convert_procedure_definition(llvm_context* context, masonc::lexer::lexer_instance_output* input_lexer,
+            masonc::parser::parser_instance_output* input_parser, masonc::parser::expression_handle definition,
+            llvm_converter_output* output, const symbol_table* declarations = nullptr);
 
         void free();
 
         void print_IR();
 
     private:
+        llvm_context* context;
+
         masonc::lexer::lexer_instance_output* input_lexer;
         masonc::parser::parser_instance_output* input_parser;
         llvm_converter_output* output;
@@ -71,18 +91,48 @@ namespace masonc::llvm
         LLVMBuilderRef llvm_builder;
         LLVMBuilderRef llvm_sub_builder;
 
+        // See "convert".
+        bool convert_definitions = true;
+        const symbol_table* declarations = nullptr;
+
+        // Stack slots of the arguments and local variables of the procedure that is converted.
+        robin_hood::unordered_flat_map<symbol, LLVMValueRef> local_variables;
+
+        // Whether the procedure that is converted returned already.
+        bool procedure_returned = false;
+
+        void begin_module(llvm_context* context, masonc::lexer::lexer_instance_output* input_lexer,
+            masonc::parser::parser_instance_output* input_parser, llvm_converter_output* output,
+            const std::string& module_name);
+
+        // Declares every procedure and global variable of the module, so that they can be used
+        // before they are defined. Global variables are only defined if "define_globals" is true.
+        void declare_module_scope(bool define_globals);
+
+        // Reports an error if the converted module is not valid LLVM IR.
+        void verify_module();
+
+        void report_convert_error(const std::string& msg);
+
         // TODO: Add stuff here.
         void add_built_in_procedures();
 
         // Returns 'nullptr' if type was not found.
-        LLVMTypeRef llvm_type_by_name(const char* type_name);
+        LLVMTypeRef llvm_type_by_name(string_id type_name);
         LLVMTypeRef llvm_pointer_type(LLVMTypeRef llvm_element_type);
 
+        // Returns "nullptr" and reports an error if the type of "expr" was not found.
+        LLVMTypeRef llvm_variable_type(const masonc::parser::expression_variable_declaration* expr);
+
         LLVMValueRef build_alloca_at_entry(LLVMValueRef llvm_function,
             LLVMTypeRef llvm_variable_type, const char* variable_name);
 
+        // Converts "llvm_value" to "llvm_type", integers are treated as signed.
+        LLVMValueRef build_cast(LLVMValueRef llvm_value, LLVMTypeRef llvm_type);
+
         LLVMValueRef convert_top_level(masonc::parser::expression* expr);
         LLVMValueRef convert_statement(masonc::parser::expression* expr, LLVMValueRef llvm_function);
+        LLVMValueRef convert_return(LLVMValueRef llvm_value, LLVMValueRef llvm_function);
 
         LLVMValueRef convert_expression(masonc::parser::expression* expr);
         LLVMValueRef convert_primary(masonc::parser::expression* expr);
@@ -92,32 +142,40 @@ namespace masonc::llvm
         LLVMValueRef convert_local_variable(masonc::parser::expression_variable_declaration* expr,
             LLVMValueRef llvm_function);
 
+        // Local variable or global variable named "name".
+        LLVMValueRef variable_pointer(symbol name);
+        LLVMTypeRef variable_type(LLVMValueRef llvm_pointer);
+
         LLVMValueRef convert_reference(masonc::parser::expression_reference* expr);
 
-        LLVMValueRef convert_reference_of(LLVMValueRef llvm_value, LLVMValueRef llvm_pointer);
+        LLVMValueRef convert_reference_of(masonc::parser::expression* expr);
         LLVMValueRef convert_dereference(masonc::parser::expression* expr);
 
-        // TODO: Implement this
-        LLVMValueRef convert_global_variable(masonc::parser::expression_variable_declaration* expr);
+        // Initialized with "value" if it is not "nullptr", which has to be a number literal,
+        // or else with zero. Only declared if "define" is false.
+        LLVMValueRef convert_global_variable(const masonc::parser::expression_variable_declaration* expr,
+            masonc::parser::expression* value, bool define);
+
+        // Declares the procedure or global variable "name" of another file, found in "declarations".
+        // Returns "nullptr" and sets "llvm_converter_output::unresolved_names" if it is not found.
+        LLVMValueRef declare_external(symbol name);
 
         LLVMValueRef convert_call(masonc::parser::expression_procedure_call* expr);
 
         LLVMValueRef convert_procedure(masonc::parser::expression_procedure_definition* expr);
+
         LLVMValueRef convert_procedure_prototype(masonc::parser::expression_procedure_prototype* expr);
 
+        // Declares the procedure of the prototype "expr" of "module", which may be another file than the input.
+        // A returned integer is marked "zeroext" if its type is in "llvm_context::unsigned_types"
+        // and "signext" otherwise, like C compilers do, which is also what "llvm_jit" extends it by.
+        LLVMValueRef declare_procedure(const masonc::parser::parser_instance_output* module,
+            const masonc::parser::expression_procedure_prototype* expr);
+
         void convert_procedure_body(LLVMValueRef llvm_function,
             masonc::parser::expression_procedure_definition* expr);
 
         LLVMValueRef convert_binary(s8 op_code, LLVMValueRef left, LLVMValueRef right);
-        LLVMValueRef convert_term(masonc::parser::expression* term_start);
-
-        // Transform a tree of binary operations into a list that resembles infix notation.
-        void ast_to_infix(masonc::parser::expression* term_start, std::vector<term_element>& term);
-
-        // Transform a term from infix notation to reverse polish notation (shunting yard algorithm).
-        std::vector<term_element> infix_to_RPN(const std::vector<term_element>& term);
-
-        void print_term(const std::vector<term_element>& term);
     };
 }
 
@@ -0,0 +1,147 @@
+#include <llvm_emitter.hpp>
+
+#include <algorithm>
+
+namespace masonc::llvm
+{
+    void initialize_llvm_emitter()
+    {
+        LLVMInitializeNativeTarget();
+        LLVMInitializeNativeAsmPrinter();
+    }
+
+    llvm_emitter::llvm_emitter(u32 optimization_level)
+    {
+        optimization_level = std::min(optimization_level, MAX_OPTIMIZATION_LEVEL);
+
+        target_triple = LLVMGetDefaultTargetTriple();
+
+        LLVMTargetRef target;
+        char* message = nullptr;
+
+        if (LLVMGetTargetFromTriple(target_triple, &target, &message)) {
+            last_error = std::string{ "No target for \"" } + target_triple + "\": " + message;
+            LLVMDisposeMessage(message);
+            return;
+        }
+
+        char* cpu = LLVMGetHostCPUName();
+        char* features = LLVMGetHostCPUFeatures();
+
+        // "LLVMCodeGenOptLevel" counts like optimization levels do.
+        target_machine = LLVMCreateTargetMachine(target, target_triple, cpu, features,
+            static_cast<LLVMCodeGenOptLevel>(optimization_level), LLVMRelocPIC, LLVMCodeModelDefault);
+
+        m_configuration = std::string{ target_triple } + " " + cpu + " " + features + " O" +
+            std::to_string(optimization_level);
+
+        LLVMDisposeMessage(features);
+        LLVMDisposeMessage(cpu);
+
+        if (!target_machine) {
+            last_error = std::string{ "Could not create a target machine for \"" } + target_triple + "\".";
+            return;
+        }
+
+        data_layout = LLVMCreateTargetDataLayout(target_machine);
+
+        // The same passes run on every module, so they are set up once.
+        LLVMPassManagerBuilderRef pass_builder = LLVMPassManagerBuilderCreate();
+        LLVMPassManagerBuilderSetOptLevel(pass_builder, optimization_level);
+
+        if (optimization_level > 1)
+            LLVMPassManagerBuilderUseInlinerWithThreshold(pass_builder, 225);
+
+        module_passes = LLVMCreatePassManager();
+        LLVMPassManagerBuilderPopulateModulePassManager(pass_builder, module_passes);
+        LLVMPassManagerBuilderDispose(pass_builder);
+    }
+
+    llvm_emitter::~llvm_emitter()
+    {
+        if (module_passes)
+            LLVMDisposePassManager(module_passes);
+
+        if (data_layout)
+            LLVMDisposeTargetData(data_layout);
+
+        if (target_machine)
+            LLVMDisposeTargetMachine(target_machine);
+
+        if (target_triple)
+            LLVMDisposeMessage(target_triple);
+    }
+
+    bool llvm_emitter::is_valid() const
+    {
+        return target_machine != nullptr;
+    }
+
+    const std::string& llvm_emitter::error() const
+    {
+        return last_error;
+    }
+
+    const std::string& llvm_emitter::configuration() const
+    {
+        return m_configuration;
+    }
+
+    std::optional<archive_member> llvm_emitter::emit(LLVMModuleRef module, const std::string& member_name)
+    {
+        if (!is_valid())
+            return std::nullopt;
+
+        LLVMSetTarget(module, target_triple);
+        LLVMSetModuleDataLayout(module, data_layout);
+
+        LLVMRunPassManager(module_passes, module);
+
+        char* message = nullptr;
+        LLVMMemoryBufferRef object = nullptr;
+
+        if (LLVMTargetMachineEmitToMemoryBuffer(target_machine, module, LLVMObjectFile, &message, &object)) {
+            last_error = "Could not emit \"" + member_name + "\": " + message;
+            LLVMDisposeMessage(message);
+            return std::nullopt;
+        }
+
+        archive_member member{
+            member_name,
+            std::string{ LLVMGetBufferStart(object), LLVMGetBufferSize(object) },
+            defined_symbols(module)
+        };
+
+        LLVMDisposeMemoryBuffer(object);
+        return member;
+    }
+
+    std::vector<std::string> llvm_emitter::defined_symbols(LLVMModuleRef module) const
+    {
+        std::vector<std::string> symbols;
+
+        auto add_if_defined = [&](LLVMValueRef value) {
+            LLVMLinkage linkage = LLVMGetLinkage(value);
+
+            if (LLVMIsDeclaration(value) || linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage)
+                return;
+
+            size_t name_length = 0;
+            const char* name = LLVMGetValueName2(value, &name_length);
+
+            symbols.emplace_back(name, name_length);
+        };
+
+        for (LLVMValueRef function = LLVMGetFirstFunction(module); function;
+            function = LLVMGetNextFunction(function))
+        {
+            add_if_defined(function);
+        }
+
+        for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+            add_if_defined(global);
+        }
+
+        return symbols;
+    }
+}
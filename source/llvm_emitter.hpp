@@ -0,0 +1,64 @@
+#ifndef MASONC_LLVM_EMITTER_HPP
+#define MASONC_LLVM_EMITTER_HPP
+
+#include <common.hpp>
+#include <archive.hpp>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassManagerBuilder.h>
+
+#include <string>
+#include <optional>
+
+namespace masonc::llvm
+{
+    // Highest optimization level, like "-O3".
+    constexpr u32 MAX_OPTIMIZATION_LEVEL = 3;
+
+    // Registers the native target with LLVM. Call once before any "llvm_emitter" is created.
+    void initialize_llvm_emitter();
+
+    // Optimizes LLVM modules and compiles them into object files for the native target.
+    //
+    // A target machine may only be used by one thread at a time, so every thread
+    // that emits objects owns an "llvm_emitter" and emits any number of modules with it.
+    struct llvm_emitter
+    {
+        // "optimization_level" is clamped to "MAX_OPTIMIZATION_LEVEL".
+        explicit llvm_emitter(u32 optimization_level);
+        ~llvm_emitter();
+
+        llvm_emitter(const llvm_emitter& other) = delete;
+        llvm_emitter& operator=(const llvm_emitter& other) = delete;
+
+        // Returns false if there is no target machine for the host, see "error".
+        bool is_valid() const;
+
+        // Why the emitter is not valid or why the last "emit" failed.
+        const std::string& error() const;
+
+        // Target, CPU and optimization level, which together with a module decide what "emit" compiles it into.
+        const std::string& configuration() const;
+
+        // Runs the optimization passes on "module" and compiles it into an object file,
+        // which is returned as an archive member named "member_name" together with the symbols
+        // the module defines. Returns an empty optional on failure, see "error".
+        std::optional<archive_member> emit(LLVMModuleRef module, const std::string& member_name);
+
+    private:
+        LLVMTargetMachineRef target_machine = nullptr;
+        LLVMTargetDataRef data_layout = nullptr;
+        LLVMPassManagerRef module_passes = nullptr;
+
+        char* target_triple = nullptr;
+        std::string last_error;
+        std::string m_configuration;
+
+        // Names of the functions and global variables that "module" defines and other objects can use.
+        std::vector<std::string> defined_symbols(LLVMModuleRef module) const;
+    };
+}
+
+#endif
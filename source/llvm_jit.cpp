@@ -0,0 +1,180 @@
+#include <llvm_jit.hpp>
+
+#include <string_view>
+
+namespace masonc::llvm
+{
+    llvm_jit::llvm_jit()
+    {
+        char* target_triple = LLVMGetDefaultTargetTriple();
+
+        LLVMTargetRef target;
+        char* message = nullptr;
+
+        if (LLVMGetTargetFromTriple(target_triple, &target, &message)) {
+            last_error = std::string{ "No target for \"" } + target_triple + "\": " + message;
+            LLVMDisposeMessage(message);
+            LLVMDisposeMessage(target_triple);
+            return;
+        }
+
+        char* cpu = LLVMGetHostCPUName();
+        char* features = LLVMGetHostCPUFeatures();
+
+        // Optimizing would take longer than a script usually runs.
+        LLVMTargetMachineRef target_machine = LLVMCreateTargetMachine(target, target_triple, cpu, features,
+            LLVMCodeGenLevelNone, LLVMRelocDefault, LLVMCodeModelJITDefault);
+
+        LLVMDisposeMessage(features);
+        LLVMDisposeMessage(cpu);
+
+        if (!target_machine) {
+            last_error = std::string{ "Could not create a target machine for \"" } + target_triple + "\".";
+            LLVMDisposeMessage(target_triple);
+            return;
+        }
+
+        LLVMDisposeMessage(target_triple);
+
+        // Makes the symbols of this process visible to "resolve_symbol".
+        LLVMLoadLibraryPermanently(nullptr);
+
+        // The JIT stack owns the target machine from here on.
+        jit_stack = LLVMOrcCreateInstance(target_machine);
+    }
+
+    llvm_jit::~llvm_jit()
+    {
+        if (jit_stack)
+            check(LLVMOrcDisposeInstance(jit_stack));
+    }
+
+    bool llvm_jit::is_valid() const
+    {
+        return jit_stack != nullptr;
+    }
+
+    const std::string& llvm_jit::error() const
+    {
+        return last_error;
+    }
+
+    bool llvm_jit::add_module(LLVMModuleRef module)
+    {
+        // The module cannot be looked at once it is added, procedures are split off of it when called.
+        for (LLVMValueRef function = LLVMGetFirstFunction(module); function != nullptr;
+            function = LLVMGetNextFunction(function))
+        {
+            if (LLVMIsDeclaration(function))
+                continue;
+
+            LLVMTypeRef function_type = LLVMGlobalGetValueType(function);
+            LLVMTypeRef return_type = LLVMGetReturnType(function_type);
+
+            procedure_signature signature{ LLVMCountParamTypes(function_type), std::nullopt, false };
+
+            if (LLVMGetTypeKind(return_type) == LLVMVoidTypeKind) {
+                signature.return_bits = 0;
+            }
+            else if (LLVMGetTypeKind(return_type) == LLVMIntegerTypeKind) {
+                signature.return_bits = LLVMGetIntTypeWidth(return_type);
+
+                std::string_view zero_extend_name = "zeroext";
+                signature.zero_extend = LLVMGetEnumAttributeAtIndex(function, LLVMAttributeReturnIndex,
+                    LLVMGetEnumAttributeKindForName(zero_extend_name.data(), zero_extend_name.length())) != nullptr;
+            }
+
+            size_t name_length;
+            const char* name = LLVMGetValueName2(function, &name_length);
+
+            procedures.insert_or_assign(std::string{ name, name_length }, signature);
+        }
+
+        LLVMOrcModuleHandle handle;
+        return check(LLVMOrcAddLazilyCompiledIR(jit_stack, &handle, module, &resolve_symbol, this));
+    }
+
+    std::optional<s64> llvm_jit::run(const std::string& procedure_name)
+    {
+        auto find_it = procedures.find(procedure_name);
+
+        if (find_it == procedures.end()) {
+            last_error = "Procedure \"" + procedure_name + "\" does not exist.";
+            return std::nullopt;
+        }
+
+        const procedure_signature& signature = find_it->second;
+
+        if (signature.argument_count != 0 || !signature.return_bits || signature.return_bits.value() > 64) {
+            last_error = "Procedure \"" + procedure_name + "\" has to take no arguments "
+                "and return nothing or an integer to be run.";
+            return std::nullopt;
+        }
+
+        char* mangled_name;
+        LLVMOrcGetMangledSymbol(jit_stack, &mangled_name, procedure_name.c_str());
+
+        // Compiles the procedure, what it calls is compiled when it is first called.
+        LLVMOrcTargetAddress address = 0;
+        bool found = check(LLVMOrcGetSymbolAddress(jit_stack, &address, mangled_name));
+
+        LLVMOrcDisposeMangledSymbol(mangled_name);
+
+        if (!found || address == 0) {
+            if (found)
+                last_error = "Procedure \"" + procedure_name + "\" could not be compiled.";
+
+            return std::nullopt;
+        }
+
+        u32 return_bits = signature.return_bits.value();
+
+        if (return_bits == 0) {
+            reinterpret_cast<void(*)()>(address)();
+            return 0;
+        }
+
+        u64 value;
+
+        if (return_bits <= 32) {
+            value = static_cast<u32>(reinterpret_cast<s32(*)()>(address)());
+        }
+        else {
+            value = static_cast<u64>(reinterpret_cast<s64(*)()>(address)());
+        }
+
+        // Bits above the width of the returned integer are not relied on, they are set here.
+        if (return_bits < 64) {
+            u64 mask = (static_cast<u64>(1) << return_bits) - 1;
+            value &= mask;
+
+            if (!signature.zero_extend && (value >> (return_bits - 1)) != 0)
+                value |= ~mask;
+        }
+
+        return static_cast<s64>(value);
+    }
+
+    bool llvm_jit::check(LLVMErrorRef error)
+    {
+        if (error == nullptr)
+            return true;
+
+        char* message = LLVMGetErrorMessage(error);
+        last_error = message;
+        LLVMDisposeErrorMessage(message);
+
+        return false;
+    }
+
+    u64 llvm_jit::resolve_symbol(const char* name, void*)
+    {
+#if defined(__APPLE__)
+        // Mangling adds an underscore that symbols of the process are not looked up with.
+        if (name[0] == '_')
+            name += 1;
+#endif
+
+        return reinterpret_cast<u64>(LLVMSearchForAddressOfSymbol(name));
+    }
+}
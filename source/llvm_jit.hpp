@@ -0,0 +1,78 @@
+#ifndef MASONC_LLVM_JIT_HPP
+#define MASONC_LLVM_JIT_HPP
+
+#include <common.hpp>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/Support.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/OrcBindings.h>
+
+#include <string>
+#include <optional>
+
+#include <robin_hood.hpp>
+
+namespace masonc::llvm
+{
+    // Compiles LLVM modules in memory with ORC and runs their procedures in this process,
+    // without writing object files or invoking a linker.
+    //
+    // Modules are compiled lazily one procedure at a time, the first time it is called,
+    // and without optimizations, so that a program starts as soon as possible.
+    // "initialize_llvm_emitter" has to be called before an "llvm_jit" is created.
+    struct llvm_jit
+    {
+        llvm_jit();
+        ~llvm_jit();
+
+        llvm_jit(const llvm_jit& other) = delete;
+        llvm_jit& operator=(const llvm_jit& other) = delete;
+
+        // Returns false if there is no target machine for the host, see "error".
+        bool is_valid() const;
+
+        // Why the JIT is not valid or why the last "add_module" or "run" failed.
+        const std::string& error() const;
+
+        // Adds "module", which the JIT owns from then on. Its context has to outlive the JIT.
+        // Returns false on failure, see "error".
+        bool add_module(LLVMModuleRef module);
+
+        // Compiles and calls the procedure "procedure_name", which may not take any arguments,
+        // and returns what it returns, or 0 if it returns nothing. Integers narrower than 64 bits
+        // are zero-extended if their return value is marked "zeroext" and sign-extended otherwise.
+        // Returns an empty optional if the procedure was not found or cannot be called, see "error".
+        std::optional<s64> run(const std::string& procedure_name);
+
+    private:
+        LLVMOrcJITStackRef jit_stack = nullptr;
+        std::string last_error;
+
+        // What "run" needs to know to call a procedure.
+        struct procedure_signature
+        {
+            u32 argument_count;
+
+            // Width of the returned integer, 0 if the procedure returns nothing
+            // and empty if it returns something else.
+            std::optional<u32> return_bits;
+
+            // Whether the returned integer is marked "zeroext", it is sign-extended otherwise.
+            bool zero_extend;
+        };
+
+        // Every procedure that an added module defines, by its name.
+        robin_hood::unordered_map<std::string, procedure_signature> procedures;
+
+        // Returns false and sets "last_error" if "error" is an error, which is consumed.
+        bool check(LLVMErrorRef error);
+
+        // Called by ORC for every symbol that no added module defines,
+        // which is looked up in this process, like the C library.
+        static u64 resolve_symbol(const char* name, void* jit);
+    };
+}
+
+#endif
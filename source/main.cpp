@@ -6,8 +6,8 @@
 #include <language.hpp>
 #include <scope.hpp>
 #include <timer.hpp>
-#include <test.hpp>
 #include <llvm_converter.hpp>
+#include <llvm_emitter.hpp>
 #include <command.hpp>
 #include <version.hpp>
 #include <containers.hpp>
@@ -33,9 +33,7 @@ int main(int argc, char** argv)
     std::cin.tie(nullptr);
 
     masonc::initialize_language();
-    masonc::llvm::initialize_llvm_converter();
-
-    masonc::test::perform_all_tests();
+    masonc::llvm::initialize_llvm_emitter();
 
     // NOTE: It is apparently implementation-defined whether or not the first argument of "argv"
     //       is the program name, but almost everyone passes the program name here.
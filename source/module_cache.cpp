@@ -0,0 +1,507 @@
+#include <module_cache.hpp>
+
+#include <version.hpp>
+#include <io.hpp>
+#include <logger.hpp>
+#include <interner.hpp>
+
+#include <robin_hood.hpp>
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+namespace masonc::cache
+{
+    using masonc::parser::expression;
+
+    // "MASONCMC" in a little-endian integer, tells entries apart from other files.
+    static constexpr u64 ENTRY_MAGIC = 0x434d434e4f53414d;
+
+    // Written at the start of every entry, followed by the arrays in the order of "store".
+    struct entry_header
+    {
+        u64 magic;
+        u64 key;
+        u64 input_size;
+        u64 full_parse_expression_count;
+
+        // Of everything after the header, so that a damaged entry is not mistaken for a valid one.
+        u64 contents_hash;
+
+        u32 format_version;
+        u8 tab_size;
+        bool skipped_top_level;
+    };
+
+    // "masonc::lexer::string_value" without "std::optional", so that its layout is fixed.
+    struct entry_string_value
+    {
+        masonc::lexer::source_span span;
+
+        // "NO_ESCAPED_INDEX" if the string has no escape sequences.
+        u64 escaped_index;
+    };
+
+    static constexpr u64 NO_ESCAPED_INDEX = std::numeric_limits<u64>::max();
+
+    // Every array starts at a multiple of this in the entry, which is mapped at a page boundary,
+    // so arrays can be read in place.
+    static constexpr u64 ENTRY_ALIGNMENT = 8;
+
+    template <typename T>
+    static void write_array(std::string* entry, const T* values, u64 count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        entry->append(reinterpret_cast<const char*>(&count), sizeof(count));
+        entry->append(reinterpret_cast<const char*>(values), count * sizeof(T));
+        entry->append((ENTRY_ALIGNMENT - entry->size() % ENTRY_ALIGNMENT) % ENTRY_ALIGNMENT, '\0');
+    }
+
+    template <typename T>
+    static void write_array(std::string* entry, const std::vector<T>& values)
+    {
+        write_array(entry, values.data(), values.size());
+    }
+
+    // Writes "count" strings, returned by "string_at" for each index, as their lengths and their characters.
+    template <typename F>
+    static void write_strings(std::string* entry, u64 count, F string_at)
+    {
+        std::vector<u32> lengths;
+        lengths.reserve(count);
+
+        std::string characters;
+
+        for (u64 i = 0; i < count; i += 1) {
+            std::string_view str = string_at(i);
+
+            lengths.push_back(static_cast<u32>(str.length()));
+            characters += str;
+        }
+
+        write_array(entry, lengths);
+        write_array(entry, characters.data(), characters.length());
+    }
+
+    // Reads an entry front to back. Every read checks the size that is left,
+    // so a truncated or damaged entry is rejected instead of read out of bounds.
+    struct entry_reader
+    {
+        const char* position;
+        const char* end;
+
+        template <typename T>
+        bool read_value(T* value)
+        {
+            if (static_cast<u64>(end - position) < sizeof(T))
+                return false;
+
+            std::memcpy(value, position, sizeof(T));
+            position += sizeof(T);
+
+            return true;
+        }
+
+        // Points "values" to the array in the entry instead of copying it.
+        template <typename T>
+        bool read_array(const T** values, u64* count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            static_assert(ENTRY_ALIGNMENT % alignof(T) == 0);
+
+            if (!read_value(count) || *count > static_cast<u64>(end - position) / sizeof(T))
+                return false;
+
+            *values = reinterpret_cast<const T*>(position);
+
+            u64 size = *count * sizeof(T);
+            size += (ENTRY_ALIGNMENT - size % ENTRY_ALIGNMENT) % ENTRY_ALIGNMENT;
+
+            position += std::min<u64>(size, static_cast<u64>(end - position));
+            return true;
+        }
+
+        template <typename T>
+        bool read_array(std::vector<T>* values)
+        {
+            const T* array;
+            u64 count;
+
+            if (!read_array(&array, &count))
+                return false;
+
+            values->assign(array, array + count);
+            return true;
+        }
+
+        // Calls "on_string" with each string that "write_strings" wrote.
+        template <typename F>
+        bool read_strings(F on_string)
+        {
+            const u32* lengths;
+            u64 count;
+            const char* characters;
+            u64 character_count;
+
+            if (!read_array(&lengths, &count) || !read_array(&characters, &character_count))
+                return false;
+
+            u64 offset = 0;
+
+            for (u64 i = 0; i < count; i += 1) {
+                if (lengths[i] > character_count - offset)
+                    return false;
+
+                on_string(std::string_view{ characters + offset, lengths[i] });
+                offset += lengths[i];
+            }
+
+            return true;
+        }
+    };
+
+    // Calls "on_id" with a pointer to each string ID in "expr".
+    template <typename F>
+    static void for_each_string_id(expression* expr, F on_id)
+    {
+        switch (expr->type) {
+            default:
+                break;
+
+            case masonc::parser::EXPR_REFERENCE:
+                on_id(&expr->reference.name_handle);
+                break;
+
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                on_id(&expr->variable_declaration.name_handle);
+                on_id(&expr->variable_declaration.type_handle);
+                break;
+
+            case masonc::parser::EXPR_PROC_PROTOTYPE:
+                on_id(&expr->procedure_prototype.name_handle);
+
+                if (expr->procedure_prototype.return_type_handle)
+                    on_id(&expr->procedure_prototype.return_type_handle.value());
+                break;
+
+            case masonc::parser::EXPR_PROC_CALL:
+                on_id(&expr->procedure_call.name_handle);
+                break;
+        }
+    }
+
+    static bool has_messages(const message_list& messages)
+    {
+        return !messages.messages.empty() || !messages.warnings.empty() || !messages.errors.empty();
+    }
+
+    // Reads the entry of "input" into "output", returns false if it does not match "input"
+    // or is damaged, in which case "output" is partly filled.
+    static bool read_entry(const mapped_file& entry, u64 key, const char* input, u64 input_size,
+        masonc::parser::parser_instance_output* output)
+    {
+        masonc::lexer::lexer_instance_output* lexer_output = &output->lexer_output;
+        entry_reader reader{ entry.data(), entry.data() + entry.size() };
+
+        entry_header header;
+        if (!reader.read_value(&header) || header.magic != ENTRY_MAGIC || header.key != key ||
+            header.format_version != MODULE_CACHE_FORMAT_VERSION || header.input_size != input_size)
+        {
+            return false;
+        }
+
+        reader.position += (ENTRY_ALIGNMENT - sizeof(header) % ENTRY_ALIGNMENT) % ENTRY_ALIGNMENT;
+
+        if (reader.position > reader.end ||
+            robin_hood::hash_bytes(reader.position, static_cast<u64>(reader.end - reader.position)) !=
+            header.contents_hash)
+        {
+            return false;
+        }
+
+        // IDs in this run of the strings the entry's IDs are indices of.
+        std::vector<string_id> ids;
+        if (!reader.read_strings([&](std::string_view str) { ids.push_back(global_interner.intern(str)); }))
+            return false;
+
+        bool ids_valid = true;
+        auto to_global = [&](string_id* id) {
+            if (*id < ids.size()) {
+                *id = ids[*id];
+            }
+            else {
+                ids_valid = false;
+            }
+        };
+
+        lexer_output->input = input;
+        lexer_output->input_size = input_size;
+        lexer_output->tab_size = header.tab_size;
+
+        const entry_string_value* strings;
+        u64 string_count;
+
+        if (!reader.read_array(&lexer_output->token_types) ||
+            !reader.read_array(&lexer_output->token_values) ||
+            !reader.read_array(&lexer_output->token_offsets) ||
+            !reader.read_array(&lexer_output->integers) ||
+            !reader.read_array(&lexer_output->decimals) ||
+            !reader.read_array(&strings, &string_count))
+        {
+            return false;
+        }
+
+        if (lexer_output->token_values.size() != lexer_output->token_types.size() ||
+            lexer_output->token_offsets.size() != lexer_output->token_types.size())
+        {
+            return false;
+        }
+
+        for (u64 i = 0; i < lexer_output->token_types.size(); i += 1) {
+            if (lexer_output->token_types[i] == masonc::lexer::TOKEN_IDENTIFIER)
+                to_global(&lexer_output->token_values[i]);
+        }
+
+        lexer_output->strings.reserve(string_count);
+
+        for (u64 i = 0; i < string_count; i += 1) {
+            masonc::lexer::string_value& value = lexer_output->strings.emplace_back();
+            value.span = strings[i].span;
+
+            if (strings[i].escaped_index != NO_ESCAPED_INDEX)
+                value.escaped_index = strings[i].escaped_index;
+        }
+
+        if (!reader.read_strings([&](std::string_view str) {
+                lexer_output->escaped_strings.copy_back(str.data(), static_cast<u16>(str.length()));
+            }))
+        {
+            return false;
+        }
+
+        const char* module_name;
+        u64 module_name_length;
+
+        if (!reader.read_array(&module_name, &module_name_length))
+            return false;
+
+        output->module_name = std::string{ module_name, module_name_length };
+
+        if (!reader.read_strings([&](std::string_view str) {
+                output->file_module.add_import(str);
+            }))
+        {
+            return false;
+        }
+
+        if (!reader.read_array(&output->AST) ||
+            !reader.read_array(&output->AST_spans) ||
+            !reader.read_array(&output->module_symbols) ||
+            !reader.read_array(&output->expressions) ||
+            !reader.read_array(&output->expression_lists))
+        {
+            return false;
+        }
+
+        for (expression& expr : output->expressions) {
+            for_each_string_id(&expr, to_global);
+        }
+
+        for (symbol& name : output->module_symbols) {
+            to_global(&name);
+        }
+
+        if (!ids_valid)
+            return false;
+
+        output->full_parse_expression_count = header.full_parse_expression_count;
+        output->skipped_top_level = header.skipped_top_level;
+
+        // The module scope as the parser left it, see "parser_instance::set_module".
+        scope& module_scope = output->file_module.module_scope();
+        module_scope.set_module(&output->file_module);
+        module_scope.set_name(global_interner.intern(output->module_name));
+
+        for (symbol name : output->module_symbols) {
+            module_scope.add_symbol(name);
+        }
+
+        return true;
+    }
+
+    module_cache::module_cache(const std::string& directory)
+        : directory{ directory }
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        if (error) {
+            global_logger.log_error(
+                std::string{ "Unable to create cache directory '" + directory + "'" }
+                .c_str()
+            );
+        }
+    }
+
+    u64 module_cache::key(const char* input, u64 input_size)
+    {
+        u64 version_hash = robin_hood::hash_bytes(VERSION, sizeof(VERSION)) ^ MODULE_CACHE_FORMAT_VERSION;
+        return robin_hood::hash_int(robin_hood::hash_bytes(input, input_size) ^ version_hash);
+    }
+
+    bool module_cache::load(const char* input, u64 input_size,
+        masonc::parser::parser_instance_output* output) const
+    {
+        u64 entry_key = key(input, input_size);
+        std::string path = entry_path(entry_key);
+
+        // A miss is expected, "file_map" would report it as an error.
+        std::error_code error;
+        if (!std::filesystem::exists(path, error))
+            return false;
+
+        std::optional<mapped_file> entry = file_map(path.c_str());
+        if (!entry)
+            return false;
+
+        if (!read_entry(entry.value(), entry_key, input, input_size, output)) {
+            global_logger.log_warning(
+                std::string{ "Ignoring damaged cache entry '" + path + "'" }
+                .c_str()
+            );
+
+            *output = masonc::parser::parser_instance_output{};
+            return false;
+        }
+
+        return true;
+    }
+
+    bool module_cache::store(const masonc::parser::parser_instance_output& output) const
+    {
+        const masonc::lexer::lexer_instance_output& lexer_output = output.lexer_output;
+
+        if (has_messages(output.messages) || has_messages(lexer_output.messages))
+            return false;
+
+        u64 entry_key = key(lexer_output.input, lexer_output.input_size);
+
+        // String IDs are written as indices into the entry's own list of strings.
+        robin_hood::unordered_flat_map<string_id, string_id> local_ids;
+        std::vector<std::string_view> id_strings;
+
+        auto to_local = [&](string_id* id) {
+            auto inserted = local_ids.try_emplace(*id, static_cast<string_id>(id_strings.size()));
+            if (inserted.second)
+                id_strings.push_back(global_interner.at(*id));
+
+            *id = inserted.first->second;
+        };
+
+        std::vector<u32> token_values = lexer_output.token_values;
+        for (u64 i = 0; i < token_values.size(); i += 1) {
+            if (lexer_output.token_types[i] == masonc::lexer::TOKEN_IDENTIFIER)
+                to_local(&token_values[i]);
+        }
+
+        std::vector<expression> expressions = output.expressions;
+        for (expression& expr : expressions) {
+            for_each_string_id(&expr, to_local);
+        }
+
+        std::vector<symbol> module_symbols = output.module_symbols;
+        for (symbol& name : module_symbols) {
+            to_local(&name);
+        }
+
+        std::vector<entry_string_value> strings;
+        strings.reserve(lexer_output.strings.size());
+
+        for (const masonc::lexer::string_value& value : lexer_output.strings) {
+            strings.push_back(entry_string_value{ value.span, value.escaped_index.value_or(NO_ESCAPED_INDEX) });
+        }
+
+        entry_header header{};
+        header.magic = ENTRY_MAGIC;
+        header.key = entry_key;
+        header.input_size = lexer_output.input_size;
+        header.full_parse_expression_count = output.full_parse_expression_count;
+        header.format_version = MODULE_CACHE_FORMAT_VERSION;
+        header.tab_size = lexer_output.tab_size;
+        header.skipped_top_level = output.skipped_top_level;
+
+        std::string entry;
+        entry.reserve(sizeof(header) + token_values.size() * 16 + expressions.size() * sizeof(expression));
+        entry.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        entry.append((ENTRY_ALIGNMENT - entry.size() % ENTRY_ALIGNMENT) % ENTRY_ALIGNMENT, '\0');
+
+        write_strings(&entry, id_strings.size(), [&](u64 i) { return id_strings[i]; });
+
+        write_array(&entry, lexer_output.token_types);
+        write_array(&entry, token_values);
+        write_array(&entry, lexer_output.token_offsets);
+        write_array(&entry, lexer_output.integers);
+        write_array(&entry, lexer_output.decimals);
+        write_array(&entry, strings);
+
+        write_strings(&entry, lexer_output.escaped_strings.size(), [&](u64 i) {
+            return std::string_view{ lexer_output.escaped_strings.at(i), lexer_output.escaped_strings.length_at(i) };
+        });
+
+        write_array(&entry, output.module_name.data(), output.module_name.length());
+
+        const cstring_collection& import_names = output.file_module.module_import_names;
+        write_strings(&entry, import_names.size(), [&](u64 i) {
+            return std::string_view{ import_names.at(i), import_names.length_at(i) };
+        });
+
+        write_array(&entry, output.AST);
+        write_array(&entry, output.AST_spans);
+        write_array(&entry, module_symbols);
+        write_array(&entry, expressions);
+        write_array(&entry, output.expression_lists);
+
+        u64 contents_offset = sizeof(header) + (ENTRY_ALIGNMENT - sizeof(header) % ENTRY_ALIGNMENT) % ENTRY_ALIGNMENT;
+        header.contents_hash = robin_hood::hash_bytes(entry.data() + contents_offset, entry.size() - contents_offset);
+        std::memcpy(entry.data(), &header, sizeof(header));
+
+        // Written to a file of its own first and renamed, so that no other build
+        // ever sees half an entry, and threads storing the same entry do not interfere.
+        std::string path = entry_path(entry_key);
+        std::string temporary_path = path + "." +
+            std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+        std::FILE* file = std::fopen(temporary_path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        bool written = std::fwrite(entry.data(), 1, entry.size(), file) == entry.size();
+        written = std::fclose(file) == 0 && written;
+
+        std::error_code error;
+
+        if (written)
+            std::filesystem::rename(temporary_path, path, error);
+
+        if (!written || error) {
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    std::string module_cache::entry_path(u64 key) const
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+        return directory + "/" + name + ".mcache";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef MASONC_MODULE_CACHE_HPP
+#define MASONC_MODULE_CACHE_HPP
+
+#include <common.hpp>
+#include <lexer.hpp>
+#include <parser.hpp>
+
+#include <string>
+
+namespace masonc::cache
+{
+    // Increase whenever the layout of an entry, or of anything that is written into one as it is, changes.
+    constexpr u32 MODULE_CACHE_FORMAT_VERSION = 1;
+
+    // Lexer and parser outputs of source files, kept in a directory across builds.
+    //
+    // An entry is named by "key", a hash of the source file's contents, the compiler version
+    // and the format version. A changed file misses and gets an entry of its own,
+    // so entries are never out of date. Old entries are not deleted.
+    //
+    // Token stream, token values, AST and module symbols are written as the arrays they are
+    // in memory. Interned strings are written as strings and interned again when an entry
+    // is loaded, because string IDs differ between runs.
+    struct module_cache
+    {
+        // Creates "directory" if it does not exist.
+        explicit module_cache(const std::string& directory);
+
+        // Hash of a source file that names its entry.
+        static u64 key(const char* input, u64 input_size);
+
+        // Fills the empty "output" from the entry of "input" as if "input" was tokenized and parsed.
+        // Like with "lexer_instance::tokenize", "input" has to outlive "output" because
+        // token values point into it.
+        //
+        // Returns false if there is no valid entry, in which case "output" is left empty.
+        // Only the module scope is restored, procedure scopes are not needed after parsing.
+        bool load(const char* input, u64 input_size, masonc::parser::parser_instance_output* output) const;
+
+        // Writes the entry of the input that "output" was parsed from.
+        // Returns false if "output" has any messages, which are not stored,
+        // or if the entry could not be written. Can be called from several threads at once.
+        bool store(const masonc::parser::parser_instance_output& output) const;
+
+    private:
+        std::string directory;
+
+        std::string entry_path(u64 key) const;
+    };
+}
+
+#endif
\ No newline at end of file
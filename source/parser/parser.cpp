@@ -7,26 +7,57 @@
 #include <logger.hpp>
 #include <timer.hpp>
 #include <lexer.hpp>
+#include <language.hpp>
 #include <build_stage.hpp>
 
 #include <iostream>
 #include <optional>
 #include <limits>
-#include <cstring>
+#include <algorithm>
 
 namespace masonc::parser
 {
+    expression& parser_instance_output::expression_at(expression_handle handle)
+    {
+        return expressions[handle];
+    }
+
+    const expression& parser_instance_output::expression_at(expression_handle handle) const
+    {
+        return expressions[handle];
+    }
+
+    expression_handle parser_instance_output::list_at(expression_range range, u32 index) const
+    {
+        return expression_lists[range.first + index];
+    }
+
+    std::string_view parser_instance_output::number_value(const expression_number_literal& number) const
+    {
+        if (number.type == NUMBER_INTEGER)
+            return lexer_output.integer_at(number.value_index);
+
+        return lexer_output.decimal_at(number.value_index);
+    }
+
+    std::string_view parser_instance_output::string_value(const expression_string_literal& str) const
+    {
+        return lexer_output.string_at(str.value_index);
+    }
+
     void parser_instance_output::free()
     {
-        for (u64 i = 0; i < delete_list_expressions.size(); i += 1) {
-            delete delete_list_expressions[i];
-        }
+        AST = std::vector<expression_handle>{};
+        AST_spans = std::vector<top_level_span>{};
+        module_symbols = std::vector<symbol>{};
+        expressions = std::vector<expression>{};
+        expression_lists = std::vector<expression_handle>{};
     }
 
     void parser_instance_output::print_expressions()
     {
         for (u64 i = 0; i < AST.size(); i += 1) {
-            std::cout << format_expression(AST[i]) << std::endl;
+            std::cout << format_expression(expression_at(AST[i])) << std::endl;
         }
     }
 
@@ -37,10 +68,7 @@ namespace masonc::parser
             message += "    ";
         }
 
-        // This is safe because no matter the current variant,
-        // it is guaranteed to be at the same address
-        // (and type is the first member in tagged expression struct).
-        switch (expr.value.empty.type) {
+        switch (expr.type) {
             default:
                 message += "Unknown Expression";
                 break;
@@ -51,60 +79,60 @@ namespace masonc::parser
 
             case EXPR_UNARY:
                 message += "Unary Expression: Op_Code='"
-                        + std::to_string(expr.value.unary.value.op_code) + "'"
-                        + "\n" + format_expression(*expr.value.unary.value.expr, level + 1);
+                        + std::to_string(expr.unary.op_code) + "'"
+                        + "\n" + format_expression(expression_at(expr.unary.expr), level + 1);
                 break;
 
             case EXPR_BINARY:
                 message += "Binary Expression: Op_Code='"
-                        + std::to_string(expr.value.binary.value.op->op_code) + "'"
-                        + "\n" + format_expression(*expr.value.binary.value.left, level + 1)
-                        + "\n" + format_expression(*expr.value.binary.value.right, level + 1);
+                        + std::to_string(expr.binary.op_code) + "'"
+                        + "\n" + format_expression(expression_at(expr.binary.left), level + 1)
+                        + "\n" + format_expression(expression_at(expr.binary.right), level + 1);
                 break;
 
             case EXPR_PARENTHESES:
                 message += "Parentheses Expression: Op_Code='"
-                        + std::to_string(expr.value.parentheses.value.expr.op->op_code) + "'"
-                        + "\n" + format_expression(*expr.value.parentheses.value.expr.left, level + 1)
-                        + "\n" + format_expression(*expr.value.parentheses.value.expr.right, level + 1);
+                        + std::to_string(expr.parentheses.expr.op_code) + "'"
+                        + "\n" + format_expression(expression_at(expr.parentheses.expr.left), level + 1)
+                        + "\n" + format_expression(expression_at(expr.parentheses.expr.right), level + 1);
                 break;
 
             case EXPR_NUMBER_LITERAL:
                 message += "Number Literal: Value='";
-                message += expr.value.number.value.value;
+                message += number_value(expr.number);
                 message += "'";
                 break;
 
             case EXPR_STRING_LITERAL:
                 message += "String Literal: Value='";
-                message += expr.value.str.value.value;
+                message += string_value(expr.str);
                 message += "'";
                 break;
 
             case EXPR_REFERENCE:
                 message += "Reference: Name='";
-                //message += expr.value.reference.value.name;
+                //message += expr.reference.name;
                 message += "'";
                 break;
 
             case EXPR_VAR_DECLARATION:
                 message += "Variable Declaration: Name='";
-                //message += expr.value.variable_declaration.value.name;
+                //message += expr.variable_declaration.name;
                 message += "' Type='";
 
-                if(expr.value.variable_declaration.value.is_pointer)
+                if(expr.variable_declaration.is_pointer)
                     message += "^";
 
-                //message += expr.value.variable_declaration.value.type_name;
+                //message += expr.variable_declaration.type_name;
                 message += "'";
 
-                if(expr.value.variable_declaration.value.specifiers != SPECIFIER_NONE) {
+                if(expr.variable_declaration.specifiers != SPECIFIER_NONE) {
                     message += " Specifiers='";
 
-                    if(expr.value.variable_declaration.value.specifiers & SPECIFIER_CONST)
+                    if(expr.variable_declaration.specifiers & SPECIFIER_CONST)
                         message += "const ";
 
-                    if(expr.value.variable_declaration.value.specifiers & SPECIFIER_MUT)
+                    if(expr.variable_declaration.specifiers & SPECIFIER_MUT)
                         message += "mut ";
 
                     message += "'";
@@ -114,58 +142,54 @@ namespace masonc::parser
 
             case EXPR_PROC_PROTOTYPE:
                 message += "Procedure Prototype Expression: Name='";
-                //message += expr.value.procedure_prototype.value.name;
+                //message += expr.procedure_prototype.name;
                 message += "' Return Type='";
-                //message += expr.value.procedure_prototype.value.return_type_name;
+                //message += expr.procedure_prototype.return_type_name;
                 message += "'";
 
-                if (expr.value.procedure_prototype.value.argument_list.size() > 0)
+                if (expr.procedure_prototype.argument_list.count > 0)
                     message += "\nArgument List: ";
 
-                for (u64 i = 0; i < expr.value.procedure_prototype.value.argument_list.size(); i += 1) {
+                for (u32 i = 0; i < expr.procedure_prototype.argument_list.count; i += 1) {
                     message += "\n" + format_expression(
-                        expr.value.procedure_prototype.value.argument_list[i], level + 1
+                        expression_at(list_at(expr.procedure_prototype.argument_list, i)), level + 1
                     );
                 }
                 break;
 
             case EXPR_PROC_DEFINITION:
-                message += format_expression(
-                    expression{ expr.value.procedure_definition.value.prototype }, level
-                );
+                message += format_expression(expression_at(expr.procedure_definition.prototype), level);
 
-                if (expr.value.procedure_definition.value.body.size() > 0)
+                if (expr.procedure_definition.body.count > 0)
                     message += "\nBody: ";
 
-                for (u64 i = 0; i < expr.value.procedure_definition.value.body.size(); i += 1) {
+                for (u32 i = 0; i < expr.procedure_definition.body.count; i += 1) {
                     message += "\n" + format_expression(
-                        expr.value.procedure_definition.value.body[i], level + 1);
+                        expression_at(list_at(expr.procedure_definition.body, i)), level + 1);
                 }
                 break;
 
             case EXPR_PROC_CALL:
                 message += "Procedure Call Expression: Name='";
-                //message += expr.value.procedure_call.value.name;
+                //message += expr.procedure_call.name;
                 message += "'";
 
-                for (u64 i = 0; i < expr.value.procedure_call.value.argument_list.size(); i += 1) {
+                for (u32 i = 0; i < expr.procedure_call.argument_list.count; i += 1) {
                     message += "\n" + format_expression(
-                        expr.value.procedure_call.value.argument_list[i], level + 1
+                        expression_at(list_at(expr.procedure_call.argument_list, i)), level + 1
                     );
                 }
                 break;
 
             case EXPR_MODULE_DECLARATION:
                 message += "Module Declaration: Name='";
-                message += expr.value.module_declaration.value.name;
+                message += module_name;
                 message += "'";
                 break;
 
             case EXPR_MODULE_IMPORT:
                 message += "Module Import: Name='";
-                message += file_module.module_import_names.at(
-                    expr.value.module_import.value.import_index);
-
+                message += file_module.module_import_names.at(expr.module_import.import_index);
                 message += "'";
                 break;
         }
@@ -177,11 +201,33 @@ namespace masonc::parser
     {
         this->parser_output = parser_output;
 
+        parse_all();
+
+        parser_output->full_parse_expression_count = parser_output->expressions.size();
+        replaced_top_level = top_level_edit{ 0, 0, parser_output->AST.size() };
+    }
+
+    parser_instance::parser_instance(masonc::parser::parser_instance_output* parser_output,
+        const masonc::lexer::token_edit& edit)
+    {
+        this->parser_output = parser_output;
+
+        if (!reparse(edit))
+            reparse_all();
+    }
+
+    top_level_edit parser_instance::replaced() const
+    {
+        return replaced_top_level;
+    }
+
+    void parser_instance::parse_all()
+    {
         //this->token_index = 0;
         //this->done = false;
 
         // The first statement must be a module declaration.
-        auto module_identifier_result = expect("module");
+        auto module_identifier_result = expect_keyword(KEYWORD_MODULE);
         if (!module_identifier_result) {
             return;
         }
@@ -192,18 +238,171 @@ namespace masonc::parser
             return;
         }
 
-        parser_output->AST.push_back(module_declaration_result.value());
+        add_top_level(module_declaration_result.value(), 0, 0);
 
         // Drive the parser.
         drive();
     }
 
+    void parser_instance::reparse_all()
+    {
+        u64 removed_count = parser_output->AST.size();
+
+        parser_output->module_name.clear();
+        parser_output->file_module = mod{};
+
+        parser_output->AST.clear();
+        parser_output->AST_spans.clear();
+        parser_output->module_symbols.clear();
+        parser_output->expressions.clear();
+        parser_output->expression_lists.clear();
+        parser_output->messages = message_list{};
+        parser_output->skipped_top_level = false;
+
+        token_index = 0;
+        done = false;
+        list_stack.clear();
+
+        parse_all();
+
+        parser_output->full_parse_expression_count = parser_output->expressions.size();
+        replaced_top_level = top_level_edit{ 0, removed_count, parser_output->AST.size() };
+    }
+
+    bool parser_instance::reparse(const masonc::lexer::token_edit& edit)
+    {
+        std::vector<expression_handle>& AST = parser_output->AST;
+        std::vector<top_level_span>& spans = parser_output->AST_spans;
+
+        if (parser_output->messages.errors.size() > 0 || parser_output->skipped_top_level || spans.empty() ||
+            parser_output->expressions.size() > parser_output->full_parse_expression_count * 2)
+        {
+            return false;
+        }
+
+        const s64 token_shift = static_cast<s64>(edit.inserted_count) - static_cast<s64>(edit.removed_count);
+        const u64 new_damage_end = edit.first_token + edit.inserted_count;
+
+        // The expression with the first replaced token. Expressions before it
+        // end before the edit and are parsed the same as before.
+        u64 first = static_cast<u64>(std::upper_bound(spans.begin(), spans.end(), edit.first_token,
+            [](u64 token, const top_level_span& span) { return token < span.first_token; }) - spans.begin()) - 1;
+
+        // The module declaration names the module that everything else is in.
+        if (first == 0)
+            return false;
+
+        // Expressions that begin in replaced tokens are replaced as well.
+        u64 end = first + 1;
+        while (end < spans.size() && spans[end].first_token < edit.first_token + edit.removed_count) {
+            end += 1;
+        }
+
+        for (u64 i = first; i < end; i += 1) {
+            remove_module_symbols(spans[i]);
+        }
+
+        std::vector<expression_handle> parsed_AST;
+        std::vector<top_level_span> parsed_spans;
+
+        current_scope_handle = MODULE_SCOPE_HANDLE;
+        token_index = spans[first].first_token;
+
+        while (true) {
+            list_stack.clear();
+
+            u64 first_token = token_index;
+            u64 first_symbol = parser_output->module_symbols.size();
+
+            auto top_level_expression = parse_top_level();
+
+            // Messages of the expressions that are kept would have to be found and moved,
+            // the errors of a full parse are simpler to get right.
+            if (parser_output->messages.errors.size() > 0)
+                return false;
+
+            if (top_level_expression) {
+                parsed_AST.push_back(top_level_expression.value());
+                parsed_spans.push_back(span_from(first_token, first_symbol));
+            }
+            else if (!done) {
+                return false;
+            }
+
+            if (done) {
+                for (u64 i = end; i < spans.size(); i += 1) {
+                    remove_module_symbols(spans[i]);
+                }
+
+                end = spans.size();
+                break;
+            }
+
+            if (token_index < new_damage_end)
+                continue;
+
+            // Old expressions that the parsed one ran into are replaced as well.
+            while (end < spans.size() && static_cast<s64>(spans[end].first_token) + token_shift <
+                static_cast<s64>(token_index))
+            {
+                remove_module_symbols(spans[end]);
+                end += 1;
+            }
+
+            // Everything after the edit is parsed the same as before.
+            if (end < spans.size() && static_cast<s64>(spans[end].first_token) + token_shift ==
+                static_cast<s64>(token_index))
+            {
+                break;
+            }
+        }
+
+        // Imports are collected in "file_module", which only a full parse keeps in step with the AST.
+        for (u64 i = first; i < end; i += 1) {
+            if (parser_output->expression_at(AST[i]).type == EXPR_MODULE_IMPORT)
+                return false;
+        }
+
+        for (expression_handle handle : parsed_AST) {
+            if (parser_output->expression_at(handle).type == EXPR_MODULE_IMPORT)
+                return false;
+        }
+
+        // Kept expressions after the edit moved by "token_shift" tokens.
+        for (u64 i = end; i < spans.size(); i += 1) {
+            spans[i].first_token = static_cast<u32>(static_cast<s64>(spans[i].first_token) + token_shift);
+
+            expression& expr = parser_output->expression_at(AST[i]);
+            if (expr.type == EXPR_MODULE_IMPORT) {
+                expr.module_import.name_token_index = static_cast<u32>(
+                    static_cast<s64>(expr.module_import.name_token_index) + token_shift);
+            }
+        }
+
+        AST.erase(AST.begin() + first, AST.begin() + end);
+        AST.insert(AST.begin() + first, parsed_AST.begin(), parsed_AST.end());
+
+        spans.erase(spans.begin() + first, spans.begin() + end);
+        spans.insert(spans.begin() + first, parsed_spans.begin(), parsed_spans.end());
+
+        replaced_top_level = top_level_edit{ first, end - first, parsed_AST.size() };
+        return true;
+    }
+
     void parser_instance::drive()
     {
         while(true) {
+            // Lists of a top-level expression that failed to parse are left unfinished.
+            list_stack.clear();
+
+            u64 first_token = token_index;
+            u64 first_symbol = parser_output->module_symbols.size();
+
             auto top_level_expression = parse_top_level();
             if (top_level_expression)
-                parser_output->AST.push_back(top_level_expression.value());
+                add_top_level(top_level_expression.value(), first_token, first_symbol);
+            else if (!done)
+                parser_output->skipped_top_level = true;
 
             // Reached the end of the token stream.
             if (done)
@@ -211,6 +410,44 @@ namespace masonc::parser
         }
     }
 
+    void parser_instance::add_top_level(expression_handle handle, u64 first_token, u64 first_symbol)
+    {
+        parser_output->AST.push_back(handle);
+        parser_output->AST_spans.push_back(span_from(first_token, first_symbol));
+    }
+
+    top_level_span parser_instance::span_from(u64 first_token, u64 first_symbol)
+    {
+        u64 token_count = token_index - first_token;
+
+        return top_level_span{
+            static_cast<u32>(first_token),
+            static_cast<u32>(token_count),
+            lexer_output()->hash_tokens(first_token, token_count),
+            static_cast<u32>(first_symbol),
+            static_cast<u32>(parser_output->module_symbols.size() - first_symbol)
+        };
+    }
+
+    void parser_instance::remove_module_symbols(const top_level_span& span)
+    {
+        for (u32 i = 0; i < span.symbol_count; i += 1) {
+            parser_output->file_module.module_scope().remove_symbol(
+                parser_output->module_symbols[span.first_symbol + i]);
+        }
+    }
+
+    bool parser_instance::add_symbol(symbol name)
+    {
+        if (!current_scope()->add_symbol(name))
+            return false;
+
+        if (current_scope_handle == MODULE_SCOPE_HANDLE)
+            parser_output->module_symbols.push_back(name);
+
+        return true;
+    }
+
     masonc::lexer::lexer_instance_output* parser_instance::lexer_output()
     {
         return &parser_output->lexer_output;
@@ -218,7 +455,7 @@ namespace masonc::parser
 
     scope* parser_instance::current_scope()
     {
-        return parser_output->file_module.module_scope.get_child(current_scope_index);
+        return &parser_output->file_module.scopes[current_scope_handle];
     }
 
     bool parser_instance::module_declaration_exists()
@@ -231,24 +468,30 @@ namespace masonc::parser
         parser_output->module_name = std::string{ module_name };
 
         // Tell the module scope of the module.
-        parser_output->file_module.module_scope.m_module = &parser_output->file_module;
+        parser_output->file_module.module_scope().m_module = &parser_output->file_module;
 
         //u16 module_name_length = parser_output->module_names.length_at(current_handle);
         //const char* module_name = parser_output->module_names.at(current_handle);
 
         // Give the module scope the module name.
-        parser_output->file_module.module_scope.set_name(module_name, module_name_length);
+        parser_output->file_module.module_scope().set_name(
+            global_interner.intern(std::string_view{ module_name, module_name_length }));
 
         try {
             // Guess how many tokens will end up being 1 expression on average to
             // avoid reallocations.
-            parser_output->AST.reserve(lexer_output()->tokens.size() / 10 + 32);
+            parser_output->AST.reserve(lexer_output()->token_count() / 10 + 32);
+            parser_output->expressions.reserve(lexer_output()->token_count() / 2 + 32);
+
+            // Statements and arguments, roughly one per call or statement terminator.
+            parser_output->expression_lists.reserve(lexer_output()->token_count() / 8 + 32);
+            list_stack.reserve(64);
         }
         catch (...) {
             global_logger.log_error("Could not reserve space for AST container.");
         }
 
-        current_scope_index = parser_output->file_module.module_scope.index();
+        current_scope_handle = MODULE_SCOPE_HANDLE;
     }
 
     void parser_instance::set_module(const std::string& module_name)
@@ -264,17 +507,15 @@ namespace masonc::parser
         token_index += count;
     }
 
-    std::optional<masonc::lexer::token*> parser_instance::peek_token()
+    std::optional<masonc::lexer::token> parser_instance::peek_token()
     {
-        if(token_index < lexer_output()->tokens.size()) {
-            std::optional<masonc::lexer::token*> result{ &lexer_output()->tokens[token_index] };
-            return result;
-        }
+        if(token_index < lexer_output()->token_count())
+            return lexer_output()->token_at(token_index);
 
         return std::nullopt;
     }
 
-    std::optional<masonc::lexer::token*> parser_instance::expect_any()
+    std::optional<masonc::lexer::token> parser_instance::expect_any()
     {
         auto token_result = peek_token();
         if (!token_result) {
@@ -287,7 +528,7 @@ namespace masonc::parser
         return token_result.value();
     }
 
-    std::optional<masonc::lexer::token*> parser_instance::expect_identifier()
+    std::optional<masonc::lexer::token> parser_instance::expect_identifier()
     {
         auto token_result = peek_token();
         if (!token_result) {
@@ -296,7 +537,7 @@ namespace masonc::parser
             return std::nullopt;
         }
 
-        if (token_result.value()->type != masonc::lexer::TOKEN_IDENTIFIER) {
+        if (token_result.value().type != masonc::lexer::TOKEN_IDENTIFIER) {
             report_parse_error("Expected an identifier.");
             return std::nullopt;
         }
@@ -305,7 +546,7 @@ namespace masonc::parser
         return token_result.value();
     }
 
-    std::optional<masonc::lexer::token*> parser_instance::expect(char c)
+    std::optional<masonc::lexer::token> parser_instance::expect(char c)
     {
         auto token_result = peek_token();
         if (!token_result) {
@@ -315,7 +556,7 @@ namespace masonc::parser
         }
 
         // Assumes that type "char" is signed
-        if (token_result.value()->type != c) {
+        if (token_result.value().type != c) {
             report_parse_error("Expected \"" + std::string{ c } + "\".");
             return std::nullopt;
         }
@@ -324,7 +565,7 @@ namespace masonc::parser
         return token_result.value();
     }
 
-    std::optional<masonc::lexer::token*> parser_instance::expect(const std::string& identifier)
+    std::optional<masonc::lexer::token> parser_instance::expect_keyword(symbol keyword)
     {
         auto token_result = peek_token();
         if (!token_result) {
@@ -333,10 +574,10 @@ namespace masonc::parser
             return std::nullopt;
         }
 
-        if (token_result.value()->type != masonc::lexer::TOKEN_IDENTIFIER ||
-            identifier_at(*token_result.value()) != identifier)
+        if (token_result.value().type != masonc::lexer::TOKEN_IDENTIFIER ||
+            token_result.value().value_index != keyword)
         {
-            report_parse_error("Expected \"" + identifier + "\".");
+            report_parse_error("Expected \"" + std::string{ global_interner.at(keyword) } + "\".");
             return std::nullopt;
         }
 
@@ -344,33 +585,57 @@ namespace masonc::parser
         return token_result.value();
     }
 
-    const char* parser_instance::identifier_at(const masonc::lexer::token& identifier_token)
+    std::string_view parser_instance::identifier_at(const masonc::lexer::token& identifier_token)
     {
-        assume(lexer_output()->identifiers.size() > identifier_token.value_index, "value_index is out of range");
-        return lexer_output()->identifiers.at(identifier_token.value_index);
+        return lexer_output()->identifier_at(identifier_token.value_index);
     }
 
-    const char* parser_instance::integer_at(const masonc::lexer::token& integer_token)
+    std::string_view parser_instance::integer_at(const masonc::lexer::token& integer_token)
     {
         assume(lexer_output()->integers.size() > integer_token.value_index, "value_index is out of range");
-        return lexer_output()->integers.at(integer_token.value_index);
+        return lexer_output()->integer_at(integer_token.value_index);
     }
 
-    const char* parser_instance::decimal_at(const masonc::lexer::token& decimal_token)
+    std::string_view parser_instance::decimal_at(const masonc::lexer::token& decimal_token)
     {
         assume(lexer_output()->decimals.size() > decimal_token.value_index, "value_index is out of range");
-        return lexer_output()->decimals.at(decimal_token.value_index);
+        return lexer_output()->decimal_at(decimal_token.value_index);
     }
 
-    const char* parser_instance::string_at(const masonc::lexer::token& string_token)
+    std::string_view parser_instance::string_at(const masonc::lexer::token& string_token)
     {
         assume(lexer_output()->strings.size() > string_token.value_index, "value_index is out of range");
-        return lexer_output()->strings.at(string_token.value_index);
+        return lexer_output()->string_at(string_token.value_index);
     }
 
-    masonc::lexer::token_location* parser_instance::get_token_location(u64 token_index)
+    masonc::lexer::token_location parser_instance::get_token_location(u64 token_index)
     {
-        return &lexer_output()->locations[token_index];
+        return lexer_output()->location_at(token_index);
+    }
+
+    expression_handle parser_instance::add_expression(const expression& expr)
+    {
+        assume(parser_output->expressions.size() < std::numeric_limits<expression_handle>::max(),
+            "expression count exceeds size of \"expression_handle\"");
+
+        expression_handle handle = static_cast<expression_handle>(parser_output->expressions.size());
+        parser_output->expressions.push_back(expr);
+
+        return handle;
+    }
+
+    expression_range parser_instance::end_list(u64 list_start)
+    {
+        expression_range range{
+            static_cast<u32>(parser_output->expression_lists.size()),
+            static_cast<u32>(list_stack.size() - list_start)
+        };
+
+        parser_output->expression_lists.insert(parser_output->expression_lists.end(),
+            list_stack.begin() + list_start, list_stack.end());
+
+        list_stack.resize(list_start);
+        return range;
     }
 
     void parser_instance::report_parse_error(const std::string& msg)
@@ -384,21 +649,20 @@ namespace masonc::parser
 
     void parser_instance::report_parse_error_at(const std::string& msg, u64 token_index)
     {
-        masonc::lexer::token_location* location = get_token_location(token_index);
-        parser_output->messages.report_error(msg, build_stage::PARSER, *location);
+        parser_output->messages.report_error(msg, build_stage::PARSER, get_token_location(token_index));
     }
 
     void parser_instance::recover()
     {
         while (true) {
-            std::optional<masonc::lexer::token*> token_result = peek_token();
+            std::optional<masonc::lexer::token> token_result = peek_token();
             if (!token_result)
                 return;
 
             eat();
 
-            if (token_result.value()->type == ';' ||
-                token_result.value()->type == '}')
+            if (token_result.value().type == ';' ||
+                token_result.value().type == '}')
             {
                 return;
             }
@@ -416,16 +680,16 @@ namespace masonc::parser
                 return std::nullopt;
             }
 
-            if (token_result.value()->type != masonc::lexer::TOKEN_IDENTIFIER) {
+            if (token_result.value().type != masonc::lexer::TOKEN_IDENTIFIER) {
                 report_parse_error("Expected an identifier.");
                 recover();
 
                 return std::nullopt;
             }
 
-            const char* identifier = identifier_at(*token_result.value());
+            symbol identifier = static_cast<symbol>(token_result.value().value_index);
 
-            if (std::strcmp(identifier, "mut") == 0) {
+            if (identifier == KEYWORD_MUT) {
                 eat();
 
                 if (specifiers & SPECIFIER_MUT) {
@@ -435,7 +699,7 @@ namespace masonc::parser
 
                 specifiers |= SPECIFIER_MUT;
             }
-            else if (std::strcmp(identifier, "const") == 0) {
+            else if (identifier == KEYWORD_CONST) {
                 eat();
 
                 if (specifiers & SPECIFIER_CONST) {
@@ -451,7 +715,7 @@ namespace masonc::parser
         }
     }
 
-    std::optional<expression> parser_instance::parse_top_level()
+    std::optional<expression_handle> parser_instance::parse_top_level()
     {
         std::optional<u8> specifiers_result = parse_specifiers();
         if (!specifiers_result)
@@ -460,18 +724,17 @@ namespace masonc::parser
         // Next token is guaranteed to exist and be an identifier.
         auto token_result = peek_token();
 
-        const char* identifier = identifier_at(*token_result.value());
-        symbol_handle identifier_handle = token_result.value()->value_index;
+        symbol_handle identifier_handle = token_result.value().value_index;
 
         eat();
 
         if (specifiers_result.value() == SPECIFIER_NONE) {
-            if (std::strcmp(identifier, "proc") == 0)
+            if (identifier_handle == KEYWORD_PROC)
                 return parse_procedure();
-            if (std::strcmp(identifier, "module") == 0)
+            if (identifier_handle == KEYWORD_MODULE)
                 report_parse_error("Module declaration must be the first statement in the source file, and there must only be one module declaration.");
             //    return parse_module_declaration();
-            if (std::strcmp(identifier, "import") == 0)
+            if (identifier_handle == KEYWORD_IMPORT)
                 return parse_module_import();
         }
 
@@ -487,7 +750,7 @@ namespace masonc::parser
             identifier_handle, specifiers_result.value());
     }
 
-    std::optional<expression> parser_instance::parse_statement()
+    std::optional<expression_handle> parser_instance::parse_statement()
     {
         std::optional<u8> specifiers_result = parse_specifiers();
         if(!specifiers_result)
@@ -496,12 +759,11 @@ namespace masonc::parser
         // Next token is guaranteed to exist and be an identifier.
         auto token_result = peek_token();
 
-        const char* identifier = identifier_at(*token_result.value());
-        symbol_handle identifier_handle = token_result.value()->value_index;
+        symbol_handle identifier_handle = token_result.value().value_index;
 
         eat();
 
-        if (std::strcmp(identifier, "return") == 0) {
+        if (identifier_handle == KEYWORD_RETURN) {
             // Parse return statement.
             return parse_expression(CONTEXT_STATEMENT);
         }
@@ -514,7 +776,7 @@ namespace masonc::parser
         }
 
         if (specifiers_result.value() == SPECIFIER_NONE &&
-            token_result.value()->type == '(')
+            token_result.value().type == '(')
         {
             eat();
             return parse_call(CONTEXT_STATEMENT, identifier_handle);
@@ -522,7 +784,7 @@ namespace masonc::parser
 
         // Specifiers are declared or next token is not "(".
 
-        if (token_result.value()->type == ':') {
+        if (token_result.value().type == ':') {
             eat();
             return parse_variable_declaration(CONTEXT_STATEMENT,
                 identifier_handle, specifiers_result.value());
@@ -533,45 +795,32 @@ namespace masonc::parser
         return std::nullopt;
     }
 
-    std::optional<expression> parser_instance::parse_expression(parse_context context)
+    std::optional<expression_handle> parser_instance::parse_expression(parse_context context)
     {
         auto primary_result = parse_primary(CONTEXT_NONE);
         if (!primary_result)
             return std::nullopt;
 
-        auto token_result = peek_token();
-        if (!token_result) {
-            report_parse_error("Expected a token.");
-            done = true;
+        auto expression_result = parse_binary(primary_result.value(), 0);
+        if (!expression_result)
             return std::nullopt;
-        }
 
-        auto op_result = get_op(token_result.value()->type);
-        if (op_result) {
-            // Eat the binary operator.
-            eat();
-        }
-        else {
-            // Next token is not a binary operator.
-            if (context == CONTEXT_STATEMENT) {
-                if (token_result.value()->type == ';') {
-                    // Eat the ";".
-                    eat();
-                }
-                else {
-                    recover();
-                    return std::nullopt;
-                }
+        if (context == CONTEXT_STATEMENT) {
+            // "parse_binary" stopped in front of a token that is not a binary operator.
+            if (peek_token().value().type == ';') {
+                // Eat the ";".
+                eat();
+            }
+            else {
+                recover();
+                return std::nullopt;
             }
-
-            return primary_result;
         }
 
-        // Parse right-hand side of binary expression.
-        return parse_binary(context, primary_result.value(), op_result.value());
+        return expression_result;
     }
 
-    std::optional<expression> parser_instance::parse_primary(parse_context context)
+    std::optional<expression_handle> parser_instance::parse_primary(parse_context context)
     {
         auto token_result = peek_token();
         if (!token_result) {
@@ -580,7 +829,7 @@ namespace masonc::parser
             return std::nullopt;
         }
 
-        switch (token_result.value()->type) {
+        switch (token_result.value().type) {
             default: {
                 report_parse_error("Unexpected token.");
                 recover();
@@ -594,18 +843,16 @@ namespace masonc::parser
                 if (!primary_result)
                     return std::nullopt;
 
-                expression* expr = new expression{ primary_result.value() };
-                parser_output->delete_list_expressions.push_back(expr);
-
-                return expression{ expression_unary{ expr, token_result.value()->type } };
+                return add_expression(expression{
+                    expression_unary{ primary_result.value(), token_result.value().type }
+                });
             }
             case masonc::lexer::TOKEN_IDENTIFIER: {
                 eat();
 
-                const char* identifier = identifier_at(*token_result.value());
-                symbol_handle identifier_handle = token_result.value()->value_index;
+                symbol_handle identifier_handle = token_result.value().value_index;
 
-                if (std::strcmp(identifier, "proc") == 0) {
+                if (identifier_handle == KEYWORD_PROC) {
                     report_parse_error("Procedure must be top-level expression.");
                     // TODO: Jump to end of procedure and not next ";" or "}".
                     recover();
@@ -620,7 +867,7 @@ namespace masonc::parser
                     return std::nullopt;
                 }
 
-                switch (token_result.value()->type) {
+                switch (token_result.value().type) {
                     default:
                         return parse_reference(context, identifier_handle);
                     case '(':
@@ -630,15 +877,18 @@ namespace masonc::parser
             }
             case masonc::lexer::TOKEN_INTEGER: {
                 eat();
-                return parse_number_literal(context, integer_at(*token_result.value()), NUMBER_INTEGER);
+                assume(lexer_output()->integers.size() > token_result.value().value_index, "value_index is out of range");
+                return parse_number_literal(context, token_result.value().value_index, NUMBER_INTEGER);
             }
             case masonc::lexer::TOKEN_DECIMAL: {
                 eat();
-                return parse_number_literal(context, decimal_at(*token_result.value()), NUMBER_DECIMAL);
+                assume(lexer_output()->decimals.size() > token_result.value().value_index, "value_index is out of range");
+                return parse_number_literal(context, token_result.value().value_index, NUMBER_DECIMAL);
             }
             case masonc::lexer::TOKEN_STRING: {
                 eat();
-                return parse_string_literal(context, string_at(*token_result.value()));
+                assume(lexer_output()->strings.size() > token_result.value().value_index, "value_index is out of range");
+                return parse_string_literal(context, token_result.value().value_index);
             }
             case '(': {
                 eat();
@@ -647,23 +897,55 @@ namespace masonc::parser
         }
     }
 
-    std::optional<expression> parser_instance::parse_binary(parse_context context,
-        const expression& left, const binary_operator* op)
+    std::optional<expression_handle> parser_instance::parse_binary(expression_handle left, u32 min_precedence)
     {
-        auto right_result = parse_expression(context);
-        if (!right_result)
+        // Precedence climbing: https://en.wikipedia.org/wiki/Operator-precedence_parser
+        auto token_result = peek_token();
+        if (!token_result) {
+            report_parse_error("Expected a token.");
+            done = true;
             return std::nullopt;
+        }
+
+        auto op_result = get_op(token_result.value().type);
+
+        while (op_result && op_result.value()->precedence >= min_precedence) {
+            const binary_operator* op = op_result.value();
+
+            // Eat the binary operator.
+            eat();
+
+            auto right_result = parse_primary(CONTEXT_NONE);
+            if (!right_result)
+                return std::nullopt;
+
+            token_result = peek_token();
+            if (!token_result) {
+                report_parse_error("Expected a token.");
+                done = true;
+                return std::nullopt;
+            }
 
-        expression* expr_left = new expression{ left };
-        expression* expr_right = new expression{ right_result.value() };
+            op_result = get_op(token_result.value().type);
 
-        parser_output->delete_list_expressions.push_back(expr_left);
-        parser_output->delete_list_expressions.push_back(expr_right);
+            // Operators binding tighter than "op" take the right-hand side as their left operand.
+            // Operators of the same precedence are left to this loop, which makes them left-associative.
+            if (op_result && op_result.value()->precedence > op->precedence) {
+                right_result = parse_binary(right_result.value(), op->precedence + 1);
+                if (!right_result)
+                    return std::nullopt;
 
-        return expression{ expression_binary{ expr_left, expr_right, op } };
+                // The nested call stopped in front of a token, so it exists.
+                op_result = get_op(peek_token().value().type);
+            }
+
+            left = add_expression(expression{ expression_binary{ left, right_result.value(), op->op_code } });
+        }
+
+        return left;
     }
 
-    std::optional<expression> parser_instance::parse_parentheses(parse_context context)
+    std::optional<expression_handle> parser_instance::parse_parentheses(parse_context context)
     {
         // Parse what is inside the parentheses.
         auto expr_result = parse_expression(CONTEXT_NONE);
@@ -684,18 +966,19 @@ namespace masonc::parser
         }
 
         // If a binary expression is encased in the parentheses,
-        // return a "expression_parentheses" containing the binary expression
-        // so that operator precedence can be correctly applied later.
+        // turn it into an "expression_parentheses" containing the binary expression.
+        // The tree already has the right shape, this only keeps the parentheses visible.
         //
         // Otherwise just return the expression.
-        if(expr_result.value().value.empty.type == EXPR_BINARY)
-            return expression{ expression_parentheses{ expr_result.value().value.binary.value } };
-        else
-            return expr_result;
+        expression& expr = parser_output->expression_at(expr_result.value());
+        if(expr.type == EXPR_BINARY)
+            expr = expression{ expression_parentheses{ expr.binary } };
+
+        return expr_result;
     }
 
-    std::optional<expression> parser_instance::parse_number_literal(parse_context context,
-        const char* number, number_type type)
+    std::optional<expression_handle> parser_instance::parse_number_literal(parse_context context,
+        u32 value_index, number_type type)
     {
         if (context == CONTEXT_STATEMENT) {
             if (!expect(';')) {
@@ -704,10 +987,10 @@ namespace masonc::parser
             }
         }
 
-        return expression{ expression_number_literal{ number, type } };
+        return add_expression(expression{ expression_number_literal{ value_index, type } });
     }
 
-    std::optional<expression> parser_instance::parse_string_literal(parse_context context, const char* str)
+    std::optional<expression_handle> parser_instance::parse_string_literal(parse_context context, u32 value_index)
     {
         if (context == CONTEXT_STATEMENT) {
             if (!expect(';')) {
@@ -716,10 +999,10 @@ namespace masonc::parser
             }
         }
 
-        return expression{ expression_string_literal{ str } };
+        return add_expression(expression{ expression_string_literal{ value_index } });
     }
 
-    std::optional<expression> parser_instance::parse_reference(parse_context context,
+    std::optional<expression_handle> parser_instance::parse_reference(parse_context context,
         symbol_handle identifier_handle)
     {
         if (context == CONTEXT_STATEMENT) {
@@ -729,20 +1012,19 @@ namespace masonc::parser
             }
         }
 
-        return expression{ expression_reference{ identifier_handle } };
+        return add_expression(expression{ expression_reference{ identifier_handle } });
     }
 
-    std::optional<expression> parser_instance::parse_variable_declaration(parse_context context,
+    std::optional<expression_handle> parser_instance::parse_variable_declaration(parse_context context,
         symbol_handle name_handle, u8 specifiers)
     {
-        const char* name = lexer_output()->identifiers.at(name_handle);
         bool is_pointer;
 
         auto token_result = expect_any();
         if (!token_result)
             return std::nullopt;
 
-        if (token_result.value()->type == '^') {
+        if (token_result.value().type == '^') {
             is_pointer = true;
 
             token_result = expect_identifier();
@@ -754,7 +1036,7 @@ namespace masonc::parser
         else {
             is_pointer = false;
 
-            if (token_result.value()->type != masonc::lexer::TOKEN_IDENTIFIER) {
+            if (token_result.value().type != masonc::lexer::TOKEN_IDENTIFIER) {
                 report_parse_error("Expected an identifier.");
                 recover();
                 return std::nullopt;
@@ -763,11 +1045,10 @@ namespace masonc::parser
 
         // The token is an identifier.
 
-        const char* type = identifier_at(*token_result.value());
-        type_handle type_handle = token_result.value()->value_index;
+        type_handle type_handle = token_result.value().value_index;
 
         // Add variable to symbol table of current scope.
-        bool add_symbol_result = current_scope()->add_symbol(name);
+        bool add_symbol_result = add_symbol(name_handle);
         if (!add_symbol_result) {
             report_parse_error("Symbol is already defined.");
             recover();
@@ -782,43 +1063,47 @@ namespace masonc::parser
             }
 
             // Variable declaration statements can optionally assign a value.
-            if (token_result.value()->type == OP_EQUALS.op_code) {
+            if (token_result.value().type == OP_EQUALS.op_code) {
                 // Parse the right-hand side.
-                return parse_binary(
-                    CONTEXT_STATEMENT,
-                    expression{
-                        expression_variable_declaration{
-                            name_handle,
-                            type_handle,
-                            specifiers,
-                            is_pointer
-                        }
-                    },
-                    &OP_EQUALS
-                );
+                expression_handle declaration = add_expression(expression{
+                    expression_variable_declaration{
+                        name_handle,
+                        type_handle,
+                        specifiers,
+                        is_pointer
+                    }
+                });
+
+                auto value_result = parse_expression(CONTEXT_STATEMENT);
+                if (!value_result)
+                    return std::nullopt;
+
+                return add_expression(expression{
+                    expression_binary{ declaration, value_result.value(), OP_EQUALS.op_code }
+                });
             }
 
             // No value is assigned to the variable, handle end of statement here.
-            if (token_result.value()->type != ';') {
+            if (token_result.value().type != ';') {
                 report_parse_error("Expected \";\".");
                 recover();
                 return std::nullopt;
             }
         }
 
-        return expression{
+        return add_expression(expression{
             expression_variable_declaration{
                 name_handle,
                 type_handle,
                 specifiers,
                 is_pointer
             }
-        };
+        });
     }
 
-    std::optional<expression> parser_instance::parse_call(parse_context context, symbol_handle name_handle)
+    std::optional<expression_handle> parser_instance::parse_call(parse_context context, symbol_handle name_handle)
     {
-        expression_procedure_call call_expr{ name_handle };
+        u64 list_start = list_stack.size();
 
         auto token_result = peek_token();
         if (!token_result) {
@@ -827,20 +1112,20 @@ namespace masonc::parser
             return std::nullopt;
         }
 
-        if (token_result.value()->type != ')') {
+        if (token_result.value().type != ')') {
             // Parse argument(s).
             while (true) {
                 auto argument = parse_expression(CONTEXT_NONE);
                 if (!argument)
                     return std::nullopt;
 
-                call_expr.argument_list.push_back(argument.value());
+                list_stack.push_back(argument.value());
 
                 token_result = expect_any();
                 if (!token_result)
                     return std::nullopt;
 
-                switch (token_result.value()->type) {
+                switch (token_result.value().type) {
                     default:
                         report_parse_error("Unexpected token.");
                         recover();
@@ -861,35 +1146,35 @@ namespace masonc::parser
             }
         }
 
-        return expression{ call_expr };
+        return add_expression(expression{ expression_procedure_call{ name_handle, end_list(list_start) } });
     }
 
-    std::vector<expression> parser_instance::parse_argument_list()
+    expression_range parser_instance::parse_argument_list()
     {
-        std::vector<expression> argument_list;
+        u64 list_start = list_stack.size();
 
         // Get the first token after "(".
         // No need to check if it's valid because that was done before in 'parse_procedure()'.
-        //std::optional<token*> token_result = eat();
+        //std::optional<token> token_result = eat();
 
         while (true)
         {
             auto specifiers_result = parse_specifiers();
             if (!specifiers_result)
-                return std::vector<expression>{};
+                goto FAILED;
 
             // Next token is guaranteed to exist and be an identifier.
             auto token_result = peek_token();
 
-            //const char* identifier = identifier_at(*token_result.value());
-            symbol_handle identifier_handle = token_result.value()->value_index;
+            //std::string_view identifier = identifier_at(token_result.value());
+            symbol_handle identifier_handle = token_result.value().value_index;
 
             eat();
 
             if (!expect(':')) {
                 // TODO: Recover from this by going to the next argument, instead of ";" or "}".
                 recover();
-                return std::vector<expression>{};
+                goto FAILED;
             }
 
             // Parse the argument
@@ -897,33 +1182,38 @@ namespace masonc::parser
                 identifier_handle, specifiers_result.value());
 
             if (!variable_declaration)
-                return std::vector<expression>{};
+                goto FAILED;
 
-            argument_list.push_back(variable_declaration.value());
+            list_stack.push_back(variable_declaration.value());
 
             token_result = peek_token();
             if (!token_result) {
                 report_parse_error("Expected a token.");
                 done = true;
-                return std::vector<expression>{};
+                goto FAILED;
             }
 
-            switch (token_result.value()->type) {
+            switch (token_result.value().type) {
                 default:
                     report_parse_error("Unexpected token.");
                     recover();
-                    return std::vector<expression>{};
+                    goto FAILED;
                 case ',':
                     eat();
                     continue;
                 case ')':
                     eat();
-                    return argument_list;
+                    return end_list(list_start);
             }
         }
+
+        FAILED:
+        // Drop the arguments parsed so far.
+        list_stack.resize(list_start);
+        return expression_range{ 0, 0 };
     }
 
-    std::optional<expression> parser_instance::parse_procedure()
+    std::optional<expression_handle> parser_instance::parse_procedure()
     {
         auto token_result = expect_identifier();
         if (!token_result) {
@@ -932,11 +1222,10 @@ namespace masonc::parser
             return std::nullopt;
         }
 
-        const char* name = identifier_at(*token_result.value());
-        symbol_handle name_handle = token_result.value()->value_index;
+        symbol_handle name_handle = token_result.value().value_index;
 
         // Add procedure to symbol table of current scope.
-        bool add_symbol_result = current_scope()->add_symbol(name);
+        bool add_symbol_result = add_symbol(name_handle);
         if (!add_symbol_result) {
             report_parse_error("Symbol is already defined.");
             return std::nullopt;
@@ -956,10 +1245,10 @@ namespace masonc::parser
         }
 
         // Any arguments are stashed here, otherwise it's empty.
-        std::vector<expression> argument_list;
+        expression_range argument_list{ 0, 0 };
 
         // Procedure has no arguments.
-        if (token_result.value()->type == ')') {
+        if (token_result.value().type == ')') {
             // Eat the ")".
             eat();
         }
@@ -980,7 +1269,7 @@ namespace masonc::parser
         std::optional<type_handle> return_type_handle;
 
         // Return type specified.
-        if (token_result.value()->type == masonc::lexer::TOKEN_RIGHT_POINTER)
+        if (token_result.value().type == masonc::lexer::TOKEN_RIGHT_POINTER)
         {
             // Eat the "->".
             eat();
@@ -992,8 +1281,8 @@ namespace masonc::parser
                 return std::nullopt;
             }
 
-            //return_type_identifier = identifier_at(*token_result.value());
-            return_type_handle = token_result.value()->value_index;
+            //return_type_identifier = identifier_at(token_result.value());
+            return_type_handle = token_result.value().value_index;
 
             // Peek the token after the return type.
             token_result = peek_token();
@@ -1004,7 +1293,7 @@ namespace masonc::parser
             }
         }
 
-        switch (token_result.value()->type) {
+        switch (token_result.value().type) {
             default:
                 report_parse_error("Unexpected token.");
                 recover();
@@ -1014,29 +1303,29 @@ namespace masonc::parser
             case '{':
                 // Parse procedure body.
                 eat();
-                return parse_procedure_body(
+                return parse_procedure_body(add_expression(expression{
                     expression_procedure_prototype{
                         name_handle,
                         return_type_handle,
                         argument_list
                     }
-                );
+                }));
 
             // Procedure has no body and is a prototype.
             case ';':
                 // Done parsing procedure prototype.
                 eat();
-                return expression{
+                return add_expression(expression{
                     expression_procedure_prototype {
                         name_handle,
                         return_type_handle,
                         argument_list
                     }
-                };
+                });
         }
     }
 
-    std::optional<expression> parser_instance::parse_procedure_body(const expression_procedure_prototype& prototype)
+    std::optional<expression_handle> parser_instance::parse_procedure_body(expression_handle prototype)
     {
         auto token_result = peek_token();
         if (!token_result) {
@@ -1045,37 +1334,32 @@ namespace masonc::parser
             return std::nullopt;
         }
 
-        if (token_result.value()->type == '}') {
+        if (token_result.value().type == '}') {
             // Procedure body is empty.
             eat();
-            return expression{ expression_procedure_definition{ prototype } };
+            return add_expression(expression{ expression_procedure_definition{ prototype, expression_range{ 0, 0 } } });
         }
 
         // Procedure body is not empty.
 
-        scope_index parent_scope_index = current_scope_index;
-
-        u16 procedure_name_length = lexer_output()->identifiers.length_at(prototype.name_handle);
-        const char* procedure_name = lexer_output()->identifiers.at(prototype.name_handle);
+        scope_handle parent_scope_handle = current_scope_handle;
 
         // Create new scope for the procedure and make it current.
-        current_scope_index = current_scope()->add_child(scope{});
+        current_scope_handle = current_scope()->add_child(scope{});
+        current_scope()->set_name(parser_output->expression_at(prototype).procedure_prototype.name_handle);
 
-        scope* procedure_scope = current_scope();
-        procedure_scope->set_name(procedure_name, procedure_name_length);
-
-        std::vector<expression> body;
+        u64 list_start = list_stack.size();
 
         while (true) {
             auto statement_result = parse_statement();
             if (!statement_result)
                 return std::nullopt;
 
-            body.push_back(statement_result.value());
+            list_stack.push_back(statement_result.value());
 
             token_result = peek_token();
             if (!token_result) {
-                current_scope_index = parent_scope_index;
+                current_scope_handle = parent_scope_handle;
                 report_parse_error("Expected a token");
                 done = true;
                 return std::nullopt;
@@ -1083,20 +1367,21 @@ namespace masonc::parser
 
             // Check if the token after the last parsed expression is '}',
             // which would be the end of the body.
-            if (token_result.value()->type == '}') {
+            if (token_result.value().type == '}') {
                 // Eat the "}".
                 eat();
                 break;
             }
         }
 
-        current_scope_index = parent_scope_index;
-        return expression{ expression_procedure_definition{ prototype, body } };
+        current_scope_handle = parent_scope_handle;
+        return add_expression(expression{ expression_procedure_definition{ prototype, end_list(list_start) } });
     }
 
-    std::optional<expression> parser_instance::parse_module_declaration()
+    std::optional<expression_handle> parser_instance::parse_module_declaration()
     {
         std::string temp_module_name;
+        u64 name_token_index = this->token_index;
 
         while(true)
         {
@@ -1106,21 +1391,23 @@ namespace masonc::parser
                 return std::nullopt;
             }
 
-            temp_module_name += identifier_at(*token_result.value());
+            temp_module_name += identifier_at(token_result.value());
 
             token_result = expect_any();
             if (!token_result)
                 return std::nullopt;
 
-            if (token_result.value()->type == lexer::TOKEN_DOUBLECOLON) {
+            if (token_result.value().type == lexer::TOKEN_DOUBLECOLON) {
                 temp_module_name += "::";
                 continue;
             }
-            else if(token_result.value()->type == ';') {
+            else if(token_result.value().type == ';') {
                 set_module(temp_module_name);
 
                 // Done parsing module declaration statement.
-                return expression{ expression_module_declaration{ parser_output->module_name.c_str() } };
+                return add_expression(expression{
+                    expression_module_declaration{ static_cast<u32>(name_token_index) }
+                });
             }
             else {
                 report_parse_error("Unexpected token.");
@@ -1130,9 +1417,10 @@ namespace masonc::parser
         }
     }
 
-    std::optional<expression> parser_instance::parse_module_import()
+    std::optional<expression_handle> parser_instance::parse_module_import()
     {
         std::string temp_module_name;
+        u64 name_token_index = this->token_index;
 
         while(true)
         {
@@ -1142,26 +1430,26 @@ namespace masonc::parser
                 return std::nullopt;
             }
 
-            temp_module_name += identifier_at(*token_result.value());
+            temp_module_name += identifier_at(token_result.value());
 
             token_result = expect_any();
             if (!token_result)
                 return std::nullopt;
 
             // TODO: Check for "as" token.
-            if (token_result.value()->type == lexer::TOKEN_DOUBLECOLON) {
+            if (token_result.value().type == lexer::TOKEN_DOUBLECOLON) {
                 temp_module_name += "::";
                 continue;
             }
-            else if (token_result.value()->type == ';') {
+            else if (token_result.value().type == ';') {
                 // TODO: Check if imported more than once.
 
-                u64 import_index = parser_output->file_module.module_import_names.copy_back(temp_module_name);
+                u64 import_index = parser_output->file_module.add_import(temp_module_name);
 
                 // Done parsing module import statement.
-                return expression{
-                    expression_module_import{ import_index, get_token_location(this->token_index) }
-                };
+                return add_expression(expression{
+                    expression_module_import{ static_cast<u32>(import_index), static_cast<u32>(name_token_index) }
+                });
             }
             else {
                 report_parse_error("Unexpected token.");
@@ -1173,10 +1461,10 @@ namespace masonc::parser
 
     expression_binary* get_binary_expression(expression* expr)
     {
-        if (expr->value.empty.type == EXPR_BINARY)
-            return &expr->value.binary.value;
-        else if (expr->value.empty.type == EXPR_PARENTHESES)
-            return &expr->value.parentheses.value.expr;
+        if (expr->type == EXPR_BINARY)
+            return &expr->binary;
+        else if (expr->type == EXPR_PARENTHESES)
+            return &expr->parentheses.expr;
 
         return nullptr;
     }
@@ -25,21 +25,73 @@ namespace masonc::parser
         CONTEXT_STATEMENT
     };
 
+    // Where a top-level expression was parsed from, see "parser_instance_output::AST_spans".
+    struct top_level_span
+    {
+        // Tokens the expression was parsed from.
+        u32 first_token;
+        u32 token_count;
+
+        // See "lexer_instance_output::hash_tokens". The same for two expressions parsed from the same text,
+        // wherever it is, so it tells if an expression changed between two parses.
+        u64 content_hash;
+
+        // Symbols the expression added to the module scope, in "parser_instance_output::module_symbols".
+        u32 first_symbol;
+        u32 symbol_count;
+    };
+
+    // Which top-level expressions a parse replaced:
+    // "removed_count" expressions at index "first" of the AST were replaced by "inserted_count" expressions.
+    struct top_level_edit
+    {
+        u64 first;
+        u64 removed_count;
+        u64 inserted_count;
+    };
+
     struct parser_instance_output
     {
         masonc::lexer::lexer_instance_output lexer_output;
 
         std::string module_name;
         mod file_module;
-        std::vector<expression> AST;
 
-        // All heap-allocated expressions - the indirection is needed to
-        // avoid circular references in some cases.
-        std::vector<expression*> delete_list_expressions;
+        // Top-level expressions in source order.
+        std::vector<expression_handle> AST;
+
+        // One for each top-level expression in "AST".
+        std::vector<top_level_span> AST_spans;
+
+        // Symbols added to the module scope, grouped by the top-level expression that added them.
+        std::vector<symbol> module_symbols;
+
+        // Every expression of the file, each one after the expressions it refers to.
+        std::vector<expression> expressions;
+
+        // Handles that make up the lists referred to by "expression_range".
+        std::vector<expression_handle> expression_lists;
 
         message_list messages;
 
-        // Release all heap-allocated expressions.
+        // Expressions after the last full parse. Reparsing leaves replaced expressions behind
+        // and parses everything again once they outnumber the others.
+        u64 full_parse_expression_count = 0;
+
+        // Set if a top-level expression was skipped without an error. It may have left
+        // its scope open for the following ones, so only a full parse gets them right.
+        bool skipped_top_level = false;
+
+        expression& expression_at(expression_handle handle);
+        const expression& expression_at(expression_handle handle) const;
+
+        // Returns the handle at "index" in "range", assuming that the index is in range.
+        expression_handle list_at(expression_range range, u32 index) const;
+
+        std::string_view number_value(const expression_number_literal& number) const;
+        std::string_view string_value(const expression_string_literal& str) const;
+
+        // Release the memory of all expressions.
         // This renders the AST unsafe to access, call at the very end of the build process
         // once the AST is not needed anymore.
         void free();
@@ -52,18 +104,61 @@ namespace masonc::parser
         // "parser_output.lexer_output" is expected to have no errors.
         parser_instance(parser_instance_output* parser_output);
 
+        // Brings "parser_output" up to date after "lexer_instance::retokenize" made "edit"
+        // to its lexer output, which is expected to have no errors.
+        //
+        // Only the top-level expressions with replaced tokens are parsed again, together with any
+        // that they run into. All other expressions and their scopes are kept. Everything is parsed
+        // again if the output had errors, if the reparse runs into one, or if the module
+        // declaration or an import is affected, so the result is the same as a full parse.
+        parser_instance(parser_instance_output* parser_output, const masonc::lexer::token_edit& edit);
+
+        // Which top-level expressions were parsed, all of them unless reparsing.
+        top_level_edit replaced() const;
+
     private:
         parser_instance_output* parser_output;
 
-        scope_index current_scope_index;
+        top_level_edit replaced_top_level{ 0, 0, 0 };
+
+        scope_handle current_scope_handle = MODULE_SCOPE_HANDLE;
         u64 token_index = 0;
 
         bool done = false;
 
+        // Handles of the lists that are being parsed, nested lists are stacked on top of each other.
+        // A finished list is moved to "expression_lists" as one range, see "end_list".
+        std::vector<expression_handle> list_stack;
+
+        // Parses the module declaration and drives the parser.
+        void parse_all();
+
+        // Resets "parser_output" and calls "parse_all".
+        void reparse_all();
+
+        // Parses the top-level expressions affected by "edit" and returns false if everything
+        // has to be parsed again.
+        bool reparse(const masonc::lexer::token_edit& edit);
+
         // Drives the parser by parsing top-level expressions which
         // in turn parse their own expressions and so on.
         void drive();
 
+        // Appends a top-level expression that was parsed from "first_token" up until the current token,
+        // and added the module symbols from "first_symbol" on.
+        void add_top_level(expression_handle handle, u64 first_token, u64 first_symbol);
+
+        // Returns a span for the tokens from "first_token" up until the current token,
+        // and the module symbols from "first_symbol" on.
+        top_level_span span_from(u64 first_token, u64 first_symbol);
+
+        // Removes the symbols a top-level expression added to the module scope.
+        void remove_module_symbols(const top_level_span& span);
+
+        // Adds "name" to the current scope, returns false if it is already defined there.
+        // Module symbols are recorded for the top-level expression that is being parsed.
+        bool add_symbol(symbol name);
+
         masonc::lexer::lexer_instance_output* lexer_output();
         scope* current_scope();
 
@@ -75,11 +170,11 @@ namespace masonc::parser
         void set_module(const std::string& module_name);
 
         void eat(u64 count = 1);
-        std::optional<masonc::lexer::token*> peek_token();
+        std::optional<masonc::lexer::token> peek_token();
 
         // If a next token does not exist, the parser is marked as "done",
         // a parse error is generated and the result is empty.
-        std::optional<masonc::lexer::token*> expect_any();
+        std::optional<masonc::lexer::token> expect_any();
 
         // If a next token does not exist, the parser is marked as "done",
         // a parse error is generated and the result is empty.
@@ -87,7 +182,7 @@ namespace masonc::parser
         // If the next token is not an identifier, a parse error is generated and the result is empty.
         //
         // Otherwise, the token is eaten and the result is valid.
-        std::optional<masonc::lexer::token*> expect_identifier();
+        std::optional<masonc::lexer::token> expect_identifier();
 
         // If a next token does not exist, the parser is marked as "done",
         // a parse error is generated and the result is empty.
@@ -96,7 +191,7 @@ namespace masonc::parser
         // a parse error is generated and the result is empty.
         //
         // Otherwise, the token is eaten and the result is valid.
-        std::optional<masonc::lexer::token*> expect(char c);
+        std::optional<masonc::lexer::token> expect(char c);
 
         // If a next token does not exist, the parser is marked as "done",
         // a parse error is generated and the result is empty.
@@ -105,15 +200,22 @@ namespace masonc::parser
         // a parse error is generated and the result is empty.
         //
         // Otherwise, the token is eaten and the result is valid.
-        std::optional<masonc::lexer::token*> expect(const std::string& identifier);
+        std::optional<masonc::lexer::token> expect_keyword(symbol keyword);
 
-        const char* identifier_at(const masonc::lexer::token& identifier_token);
-        const char* integer_at(const masonc::lexer::token& integer_token);
-        const char* decimal_at(const masonc::lexer::token& decimal_token);
-        const char* string_at(const masonc::lexer::token& string_token);
+        std::string_view identifier_at(const masonc::lexer::token& identifier_token);
+        std::string_view integer_at(const masonc::lexer::token& integer_token);
+        std::string_view decimal_at(const masonc::lexer::token& decimal_token);
+        std::string_view string_at(const masonc::lexer::token& string_token);
 
         // Assumes that the index is in range.
-        masonc::lexer::token_location* get_token_location(u64 token_index);
+        masonc::lexer::token_location get_token_location(u64 token_index);
+
+        // Appends "expr" to the expressions of the parser output.
+        expression_handle add_expression(const expression& expr);
+
+        // Moves the handles pushed to "list_stack" since it had "list_start" elements
+        // to the expression lists of the parser output.
+        expression_range end_list(u64 list_start);
 
         // Reports an error at the last token.
         void report_parse_error(const std::string& msg);
@@ -133,55 +235,57 @@ namespace masonc::parser
         //	  expression_procedure_definition |
         //	  expression_module_declaration  |
         //	  expression_module_import
-        std::optional<expression> parse_top_level();
+        std::optional<expression_handle> parse_top_level();
 
         // statement (statements allowed in procedure bodies)
         // := expression_variable_declaration |
         //    expression_procedure_call		  |
         //    assignment					  |
         //	  "return" expression
-        std::optional<expression> parse_statement();
+        std::optional<expression_handle> parse_statement();
 
         // expression
         // := expression_primary | expression_binary
 
         // Parse primary or binary expressions
-        std::optional<expression> parse_expression(parse_context context);
+        std::optional<expression_handle> parse_expression(parse_context context);
 
         // expression_primary
         // := expression_reference | expression_literal | expression_procedure_call |
         //    expression_unary
-        std::optional<expression> parse_primary(parse_context context);
+        std::optional<expression_handle> parse_primary(parse_context context);
 
-        // Parses right-hand side of a binary expression and returns the whole binary expression
-        std::optional<expression> parse_binary(parse_context context,
-            const expression& left, const binary_operator* op);
+        // Parses the binary operators following "left" whose precedence is at least "min_precedence",
+        // together with their right-hand sides, and returns the resulting tree.
+        // Returns "left" if the next token is not such an operator.
+        std::optional<expression_handle> parse_binary(expression_handle left, u32 min_precedence);
 
         // Parses either expression_primary which would ignore the parentheses,
         // or binary expression encased in parentheses, returning expression_parentheses
-        std::optional<expression> parse_parentheses(parse_context context);
+        std::optional<expression_handle> parse_parentheses(parse_context context);
 
-        std::optional<expression> parse_number_literal(parse_context context,
-            const char* number, number_type type);
+        std::optional<expression_handle> parse_number_literal(parse_context context,
+            u32 value_index, number_type type);
 
-        std::optional<expression> parse_string_literal(parse_context context, const char* str);
+        std::optional<expression_handle> parse_string_literal(parse_context context, u32 value_index);
 
-        std::optional<expression> parse_reference(parse_context context,
+        std::optional<expression_handle> parse_reference(parse_context context,
             symbol_handle identifier_handle);
 
-        std::optional<expression> parse_variable_declaration(parse_context context,
+        std::optional<expression_handle> parse_variable_declaration(parse_context context,
             symbol_handle name_handle, u8 specifiers);
 
-        std::optional<expression> parse_call(parse_context context, symbol_handle name_handle);
+        std::optional<expression_handle> parse_call(parse_context context, symbol_handle name_handle);
 
-        std::vector<expression> parse_argument_list();
+        // Returns an empty range if an error occured.
+        expression_range parse_argument_list();
 
         // Returns either Expression_Procedure_Prototype or Expression_Procedure_Definition
-        std::optional<expression> parse_procedure();
-        std::optional<expression> parse_procedure_body(const expression_procedure_prototype& prototype);
+        std::optional<expression_handle> parse_procedure();
+        std::optional<expression_handle> parse_procedure_body(expression_handle prototype);
 
-        std::optional<expression> parse_module_declaration();
-        std::optional<expression> parse_module_import();
+        std::optional<expression_handle> parse_module_declaration();
+        std::optional<expression_handle> parse_module_import();
     };
 
     // Returns `expression_binary` from either `expression_binary` or `expression_parentheses`.
@@ -10,9 +10,8 @@
 #include <binary_operator.hpp>
 #include <location.hpp>
 
-#include <vector>
 #include <optional>
-#include <string>
+#include <type_traits>
 
 namespace masonc::parser
 {
@@ -42,24 +41,35 @@ namespace masonc::parser
         NUMBER_DECIMAL
     };
 
-    struct expression;
+    // Index of an expression in "masonc::parser::parser_instance_output::expressions".
+    using expression_handle = u32;
+
+    // Consecutive handles in "masonc::parser::parser_instance_output::expression_lists",
+    // used for lists of expressions like arguments or the statements of a procedure body.
+    struct expression_range
+    {
+        u32 first;
+        u32 count;
+    };
 
     // FIXME: Maybe change expression_unary.expr into a union of expression_primary and
-    //		 expression_parentheses to avoid the pointer.
+    //		 expression_parentheses to avoid the indirection.
 
     // := op_code expression_primary | expression_parentheses
     struct expression_unary
     {
-        expression* expr;
+        expression_handle expr;
         s8 op_code;
     };
 
     // := expression op_code expression
     struct expression_binary
     {
-        expression* left;
-        expression* right;
-        const binary_operator* op;
+        expression_handle left;
+        expression_handle right;
+
+        // See "masonc::get_op".
+        s8 op_code;
     };
 
     // := '(' expression_binary ')'
@@ -83,34 +93,35 @@ namespace masonc::parser
     {
         symbol_handle name_handle;
         std::optional<type_handle> return_type_handle;
-        std::vector<expression> argument_list;
+        expression_range argument_list;
     };
 
     // := prototype '{' body '}'
     struct expression_procedure_definition
     {
-        expression_procedure_prototype prototype;
-        std::vector<expression> body;
+        // Refers to an "expression_procedure_prototype".
+        expression_handle prototype;
+        expression_range body;
     };
 
     // := name '(' argument_list? ')'
     struct expression_procedure_call
     {
         symbol_handle name_handle;
-        std::vector<expression> argument_list;
+        expression_range argument_list;
     };
 
     struct expression_number_literal
     {
-        // Non-owning pointer to string.
-        const char* value;
+        // Index of the value in the integers or decimals of the lexer output, depending on "type".
+        u32 value_index;
         number_type type;
     };
 
     struct expression_string_literal
     {
-        // Non-owning pointer to string.
-        const char* value;
+        // Index of the value in the strings of the lexer output.
+        u32 value_index;
     };
 
     struct expression_reference
@@ -120,18 +131,19 @@ namespace masonc::parser
 
     struct expression_module_declaration
     {
-        // Non-owning pointer to string.
-        // Note: This lives in parser_instance_output::module_name;
-        const char* name;
+        // The name lives in "masonc::parser::parser_instance_output::module_name",
+        // this is the token to report diagnostics about the declaration at.
+        u32 name_token_index;
     };
 
     struct expression_module_import
     {
         // Index of an element in the "masonc::mod::module_import_names" container.
-        u64 import_index;
+        u32 import_index;
 
-        // Pointer to an element in the "masonc::lexer::lexer_instance::locations" container.
-        masonc::lexer::token_location* name_location;
+        // Token to report diagnostics about the import at,
+        // see "masonc::lexer::lexer_instance_output::location_at".
+        u32 name_token_index;
     };
 
     enum expression_type : u8
@@ -151,228 +163,72 @@ namespace masonc::parser
         EXPR_MODULE_IMPORT
     };
 
-    union expression_union
+    // A node of the AST. Nodes refer to each other by "expression_handle" and never own memory,
+    // so a whole file's AST is a few flat arrays that can be copied and written out as they are.
+    struct expression
     {
-        struct expression_empty_tagged { expression_type type; } empty;
+        expression_type type;
 
-        struct expression_unary_tagged { expression_type type; expression_unary value; } unary;
-        struct expression_binary_tagged { expression_type type; expression_binary value; } binary;
-        struct expression_parentheses_tagged { expression_type type; expression_parentheses value; } parentheses;
-        struct expression_number_literal_tagged { expression_type type; expression_number_literal value; } number;
-        struct expression_string_literal_tagged { expression_type type; expression_string_literal value; } str;
-        struct expression_reference_tagged { expression_type type; expression_reference value; } reference;
-        struct expression_variable_declaration_tagged { expression_type type; expression_variable_declaration value; } variable_declaration;
-        struct expression_procedure_prototype_tagged { expression_type type; expression_procedure_prototype value; } procedure_prototype;
-        struct expression_procedure_definition_tagged { expression_type type; expression_procedure_definition value; } procedure_definition;
-        struct expression_procedure_call_tagged { expression_type type; expression_procedure_call value; } procedure_call;
-        struct expression_module_declaration_tagged { expression_type type; expression_module_declaration value; } module_declaration;
-        struct expression_module_import_tagged { expression_type type; expression_module_import value; } module_import;
-
-        expression_union()
-            : empty(expression_empty_tagged{ EXPR_EMPTY }) { }
+        union
+        {
+            expression_unary unary;
+            expression_binary binary;
+            expression_parentheses parentheses;
+            expression_number_literal number;
+            expression_string_literal str;
+            expression_reference reference;
+            expression_variable_declaration variable_declaration;
+            expression_procedure_prototype procedure_prototype;
+            expression_procedure_definition procedure_definition;
+            expression_procedure_call procedure_call;
+            expression_module_declaration module_declaration;
+            expression_module_import module_import;
+        };
 
-        // TODO: Take argument as reference or something?
-        expression_union(expression_unary value)
-            : unary(expression_unary_tagged{ EXPR_UNARY, value }) { }
+        // Empty expression
+        expression()
+            : type(EXPR_EMPTY), unary()
+        { }
 
-        expression_union(expression_binary value)
-            : binary(expression_binary_tagged{ EXPR_BINARY, value }) { }
+        expression(expression_unary value)
+            : type(EXPR_UNARY), unary(value) { }
 
-        expression_union(expression_parentheses value)
-            : parentheses(expression_parentheses_tagged{ EXPR_PARENTHESES, value }) { }
+        expression(expression_binary value)
+            : type(EXPR_BINARY), binary(value) { }
 
-        expression_union(expression_number_literal value)
-            : number(expression_number_literal_tagged{ EXPR_NUMBER_LITERAL, value }) { }
+        expression(expression_parentheses value)
+            : type(EXPR_PARENTHESES), parentheses(value) { }
 
-        expression_union(expression_string_literal value)
-            : str(expression_string_literal_tagged{ EXPR_STRING_LITERAL, value }) { }
+        expression(expression_number_literal value)
+            : type(EXPR_NUMBER_LITERAL), number(value) { }
 
-        expression_union(expression_reference value)
-            : reference(expression_reference_tagged{ EXPR_REFERENCE, value }) { }
+        expression(expression_string_literal value)
+            : type(EXPR_STRING_LITERAL), str(value) { }
 
-        expression_union(expression_variable_declaration value)
-            : variable_declaration(expression_variable_declaration_tagged{ EXPR_VAR_DECLARATION, value }) { }
+        expression(expression_reference value)
+            : type(EXPR_REFERENCE), reference(value) { }
 
-        expression_union(expression_procedure_prototype value)
-            : procedure_prototype(expression_procedure_prototype_tagged{ EXPR_PROC_PROTOTYPE, value }) { }
+        expression(expression_variable_declaration value)
+            : type(EXPR_VAR_DECLARATION), variable_declaration(value) { }
 
-        expression_union(expression_procedure_definition value)
-            : procedure_definition(expression_procedure_definition_tagged{ EXPR_PROC_DEFINITION, value }) { }
+        expression(expression_procedure_prototype value)
+            : type(EXPR_PROC_PROTOTYPE), procedure_prototype(value) { }
 
-        expression_union(expression_procedure_call value)
-            : procedure_call(expression_procedure_call_tagged{ EXPR_PROC_CALL, value }) { }
+        expression(expression_procedure_definition value)
+            : type(EXPR_PROC_DEFINITION), procedure_definition(value) { }
 
-        expression_union(expression_module_declaration value)
-            : module_declaration(expression_module_declaration_tagged{ EXPR_MODULE_DECLARATION, value }) { }
+        expression(expression_procedure_call value)
+            : type(EXPR_PROC_CALL), procedure_call(value) { }
 
-        expression_union(expression_module_import value)
-            : module_import(expression_module_import_tagged{ EXPR_MODULE_IMPORT, value }) { }
+        expression(expression_module_declaration value)
+            : type(EXPR_MODULE_DECLARATION), module_declaration(value) { }
 
-        ~expression_union()
-        {
-            // This is safe because no matter the current variant, it is guaranteed to be at the same address (and type is the first member in tagged expression struct)
-            switch (empty.type)
-            {
-                default:
-                    break;
-                case EXPR_EMPTY:
-                    break;
-                case EXPR_UNARY:
-                    unary.value.~expression_unary();
-                    break;
-                case EXPR_BINARY:
-                    binary.value.~expression_binary();
-                    break;
-                case EXPR_PARENTHESES:
-                    parentheses.value.~expression_parentheses();
-                    break;
-                case EXPR_NUMBER_LITERAL:
-                    number.value.~expression_number_literal();
-                    break;
-                case EXPR_STRING_LITERAL:
-                    str.value.~expression_string_literal();
-                    break;
-                case EXPR_REFERENCE:
-                    reference.value.~expression_reference();
-                    break;
-                case EXPR_VAR_DECLARATION:
-                    variable_declaration.value.~expression_variable_declaration();
-                    break;
-                case EXPR_PROC_PROTOTYPE:
-                    procedure_prototype.value.~expression_procedure_prototype();
-                    break;
-                case EXPR_PROC_DEFINITION:
-                    procedure_definition.value.~expression_procedure_definition();
-                    break;
-                case EXPR_PROC_CALL:
-                    procedure_call.value.~expression_procedure_call();
-                    break;
-                case EXPR_MODULE_DECLARATION:
-                    module_declaration.value.~expression_module_declaration();
-                    break;
-                case EXPR_MODULE_IMPORT:
-                    module_import.value.~expression_module_import();
-                    break;
-            }
-        }
-
-        expression_union(const expression_union& other)
-        {
-            // This is safe because no matter the current variant, it is guaranteed to be at the same address (and type is the first member in tagged expression struct)
-            switch (other.empty.type)
-            {
-                default:
-                    break;
-                case EXPR_EMPTY:
-                    new(&empty)expression_empty_tagged{};
-                    break;
-                case EXPR_UNARY:
-                    new(&empty)expression_unary_tagged{ EXPR_UNARY, other.unary.value };
-                    break;
-                case EXPR_BINARY:
-                    new(&empty)expression_binary_tagged{ EXPR_BINARY, other.binary.value };
-                    break;
-                case EXPR_PARENTHESES:
-                    new(&empty)expression_parentheses_tagged{ EXPR_PARENTHESES, other.parentheses.value };
-                    break;
-                case EXPR_NUMBER_LITERAL:
-                    new(&empty)expression_number_literal_tagged{ EXPR_NUMBER_LITERAL, other.number.value };
-                    break;
-                case EXPR_STRING_LITERAL:
-                    new(&empty)expression_string_literal_tagged{ EXPR_STRING_LITERAL, other.str.value };
-                    break;
-                case EXPR_REFERENCE:
-                    new(&empty)expression_reference_tagged{ EXPR_REFERENCE, other.reference.value };
-                    break;
-                case EXPR_VAR_DECLARATION:
-                    new(&empty)expression_variable_declaration_tagged{ EXPR_VAR_DECLARATION, other.variable_declaration.value };
-                    break;
-                case EXPR_PROC_PROTOTYPE:
-                    new(&empty)expression_procedure_prototype_tagged{ EXPR_PROC_PROTOTYPE, other.procedure_prototype.value };
-                    break;
-                case EXPR_PROC_DEFINITION:
-                    new(&empty)expression_procedure_definition_tagged{ EXPR_PROC_DEFINITION, other.procedure_definition.value };
-                    break;
-                case EXPR_PROC_CALL:
-                    new(&empty)expression_procedure_call_tagged{ EXPR_PROC_CALL, other.procedure_call.value };
-                    break;
-                case EXPR_MODULE_DECLARATION:
-                    new(&empty)expression_module_declaration_tagged{ EXPR_MODULE_DECLARATION, other.module_declaration.value };
-                    break;
-                case EXPR_MODULE_IMPORT:
-                    new(&empty)expression_module_import_tagged{ EXPR_MODULE_IMPORT, other.module_import.value };
-                    break;
-            }
-        }
-
-        expression_union& operator=(const expression_union& other)
-        {
-            // Destruct current variant
-            this->~expression_union();
-
-            // This is safe because no matter the current variant, it is guaranteed to be at the same address (and type is the first member in tagged expression struct)
-            switch (other.empty.type)
-            {
-                default:
-                    break;
-                case EXPR_EMPTY:
-                    new(&empty)expression_empty_tagged{};
-                    break;
-                case EXPR_UNARY:
-                    new(&empty)expression_unary_tagged{ EXPR_UNARY, other.unary.value };
-                    break;
-                case EXPR_BINARY:
-                    new(&empty)expression_binary_tagged{ EXPR_BINARY, other.binary.value };
-                    break;
-                case EXPR_PARENTHESES:
-                    new(&empty)expression_parentheses_tagged{ EXPR_PARENTHESES, other.parentheses.value };
-                    break;
-                case EXPR_NUMBER_LITERAL:
-                    new(&empty)expression_number_literal_tagged{ EXPR_NUMBER_LITERAL, other.number.value };
-                    break;
-                case EXPR_REFERENCE:
-                    new(&empty)expression_reference_tagged{ EXPR_REFERENCE, other.reference.value };
-                    break;
-                case EXPR_VAR_DECLARATION:
-                    new(&empty)expression_variable_declaration_tagged{ EXPR_VAR_DECLARATION, other.variable_declaration.value };
-                    break;
-                case EXPR_PROC_PROTOTYPE:
-                    new(&empty)expression_procedure_prototype_tagged{ EXPR_PROC_PROTOTYPE, other.procedure_prototype.value };
-                    break;
-                case EXPR_PROC_DEFINITION:
-                    new(&empty)expression_procedure_definition_tagged{ EXPR_PROC_DEFINITION, other.procedure_definition.value };
-                    break;
-                case EXPR_PROC_CALL:
-                    new(&empty)expression_procedure_call_tagged{ EXPR_PROC_CALL, other.procedure_call.value };
-                    break;
-                case EXPR_MODULE_DECLARATION:
-                    new(&empty)expression_module_declaration_tagged{ EXPR_MODULE_DECLARATION, other.module_declaration.value };
-                    break;
-                case EXPR_MODULE_IMPORT:
-                    new(&empty)expression_module_import_tagged{ EXPR_MODULE_IMPORT, other.module_import.value };
-                    break;
-            }
-
-            return *this;
-        }
+        expression(expression_module_import value)
+            : type(EXPR_MODULE_IMPORT), module_import(value) { }
     };
 
-    struct expression
-    {
-        expression_union value;
-
-        // Empty expression
-        expression()
-            : value()
-        { }
-
-        expression(expression_union value)
-            : value(value)
-        { }
-
-        expression(const expression& other) = default;
-        ~expression() = default;
-    };
+    static_assert(std::is_trivially_copyable_v<expression>);
+    static_assert(sizeof(expression) <= 24);
 }
 
 #endif
\ No newline at end of file
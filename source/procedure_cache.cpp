@@ -0,0 +1,396 @@
+#include <procedure_cache.hpp>
+
+#include <version.hpp>
+#include <io.hpp>
+#include <logger.hpp>
+#include <interner.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <string_view>
+
+namespace masonc::cache
+{
+    using masonc::parser::expression;
+    using masonc::parser::expression_handle;
+    using masonc::parser::parser_instance_output;
+
+    // "MASONCPC" in a little-endian integer, tells entries apart from other files.
+    static constexpr u64 ENTRY_MAGIC = 0x4350434e4f53414d;
+
+    // Written at the start of every entry, followed by the object file and then by the symbols
+    // it defines, each one terminated by a null character.
+    struct entry_header
+    {
+        u64 magic;
+        u64 key;
+        u64 object_size;
+
+        // Of everything after the header, so that a damaged entry is not mistaken for a valid one.
+        u64 contents_hash;
+
+        u32 format_version;
+    };
+
+    // Same mixing step as "masonc::lexer::lexer_instance_output::hash_tokens".
+    static void hash_combine(u64* hash, u64 value)
+    {
+        *hash = ((*hash << 5) | (*hash >> 59)) ^ value;
+        *hash *= 0x517cc1b727220a95;
+    }
+
+    // String IDs differ between runs, so names are hashed by their text.
+    static u64 name_hash(string_id name)
+    {
+        return robin_hood::hash<std::string_view>{}(global_interner.at(name));
+    }
+
+    static void hash_variable_declaration(u64* hash,
+        const masonc::parser::expression_variable_declaration& declaration)
+    {
+        hash_combine(hash, name_hash(declaration.type_handle));
+        hash_combine(hash, (static_cast<u64>(declaration.specifiers) << 1) | declaration.is_pointer);
+    }
+
+    static void hash_prototype(u64* hash, const parser_instance_output& module,
+        const masonc::parser::expression_procedure_prototype& prototype)
+    {
+        hash_combine(hash, name_hash(prototype.name_handle));
+        hash_combine(hash, prototype.return_type_handle ? name_hash(prototype.return_type_handle.value()) : 0);
+        hash_combine(hash, prototype.argument_list.count);
+
+        for (u32 i = 0; i < prototype.argument_list.count; i += 1) {
+            const expression& argument = module.expression_at(module.list_at(prototype.argument_list, i));
+
+            if (argument.type == masonc::parser::EXPR_VAR_DECLARATION)
+                hash_variable_declaration(hash, argument.variable_declaration);
+        }
+    }
+
+    // What "procedure_hash" keeps track of while it walks a procedure.
+    struct procedure_hash_state
+    {
+        explicit procedure_hash_state(const signature_lookup& signatures)
+            : signatures{ signatures }
+        { }
+
+        const signature_lookup& signatures;
+
+        // Arguments, variables and procedures the procedure declared so far, they are not looked up.
+        robin_hood::unordered_flat_set<symbol> local_names;
+
+        // Cleared when a name is neither local nor known to "signatures".
+        bool resolved = true;
+    };
+
+    static void hash_reference(u64* hash, symbol name, procedure_hash_state* state)
+    {
+        hash_combine(hash, name_hash(name));
+
+        if (state->local_names.find(name) != state->local_names.end())
+            return;
+
+        std::optional<u64> signature = state->signatures(name);
+
+        if (!signature) {
+            state->resolved = false;
+            return;
+        }
+
+        hash_combine(hash, signature.value());
+    }
+
+    static std::optional<u64> procedure_hash(const parser_instance_output& module,
+        const masonc::parser::expression_procedure_definition& definition, procedure_hash_state* state);
+
+    static void hash_expression(u64* hash, const parser_instance_output& module, expression_handle handle,
+        procedure_hash_state* state)
+    {
+        const expression& expr = module.expression_at(handle);
+        hash_combine(hash, expr.type);
+
+        switch (expr.type) {
+            default:
+                break;
+            case masonc::parser::EXPR_UNARY:
+                hash_combine(hash, static_cast<u8>(expr.unary.op_code));
+                hash_expression(hash, module, expr.unary.expr, state);
+                break;
+            case masonc::parser::EXPR_BINARY:
+                hash_combine(hash, static_cast<u8>(expr.binary.op_code));
+                hash_expression(hash, module, expr.binary.left, state);
+                hash_expression(hash, module, expr.binary.right, state);
+                break;
+            case masonc::parser::EXPR_PARENTHESES:
+                hash_combine(hash, static_cast<u8>(expr.parentheses.expr.op_code));
+                hash_expression(hash, module, expr.parentheses.expr.left, state);
+                hash_expression(hash, module, expr.parentheses.expr.right, state);
+                break;
+            case masonc::parser::EXPR_NUMBER_LITERAL:
+                hash_combine(hash, expr.number.type);
+                hash_combine(hash, robin_hood::hash<std::string_view>{}(module.number_value(expr.number)));
+                break;
+            case masonc::parser::EXPR_STRING_LITERAL:
+                hash_combine(hash, robin_hood::hash<std::string_view>{}(module.string_value(expr.str)));
+                break;
+            case masonc::parser::EXPR_REFERENCE:
+                hash_reference(hash, expr.reference.name_handle, state);
+                break;
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                hash_combine(hash, name_hash(expr.variable_declaration.name_handle));
+                hash_variable_declaration(hash, expr.variable_declaration);
+                state->local_names.insert(expr.variable_declaration.name_handle);
+                break;
+            case masonc::parser::EXPR_PROC_PROTOTYPE:
+                hash_prototype(hash, module, expr.procedure_prototype);
+                state->local_names.insert(expr.procedure_prototype.name_handle);
+                break;
+            case masonc::parser::EXPR_PROC_DEFINITION: {
+                state->local_names.insert(
+                    module.expression_at(expr.procedure_definition.prototype).procedure_prototype.name_handle);
+
+                std::optional<u64> nested_hash = procedure_hash(module, expr.procedure_definition, state);
+
+                if (nested_hash)
+                    hash_combine(hash, nested_hash.value());
+                else
+                    state->resolved = false;
+
+                break;
+            }
+            case masonc::parser::EXPR_PROC_CALL:
+                hash_reference(hash, expr.procedure_call.name_handle, state);
+                hash_combine(hash, expr.procedure_call.argument_list.count);
+
+                for (u32 i = 0; i < expr.procedure_call.argument_list.count; i += 1) {
+                    hash_expression(hash, module, module.list_at(expr.procedure_call.argument_list, i),
+                        state);
+                }
+
+                break;
+        }
+    }
+
+    std::optional<u64> declaration_signature(const parser_instance_output& module, expression_handle top_level)
+    {
+        const expression& expr = module.expression_at(top_level);
+        u64 hash = expr.type;
+
+        switch (expr.type) {
+            default:
+                return std::nullopt;
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                hash_combine(&hash, name_hash(expr.variable_declaration.name_handle));
+                hash_variable_declaration(&hash, expr.variable_declaration);
+                break;
+            case masonc::parser::EXPR_PROC_PROTOTYPE:
+                hash_prototype(&hash, module, expr.procedure_prototype);
+                break;
+            case masonc::parser::EXPR_PROC_DEFINITION:
+                // A definition looks like its prototype to callers.
+                hash = masonc::parser::EXPR_PROC_PROTOTYPE;
+                hash_prototype(&hash, module, module.expression_at(expr.procedure_definition.prototype)
+                    .procedure_prototype);
+                break;
+        }
+
+        return robin_hood::hash_int(hash);
+    }
+
+    void add_signatures(const parser_instance_output& module, signature_map* signatures)
+    {
+        for (expression_handle top_level : module.AST) {
+            const expression& expr = module.expression_at(top_level);
+
+            symbol name;
+
+            if (expr.type == masonc::parser::EXPR_VAR_DECLARATION) {
+                name = expr.variable_declaration.name_handle;
+            }
+            else if (expr.type == masonc::parser::EXPR_PROC_PROTOTYPE) {
+                name = expr.procedure_prototype.name_handle;
+            }
+            else if (expr.type == masonc::parser::EXPR_PROC_DEFINITION) {
+                name = module.expression_at(expr.procedure_definition.prototype).procedure_prototype.name_handle;
+            }
+            else {
+                continue;
+            }
+
+            signatures->insert_or_assign(name, declaration_signature(module, top_level).value());
+        }
+    }
+
+    // Names declared by an enclosing procedure are local to a nested one as well.
+    static std::optional<u64> procedure_hash(const parser_instance_output& module,
+        const masonc::parser::expression_procedure_definition& definition, procedure_hash_state* state)
+    {
+        u64 hash = masonc::parser::EXPR_PROC_DEFINITION;
+
+        const masonc::parser::expression_procedure_prototype& prototype =
+            module.expression_at(definition.prototype).procedure_prototype;
+
+        hash_prototype(&hash, module, prototype);
+
+        for (u32 i = 0; i < prototype.argument_list.count; i += 1) {
+            const expression& argument = module.expression_at(module.list_at(prototype.argument_list, i));
+
+            if (argument.type == masonc::parser::EXPR_VAR_DECLARATION)
+                state->local_names.insert(argument.variable_declaration.name_handle);
+        }
+
+        hash_combine(&hash, definition.body.count);
+
+        for (u32 i = 0; i < definition.body.count; i += 1) {
+            hash_expression(&hash, module, module.list_at(definition.body, i), state);
+        }
+
+        if (!state->resolved)
+            return std::nullopt;
+
+        return robin_hood::hash_int(hash);
+    }
+
+    std::optional<u64> procedure_hash(const parser_instance_output& module,
+        const masonc::parser::expression_procedure_definition& definition, const signature_lookup& signatures)
+    {
+        procedure_hash_state state{ signatures };
+        return procedure_hash(module, definition, &state);
+    }
+
+    procedure_cache::procedure_cache(const std::string& directory)
+        : directory{ directory }
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        if (error) {
+            global_logger.log_error(
+                std::string{ "Unable to create cache directory '" + directory + "'" }
+                .c_str()
+            );
+        }
+    }
+
+    u64 procedure_cache::key(u64 procedure_hash, const std::string& configuration)
+    {
+        u64 version_hash = robin_hood::hash_bytes(VERSION, sizeof(VERSION)) ^ PROCEDURE_CACHE_FORMAT_VERSION;
+        u64 configuration_hash = robin_hood::hash_bytes(configuration.data(), configuration.size());
+
+        return robin_hood::hash_int(procedure_hash ^ version_hash ^ robin_hood::hash_int(configuration_hash));
+    }
+
+    std::optional<archive_member> procedure_cache::load(u64 key, const std::string& member_name) const
+    {
+        std::string path = entry_path(key);
+
+        // A miss is expected, "file_map" would report it as an error.
+        std::error_code error;
+        if (!std::filesystem::exists(path, error))
+            return std::nullopt;
+
+        std::optional<mapped_file> entry = file_map(path.c_str());
+        if (!entry)
+            return std::nullopt;
+
+        entry_header header{};
+        const char* contents = nullptr;
+        u64 contents_size = 0;
+
+        bool valid = entry->size() >= sizeof(header);
+
+        if (valid) {
+            std::memcpy(&header, entry->data(), sizeof(header));
+            contents = entry->data() + sizeof(header);
+            contents_size = entry->size() - sizeof(header);
+
+            valid = header.magic == ENTRY_MAGIC && header.key == key &&
+                header.format_version == PROCEDURE_CACHE_FORMAT_VERSION &&
+                header.object_size <= contents_size &&
+                robin_hood::hash_bytes(contents, contents_size) == header.contents_hash;
+        }
+
+        // Every symbol is terminated, so the entry has to end with a terminator unless there are none.
+        if (valid && header.object_size < contents_size)
+            valid = contents[contents_size - 1] == '\0';
+
+        if (!valid) {
+            global_logger.log_warning(
+                std::string{ "Ignoring damaged cache entry '" + path + "'" }
+                .c_str()
+            );
+
+            return std::nullopt;
+        }
+
+        archive_member object;
+        object.name = member_name;
+        object.contents.assign(contents, header.object_size);
+
+        for (u64 offset = header.object_size; offset < contents_size;) {
+            std::string_view name{ contents + offset };
+
+            object.symbols.emplace_back(name);
+            offset += name.length() + 1;
+        }
+
+        return object;
+    }
+
+    bool procedure_cache::store(u64 key, const archive_member& object) const
+    {
+        entry_header header{};
+        header.magic = ENTRY_MAGIC;
+        header.key = key;
+        header.object_size = object.contents.size();
+        header.format_version = PROCEDURE_CACHE_FORMAT_VERSION;
+
+        std::string entry;
+        entry.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        entry += object.contents;
+
+        for (const std::string& name : object.symbols) {
+            entry += name;
+            entry += '\0';
+        }
+
+        header.contents_hash = robin_hood::hash_bytes(entry.data() + sizeof(header), entry.size() - sizeof(header));
+        std::memcpy(entry.data(), &header, sizeof(header));
+
+        // Written to a file of its own first and renamed, so that no other build
+        // ever sees half an entry, and threads storing the same entry do not interfere.
+        std::string path = entry_path(key);
+        std::string temporary_path = path + "." +
+            std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+        std::FILE* file = std::fopen(temporary_path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        bool written = std::fwrite(entry.data(), 1, entry.size(), file) == entry.size();
+        written = std::fclose(file) == 0 && written;
+
+        std::error_code error;
+
+        if (written)
+            std::filesystem::rename(temporary_path, path, error);
+
+        if (!written || error) {
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    std::string procedure_cache::entry_path(u64 key) const
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+        return directory + "/" + name + ".pcache";
+    }
+}
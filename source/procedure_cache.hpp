@@ -0,0 +1,76 @@
+#ifndef MASONC_PROCEDURE_CACHE_HPP
+#define MASONC_PROCEDURE_CACHE_HPP
+
+#include <common.hpp>
+#include <parser.hpp>
+#include <symbol.hpp>
+#include <archive.hpp>
+
+#include <string>
+#include <optional>
+#include <functional>
+
+#include <robin_hood.hpp>
+
+namespace masonc::cache
+{
+    // Increase whenever the layout of an entry or the way procedures are hashed changes.
+    constexpr u32 PROCEDURE_CACHE_FORMAT_VERSION = 2;
+
+    // Hashes of the declarations of a module by their name, see "declaration_signature".
+    using signature_map = robin_hood::unordered_flat_map<symbol, u64>;
+
+    // Returns the signature hash of the symbol with the given name, if the name refers to a declaration.
+    using signature_lookup = std::function<std::optional<u64>(symbol name)>;
+
+    // Hash of what other code sees of the top-level expression "top_level" of "module",
+    // which is the name and types of a procedure prototype or definition, or of a global variable.
+    // Returns an empty optional for other expressions.
+    std::optional<u64> declaration_signature(const masonc::parser::parser_instance_output& module,
+        masonc::parser::expression_handle top_level);
+
+    // Adds the signature of every top-level declaration of "module" to "signatures".
+    void add_signatures(const masonc::parser::parser_instance_output& module, signature_map* signatures);
+
+    // Structural hash of the procedure definition "definition" of "module".
+    //
+    // Names are hashed by their text and literals by their value, so the hash is the same
+    // in every run and does not change when other parts of the file do. The signature of every name
+    // the procedure calls or refers to is part of the hash too, so a procedure changes when a procedure
+    // it calls changes its arguments, but not when only its body changes.
+    //
+    // Returns an empty optional if "signatures" does not know a name that is not declared by the procedure
+    // itself, because then the hash would not change with its declaration and may not be cached.
+    std::optional<u64> procedure_hash(const masonc::parser::parser_instance_output& module,
+        const masonc::parser::expression_procedure_definition& definition, const signature_lookup& signatures);
+
+    // Object files of single procedures, kept in a directory across builds.
+    //
+    // An entry is named by "key", a hash of the procedure, everything that decides what it is compiled into,
+    // the compiler version and the format version. Like with "module_cache", a changed procedure
+    // misses and gets an entry of its own, so entries are never out of date. Old entries are not deleted.
+    struct procedure_cache
+    {
+        // Creates "directory" if it does not exist.
+        explicit procedure_cache(const std::string& directory);
+
+        // Key of the entry of a procedure with hash "procedure_hash" compiled with "configuration",
+        // see "masonc::llvm::llvm_emitter::configuration".
+        static u64 key(u64 procedure_hash, const std::string& configuration);
+
+        // Returns the object stored as the entry "key", named "member_name".
+        // Returns an empty optional if there is no valid entry.
+        std::optional<archive_member> load(u64 key, const std::string& member_name) const;
+
+        // Writes "object" as the entry "key", its name is not stored.
+        // Returns false if the entry could not be written. Can be called from several threads at once.
+        bool store(u64 key, const archive_member& object) const;
+
+    private:
+        std::string directory;
+
+        std::string entry_path(u64 key) const;
+    };
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include <symbol_table.hpp>
+
+#include <interner.hpp>
+#include <procedure_cache.hpp>
+#include <binary_operator.hpp>
+
+#include <mutex>
+
+namespace masonc
+{
+    // Returns the name that the top-level expression "top_level" of "module" declares, if it declares one.
+    // The module scope has more symbols, like the arguments of procedures, but only these are visible to other files.
+    static std::optional<symbol> declared_name(const masonc::parser::parser_instance_output* module,
+        masonc::parser::expression_handle top_level)
+    {
+        const masonc::parser::expression& expr = module->expression_at(top_level);
+
+        switch (expr.type) {
+            default:
+                return std::nullopt;
+            case masonc::parser::EXPR_VAR_DECLARATION:
+                return expr.variable_declaration.name_handle;
+            case masonc::parser::EXPR_PROC_PROTOTYPE:
+                return expr.procedure_prototype.name_handle;
+            case masonc::parser::EXPR_PROC_DEFINITION:
+                return module->expression_at(expr.procedure_definition.prototype).procedure_prototype.name_handle;
+            case masonc::parser::EXPR_BINARY: {
+                // A global variable with an initializer.
+                const masonc::parser::expression& left = module->expression_at(expr.binary.left);
+
+                if (expr.binary.op_code != OP_EQUALS.op_code || left.type != masonc::parser::EXPR_VAR_DECLARATION)
+                    return std::nullopt;
+
+                return left.variable_declaration.name_handle;
+            }
+        }
+    }
+
+    static masonc::parser::expression_type declaration_type(const declaration& found)
+    {
+        return found.module->expression_at(found.module->AST[found.top_level_index]).type;
+    }
+
+    // Whether "first" and "second" may declare the same procedure, which is the case if at least one
+    // of them is a prototype and both have the same signature, see "masonc::cache::declaration_signature".
+    static bool compatible_declarations(const declaration& first, const declaration& second)
+    {
+        masonc::parser::expression_type first_type = declaration_type(first);
+        masonc::parser::expression_type second_type = declaration_type(second);
+
+        if (first_type != masonc::parser::EXPR_PROC_PROTOTYPE && second_type != masonc::parser::EXPR_PROC_PROTOTYPE)
+            return false;
+
+        if (first_type == masonc::parser::EXPR_VAR_DECLARATION || second_type == masonc::parser::EXPR_VAR_DECLARATION)
+            return false;
+
+        return masonc::cache::declaration_signature(*first.module, first.module->AST[first.top_level_index]) ==
+            masonc::cache::declaration_signature(*second.module, second.module->AST[second.top_level_index]);
+    }
+
+    std::vector<declaration> symbol_table::add_module(const masonc::parser::parser_instance_output* module)
+    {
+        symbol module_name = global_interner.intern(module->module_name);
+        std::vector<declaration> duplicates;
+
+        for (u64 i = 0; i < module->AST.size(); i += 1) {
+            std::optional<symbol> name = declared_name(module, module->AST[i]);
+            if (!name)
+                continue;
+
+            declaration current_declaration{ module, static_cast<u32>(i), name.value() };
+
+            u64 current_key = key(module_name, name.value());
+            shard& current_shard = shards[shard_index(current_key)];
+
+            std::unique_lock<std::shared_mutex> unique_lock{ current_shard.mutex };
+
+            auto [declaration_it, inserted] = current_shard.declarations.emplace(current_key, current_declaration);
+            if (inserted)
+                continue;
+
+            if (!compatible_declarations(declaration_it->second, current_declaration)) {
+                duplicates.push_back(current_declaration);
+                continue;
+            }
+
+            // A definition is kept over a prototype, so that the declaration is the procedure itself.
+            if (declaration_type(current_declaration) == masonc::parser::EXPR_PROC_DEFINITION)
+                declaration_it->second = current_declaration;
+        }
+
+        return duplicates;
+    }
+
+    std::optional<declaration> symbol_table::find(symbol module_name, symbol name) const
+    {
+        u64 search_key = key(module_name, name);
+        const shard& current_shard = shards[shard_index(search_key)];
+
+        std::shared_lock<std::shared_mutex> shared_lock{ current_shard.mutex };
+
+        auto find_it = current_shard.declarations.find(search_key);
+        if (find_it == current_shard.declarations.end())
+            return std::nullopt;
+
+        return find_it->second;
+    }
+
+    std::optional<declaration> symbol_table::find_imported(
+        const masonc::parser::parser_instance_output* module, symbol name) const
+    {
+        for (symbol import_name : module->file_module.module_imports) {
+            std::optional<declaration> search = find(import_name, name);
+            if (search)
+                return search;
+        }
+
+        return std::nullopt;
+    }
+
+    u64 symbol_table::size() const
+    {
+        u64 result = 0;
+
+        for (const shard& current_shard : shards) {
+            std::shared_lock<std::shared_mutex> shared_lock{ current_shard.mutex };
+            result += current_shard.declarations.size();
+        }
+
+        return result;
+    }
+
+    u64 symbol_table::key(symbol module_name, symbol name)
+    {
+        return (static_cast<u64>(module_name) << 32) | name;
+    }
+
+    u32 symbol_table::shard_index(u64 key)
+    {
+        // Use the upper bits, the lower ones are what the shard's hash map indexes with.
+        u64 hash = static_cast<u64>(robin_hood::hash<u64>{}(key));
+        return static_cast<u32>(hash >> (64 - SHARD_BITS));
+    }
+}
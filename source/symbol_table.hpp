@@ -0,0 +1,75 @@
+#ifndef MASONC_SYMBOL_TABLE_HPP
+#define MASONC_SYMBOL_TABLE_HPP
+
+#include <common.hpp>
+#include <parser.hpp>
+#include <symbol.hpp>
+
+#include <array>
+#include <vector>
+#include <optional>
+#include <shared_mutex>
+
+#include <robin_hood.hpp>
+
+namespace masonc
+{
+    // Top-level expression that declares a symbol.
+    struct declaration
+    {
+        const masonc::parser::parser_instance_output* module;
+
+        // Index into "parser_instance_output::AST".
+        u32 top_level_index;
+
+        // Symbol that is declared.
+        symbol name;
+    };
+
+    // Thread-safe map from a module name and a name declared at its top level to the declaration
+    // of the symbol, filled by the parser workers as they finish files. Modules are identified
+    // by their interned name, so several files of the same module share their symbols.
+    //
+    // Like "string_interner", entries are spread over shards by their hash so that workers
+    // adding different modules rarely wait on the same lock.
+    struct symbol_table
+    {
+        // Adds the name declared by every top-level expression of "module", which has to outlive the table.
+        // Returns the declarations of "module" whose symbol was declared by another file
+        // of the same module already, in which case the earlier declaration is kept.
+        // A procedure prototype with the same signature as the earlier declaration is no duplicate,
+        // and a definition replaces a matching prototype.
+        std::vector<declaration> add_module(const masonc::parser::parser_instance_output* module);
+
+        // Returns the declaration of "name" in the module named "module_name".
+        std::optional<declaration> find(symbol module_name, symbol name) const;
+
+        // Returns the declaration of "name" in one of the modules that "module" imports.
+        // Each import costs a single lookup by its interned name, no scopes are searched.
+        std::optional<declaration> find_imported(const masonc::parser::parser_instance_output* module,
+            symbol name) const;
+
+        // Number of symbols in the table.
+        u64 size() const;
+
+    private:
+        static constexpr u32 SHARD_BITS = 5;
+        static constexpr u32 SHARD_COUNT = 1u << SHARD_BITS;
+
+        struct shard
+        {
+            // Protects "declarations".
+            mutable std::shared_mutex mutex;
+
+            // Keyed by "key".
+            robin_hood::unordered_flat_map<u64, declaration> declarations;
+        };
+
+        std::array<shard, SHARD_COUNT> shards;
+
+        static u64 key(symbol module_name, symbol name);
+        static u32 shard_index(u64 key);
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include <allocation_counter.hpp>
+
+#ifdef MASONC_COUNT_ALLOCATIONS
+
+#include <new>
+#include <cstdlib>
+
+namespace masonc::test
+{
+    static thread_local u64 thread_allocation_count = 0;
+
+    allocation_counter::allocation_counter()
+        : start_count{ thread_allocation_count }
+    { }
+
+    u64 allocation_counter::count() const
+    {
+        return thread_allocation_count - start_count;
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    masonc::test::thread_allocation_count += 1;
+
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr)
+        throw std::bad_alloc{};
+
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef MASONC_TEST_ALLOCATION_COUNTER_HPP
+#define MASONC_TEST_ALLOCATION_COUNTER_HPP
+
+#include <common.hpp>
+
+#ifdef MASONC_COUNT_ALLOCATIONS
+
+namespace masonc::test
+{
+    // Counts the calls to the global "operator new" made by the current thread
+    // since the counter was constructed.
+    //
+    // Only exists with "MASONC_COUNT_ALLOCATIONS", which is only defined for the test executable,
+    // because it replaces the global allocation functions of the whole program.
+    // They forward to "malloc" and "free" and only increase a thread-local number.
+    struct allocation_counter
+    {
+        allocation_counter();
+
+        u64 count() const;
+
+    private:
+        u64 start_count;
+    };
+}
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include <temporary_directory.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace masonc::test
+{
+    static std::atomic<u64> directory_count = 0;
+
+    static u64 process_id()
+    {
+#if defined(_WIN32)
+        return static_cast<u64>(_getpid());
+#else
+        return static_cast<u64>(getpid());
+#endif
+    }
+
+    temporary_directory::temporary_directory(const char* name)
+    {
+        std::string unique_name = std::string{ name } + "_" + std::to_string(process_id()) + "_" +
+            std::to_string(directory_count.fetch_add(1));
+
+        directory = (std::filesystem::temp_directory_path() / unique_name).string();
+
+        // Left over from a process that had the same ID and did not get to clean up.
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    temporary_directory::~temporary_directory()
+    {
+        // Not being able to clean up should not fail a test.
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    const std::string& temporary_directory::path() const
+    {
+        return directory;
+    }
+}
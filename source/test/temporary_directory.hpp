@@ -0,0 +1,28 @@
+#ifndef MASONC_TEST_TEMPORARY_DIRECTORY_HPP
+#define MASONC_TEST_TEMPORARY_DIRECTORY_HPP
+
+#include <common.hpp>
+
+#include <string>
+
+namespace masonc::test
+{
+    // Empty directory in the temporary directory of the system, named after "name", the process
+    // and a counter, so that no two tests share one, even if several test processes run at once.
+    // The directory and everything in it is removed when the object is destroyed.
+    struct temporary_directory
+    {
+        explicit temporary_directory(const char* name);
+        ~temporary_directory();
+
+        temporary_directory(const temporary_directory& other) = delete;
+        temporary_directory& operator=(const temporary_directory& other) = delete;
+
+        const std::string& path() const;
+
+    private:
+        std::string directory;
+    };
+}
+
+#endif
@@ -4,6 +4,16 @@
 #include <test_dependency_list.hpp>
 //#include <test_dependency_graph.hpp>
 #include <test_parser.hpp>
+#include <test_lexer.hpp>
+#include <test_interner.hpp>
+#include <test_scope.hpp>
+#include <test_symbol_table.hpp>
+#include <test_scheduler.hpp>
+#include <test_bounded_queue.hpp>
+#include <test_module_cache.hpp>
+#include <test_procedure_cache.hpp>
+#include <test_archive.hpp>
+#include <test_llvm_jit.hpp>
 #include <test_misc.hpp>
 
 #include <common.hpp>
@@ -22,7 +32,24 @@ namespace masonc::test
         perform_iterator_tests();
         perform_dependency_list_tests();
         //perform_dependency_graph_tests();
+        perform_interner_tests();
+        perform_scope_tests();
+        perform_symbol_table_tests();
+        perform_scheduler_tests();
+        perform_bounded_queue_tests();
+        perform_lexer_tests();
         perform_parser_tests();
+        perform_module_cache_tests();
+        perform_procedure_cache_tests();
+        perform_archive_tests();
+        perform_llvm_jit_tests();
+    }
+
+    void perform_all_benchmarks()
+    {
+        masonc::test::lexer::benchmark_lexer_throughput();
+        masonc::test::parser::benchmark_parser();
+        masonc::test::parser::benchmark_incremental_reparse();
     }
 
     void perform_iterator_tests()
@@ -38,6 +65,8 @@ namespace masonc::test
         masonc::test::dependency_list::test_add_vertex_and_iterator();
         masonc::test::dependency_list::test_find();
         masonc::test::dependency_list::test_find_cycles();
+        masonc::test::dependency_list::test_waves();
+        masonc::test::dependency_list::test_long_chain();
     }
 
     /*
@@ -49,8 +78,51 @@ namespace masonc::test
     }
     */
 
+    void perform_interner_tests()
+    {
+        masonc::test::interner::test_intern();
+        masonc::test::interner::test_concurrent_intern();
+    }
+
+    void perform_scope_tests()
+    {
+        masonc::test::scope::test_find_symbol();
+    }
+
+    void perform_symbol_table_tests()
+    {
+        masonc::test::symbol_table::test_concurrent_add_module();
+        masonc::test::symbol_table::test_declarations_across_files();
+    }
+
+    void perform_scheduler_tests()
+    {
+        masonc::test::scheduler::test_all_jobs_run();
+        masonc::test::scheduler::test_stealing();
+        masonc::test::scheduler::test_priority_order();
+    }
+
+    void perform_bounded_queue_tests()
+    {
+        masonc::test::bounded_queue::test_producers_consumers();
+    }
+
+    void perform_lexer_tests()
+    {
+        masonc::test::lexer::test_scanner_equivalence();
+        masonc::test::lexer::test_token_locations();
+        masonc::test::lexer::test_parallel_lexing();
+        masonc::test::lexer::test_retokenize();
+    }
+
     void perform_parser_tests()
     {
+        masonc::test::parser::test_operator_precedence();
+#ifdef MASONC_COUNT_ALLOCATIONS
+        masonc::test::parser::test_parse_allocations();
+#endif
+        masonc::test::parser::test_incremental_reparse();
+
         auto parse_tests_pass = masonc::test::parser::test_parse_in_directory("tests/pass", true);
         for(u64 i = 0; i < parse_tests_pass.matched_expected.size(); i += 1) {
             if(!parse_tests_pass.matched_expected[i]) {
@@ -71,4 +143,26 @@ namespace masonc::test
             }
         }
     }
+
+    void perform_module_cache_tests()
+    {
+        masonc::test::module_cache::test_store_and_load();
+        masonc::test::module_cache::test_damaged_entries();
+    }
+
+    void perform_procedure_cache_tests()
+    {
+        masonc::test::procedure_cache::test_procedure_hash();
+        masonc::test::procedure_cache::test_store_and_load();
+    }
+
+    void perform_archive_tests()
+    {
+        masonc::test::archive::test_archive_create();
+    }
+
+    void perform_llvm_jit_tests()
+    {
+        masonc::test::llvm_jit::test_run();
+    }
 }
\ No newline at end of file
@@ -7,10 +7,23 @@ namespace masonc::test
 {
     void perform_all_tests();
 
+    // Benchmarks are not part of "perform_all_tests", they take a while and only print their results.
+    void perform_all_benchmarks();
+
     void perform_iterator_tests();
     void perform_dependency_list_tests();
     //void perform_dependency_graph_tests();
+    void perform_interner_tests();
+    void perform_scope_tests();
+    void perform_symbol_table_tests();
+    void perform_scheduler_tests();
+    void perform_bounded_queue_tests();
+    void perform_lexer_tests();
     void perform_parser_tests();
+    void perform_module_cache_tests();
+    void perform_procedure_cache_tests();
+    void perform_archive_tests();
+    void perform_llvm_jit_tests();
 }
 
 #endif
\ No newline at end of file
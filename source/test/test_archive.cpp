@@ -0,0 +1,61 @@
+#include <test_archive.hpp>
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace masonc::test::archive
+{
+    static u32 read_u32_big_endian(const std::string& input, u64 offset)
+    {
+        return (static_cast<u32>(static_cast<u8>(input[offset])) << 24) |
+               (static_cast<u32>(static_cast<u8>(input[offset + 1])) << 16) |
+               (static_cast<u32>(static_cast<u8>(input[offset + 2])) << 8) |
+               static_cast<u32>(static_cast<u8>(input[offset + 3]));
+    }
+
+    void test_archive_create()
+    {
+        std::vector<archive_member> members = {
+            archive_member{ "short.o", "odd", { "first", "second" } },
+            archive_member{ "a_rather_long_module_name.o", "even", { "third" } }
+        };
+
+        std::string output = archive_create(members);
+
+        if (output.compare(0, 8, "!<arch>\n") != 0 || output.compare(8, 16, "/               ") != 0)
+            throw std::runtime_error{ "archive test failed: missing magic or symbol index" };
+
+        // The index follows its 60-byte header.
+        u64 index_offset = 8 + 60;
+
+        if (read_u32_big_endian(output, index_offset) != 3)
+            throw std::runtime_error{ "archive test failed: unexpected symbol count" };
+
+        u32 first_offset = read_u32_big_endian(output, index_offset + 4);
+        u32 second_offset = read_u32_big_endian(output, index_offset + 8);
+        u32 third_offset = read_u32_big_endian(output, index_offset + 12);
+
+        if (first_offset != second_offset || first_offset % 2 != 0 || third_offset % 2 != 0 ||
+            output.compare(first_offset, 8, "short.o/") != 0 || output.compare(third_offset, 2, "/0") != 0)
+        {
+            throw std::runtime_error{ "archive test failed: symbol index does not point at members" };
+        }
+
+        if (output.compare(index_offset + 16, 19, std::string{ "first\0second\0third\0", 19 }) != 0)
+            throw std::runtime_error{ "archive test failed: unexpected symbol names" };
+
+        if (output.find("//              ") == std::string::npos ||
+            output.find("a_rather_long_module_name.o/\n") == std::string::npos)
+        {
+            throw std::runtime_error{ "archive test failed: long name is not in the name table" };
+        }
+
+        // Contents come right after each header, and the odd-sized one is padded.
+        if (output.compare(first_offset + 60, 4, "odd\n") != 0 || output.compare(third_offset + 60, 4, "even") != 0 ||
+            output.size() != third_offset + 60 + 4)
+        {
+            throw std::runtime_error{ "archive test failed: unexpected member contents" };
+        }
+    }
+}
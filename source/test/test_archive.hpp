@@ -0,0 +1,15 @@
+#ifndef MASONC_TEST_ARCHIVE_HPP
+#define MASONC_TEST_ARCHIVE_HPP
+
+#include <archive.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::archive
+{
+    // Test if the symbol index points at the members that define the symbols,
+    // if long member names go into the name table, and if members start at even offsets.
+    void test_archive_create();
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include <test_bounded_queue.hpp>
+
+#include <stdexcept>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+namespace masonc::test::bounded_queue
+{
+    void test_producers_consumers()
+    {
+        constexpr u64 PRODUCER_COUNT = 4;
+        constexpr u64 CONSUMER_COUNT = 3;
+        constexpr u64 VALUES_PER_PRODUCER = 10000;
+
+        // Small enough that producers have to wait for consumers.
+        masonc::bounded_queue<u64> queue{ 8 };
+        std::vector<std::atomic<u32>> pops(PRODUCER_COUNT * VALUES_PER_PRODUCER);
+
+        std::vector<std::thread> producers;
+        std::vector<std::thread> consumers;
+
+        for (u64 i = 0; i < CONSUMER_COUNT; i += 1) {
+            consumers.emplace_back([&]() {
+                while (true) {
+                    std::optional<u64> value = queue.pop();
+                    if (!value)
+                        break;
+
+                    pops[value.value()].fetch_add(1);
+                }
+            });
+        }
+
+        for (u64 i = 0; i < PRODUCER_COUNT; i += 1) {
+            producers.emplace_back([&, i]() {
+                for (u64 j = 0; j < VALUES_PER_PRODUCER; j += 1) {
+                    queue.push(i * VALUES_PER_PRODUCER + j);
+                }
+            });
+        }
+
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+
+        queue.close();
+
+        for (std::thread& consumer : consumers) {
+            consumer.join();
+        }
+
+        for (const std::atomic<u32>& pop_count : pops) {
+            if (pop_count.load() != 1)
+                throw std::runtime_error{ "bounded_queue test failed: a value was not popped exactly once" };
+        }
+
+        if (queue.push(0))
+            throw std::runtime_error{ "bounded_queue test failed: push succeeded after close" };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef MASONC_TEST_BOUNDED_QUEUE_HPP
+#define MASONC_TEST_BOUNDED_QUEUE_HPP
+
+#include <bounded_queue.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::bounded_queue
+{
+    // Test if every value pushed by several producers is popped exactly once by several consumers,
+    // and if consumers stop once the queue is closed.
+    void test_producers_consumers();
+}
+
+#endif
\ No newline at end of file
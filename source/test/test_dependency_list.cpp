@@ -4,6 +4,7 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 
 namespace masonc::test::dependency_list
 {
@@ -151,9 +152,7 @@ namespace masonc::test::dependency_list
     {
         // Graph 1
         masonc::dependency_list<int> graph = cyclic_graph();
-        std::optional<u64> root_index = graph.find_index(0);
-
-        graph.find_cycles(root_index.value());
+        graph.find_cycles();
 
         if (!contains_cycle(graph, { 0, 1, 2, 3 })) {
             throw std::runtime_error{ "dependency_list find cycles test failed" };
@@ -161,9 +160,7 @@ namespace masonc::test::dependency_list
 
         // Graph 2
         graph = cyclic_graph_2();
-        root_index = graph.find_index(0);
-
-        graph.find_cycles(root_index.value());
+        graph.find_cycles();
 
         if (!contains_cycle(graph, { 0, 1 })) {
             throw std::runtime_error{ "dependency_list find cycles test failed" };
@@ -171,21 +168,16 @@ namespace masonc::test::dependency_list
 
         // Graph 3
         graph = cyclic_graph_3();
-        root_index = graph.find_index(0);
+        graph.find_cycles();
 
-        graph.find_cycles(root_index.value());
-
-        if (!contains_cycle(graph, { 1, 3, 4 }) ||
-            !contains_cycle(graph, { 2, 3, 4 }))
-        {
+        // Both cycles share vertices, so they are one strongly connected component.
+        if (!contains_cycle(graph, { 1, 2, 3, 4 }) || graph.cycles().size() != 1) {
             throw std::runtime_error{ "dependency_list find cycles test failed" };
         }
 
         // Valid graph
         graph = valid_graph();
-        root_index = graph.find_index(0);
-
-        graph.find_cycles(root_index.value());
+        graph.find_cycles();
 
         if (graph.cycles().size() > 0) {
             throw std::runtime_error{ "dependency_list find cycles test failed" };
@@ -205,4 +197,59 @@ namespace masonc::test::dependency_list
         std::cout << std::flush;
         */
     }
+
+    void test_waves()
+    {
+        masonc::dependency_list<int> graph = valid_graph();
+        std::vector<std::vector<u64>> waves = graph.waves();
+
+        // Dependencies come first, vertices that depend on nothing are in the first wave.
+        std::vector<std::vector<u64>> expected_waves = { { 3, 5 }, { 4 }, { 2 }, { 1, 6 }, { 0 } };
+
+        for (std::vector<u64>& wave : waves) {
+            std::sort(wave.begin(), wave.end());
+        }
+
+        if (waves != expected_waves)
+            throw std::runtime_error{ "dependency_list waves test failed" };
+
+        // Vertices in a cycle and the ones depending on them are left out.
+        graph = cyclic_graph_3();
+        graph.add_vertex(5);
+        graph.add_adjacency(4, 5);
+        waves = graph.waves();
+
+        if (waves.size() != 1 || waves[0] != std::vector<u64>{ 5 })
+            throw std::runtime_error{ "dependency_list waves test failed" };
+    }
+
+    void test_long_chain()
+    {
+        constexpr int VERTEX_COUNT = 100000;
+
+        masonc::dependency_list<int> graph;
+
+        for (int i = 0; i < VERTEX_COUNT; i += 1) {
+            graph.add_vertex(i);
+        }
+
+        for (int i = 0; i + 1 < VERTEX_COUNT; i += 1) {
+            graph.add_adjacency(i, i + 1);
+        }
+
+        graph.find_cycles();
+
+        if (graph.cycles().size() != 0 || graph.waves().size() != VERTEX_COUNT)
+            throw std::runtime_error{ "dependency_list long chain test failed" };
+
+        // Closing the chain makes every vertex part of one cycle.
+        graph.add_adjacency(VERTEX_COUNT - 1, 0);
+        graph.find_cycles();
+
+        if (graph.cycles().size() != 1 || graph.cycles()[0].size() != VERTEX_COUNT ||
+            graph.waves().size() != 0)
+        {
+            throw std::runtime_error{ "dependency_list long chain test failed" };
+        }
+    }
 }
\ No newline at end of file
@@ -20,6 +20,12 @@ namespace masonc::test::dependency_list
     void test_add_vertex_and_iterator();
     void test_find();
     void test_find_cycles();
+
+    // Test if every vertex comes after its dependencies, in the earliest possible wave.
+    void test_waves();
+
+    // Test if a graph too deep for recursion is walked without running out of stack.
+    void test_long_chain();
 }
 
 #endif
\ No newline at end of file
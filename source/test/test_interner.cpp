@@ -0,0 +1,91 @@
+#include <test_interner.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <thread>
+
+namespace masonc::test::interner
+{
+    void test_intern()
+    {
+        masonc::string_interner interner;
+
+        string_id a = interner.intern("identifier");
+        string_id b = interner.intern("another_identifier");
+        string_id c = interner.intern(std::string{ "identifier" });
+        string_id empty = interner.intern("");
+
+        if (a != c || a == b || a == empty || b == empty)
+            throw std::runtime_error{ "interner test failed: unexpected IDs" };
+
+        if (interner.at(a) != "identifier" || interner.at(b) != "another_identifier" ||
+            !interner.at(empty).empty())
+        {
+            throw std::runtime_error{ "interner test failed: unexpected strings" };
+        }
+
+        // Views are null-terminated.
+        if (interner.at(a).data()[interner.at(a).length()] != '\0')
+            throw std::runtime_error{ "interner test failed: string is not null-terminated" };
+
+        if (interner.find("identifier") != a || interner.find("not_interned"))
+            throw std::runtime_error{ "interner test failed: unexpected find result" };
+
+        // Strings longer than a block.
+        std::string long_string(1024 * 128, 'x');
+        string_id long_id = interner.intern(long_string);
+
+        if (interner.at(long_id) != long_string || interner.at(a) != "identifier" || interner.size() != 4)
+            throw std::runtime_error{ "interner test failed: long string" };
+    }
+
+    void test_concurrent_intern()
+    {
+        constexpr u64 THREAD_COUNT = 8;
+        // Enough for several chunks of strings in every shard.
+        constexpr u64 STRING_COUNT = 32768;
+
+        masonc::string_interner interner;
+        std::vector<std::vector<string_id>> ids(THREAD_COUNT);
+        std::vector<u64> mismatches(THREAD_COUNT, 0);
+        std::vector<std::thread> threads;
+
+        for (u64 i = 0; i < THREAD_COUNT; i += 1) {
+            threads.emplace_back([&interner, &ids, &mismatches, i]() {
+                // Every thread interns the same strings, but starting at a different one,
+                // and reads each one back while other threads keep adding strings.
+                ids[i].resize(STRING_COUNT);
+
+                for (u64 j = 0; j < STRING_COUNT; j += 1) {
+                    u64 string_index = (j + i * STRING_COUNT / THREAD_COUNT) % STRING_COUNT;
+                    std::string name = "name_" + std::to_string(string_index);
+
+                    ids[i][string_index] = interner.intern(name);
+
+                    if (interner.at(ids[i][string_index]) != name)
+                        mismatches[i] += 1;
+                }
+            });
+        }
+
+        for (u64 i = 0; i < threads.size(); i += 1) {
+            threads[i].join();
+        }
+
+        if (interner.size() != STRING_COUNT)
+            throw std::runtime_error{ "concurrent interner test failed: unexpected size" };
+
+        for (u64 i = 0; i < THREAD_COUNT; i += 1) {
+            if (mismatches[i] != 0)
+                throw std::runtime_error{ "concurrent interner test failed: string read while interning differs" };
+        }
+
+        for (u64 i = 0; i < THREAD_COUNT; i += 1) {
+            for (u64 j = 0; j < STRING_COUNT; j += 1) {
+                if (ids[i][j] != ids[0][j] || interner.at(ids[i][j]) != "name_" + std::to_string(j))
+                    throw std::runtime_error{ "concurrent interner test failed: IDs do not match" };
+            }
+        }
+    }
+}
\ No newline at end of file
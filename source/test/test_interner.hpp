@@ -0,0 +1,18 @@
+#ifndef MASONC_TEST_INTERNER_HPP
+#define MASONC_TEST_INTERNER_HPP
+
+#include <interner.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::interner
+{
+    // Test if equal strings get equal IDs, different strings different IDs,
+    // and if every ID maps back to its string.
+    void test_intern();
+
+    // Test if threads interning overlapping sets of strings agree on every ID.
+    void test_concurrent_intern();
+}
+
+#endif
\ No newline at end of file
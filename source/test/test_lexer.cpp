@@ -0,0 +1,339 @@
+#include <test_lexer.hpp>
+
+#include <scanner.hpp>
+#include <timer.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace masonc::test::lexer
+{
+    std::string generated_source(u64 min_size)
+    {
+        const char* snippet =
+            "module generated::source;\n"
+            "\n"
+            "import std::core;\n"
+            "\n"
+            "// Line comment that is long enough to span more than a single vector register.\n"
+            "proc compute_something_long(first_argument: s64, mut second_argument: ^f64) -> s64\n"
+            "{\n"
+            "\tvalue: s64 = (16 + 2 * 2) * (5 - (first_argument / 2) + 10) + 1234567890;\n"
+            "\tratio: f64 = 3.14159265358979;\n"
+            "    /* Block comment /* with a nested */ block comment\n"
+            "       spanning\tmultiple lines. */\n"
+            "    message: ^char = \"Escapes \\n and \\t and \\\" and a very long string literal.\";\n"
+            "    another_identifier_with_a_long_name_1 = value;\n"
+            "    \t  call_procedure(value, ratio, message);\n"
+            "}\n"
+            "\n";
+
+        std::string source;
+        source.reserve(min_size + std::strlen(snippet));
+
+        while (source.length() < min_size) {
+            source += snippet;
+        }
+
+        return source;
+    }
+
+    bool outputs_equal(const masonc::lexer::lexer_instance_output& a,
+        const masonc::lexer::lexer_instance_output& b)
+    {
+        if (a.token_count() != b.token_count() ||
+            a.messages.errors.size() != b.messages.errors.size())
+        {
+            return false;
+        }
+
+        for (u64 i = 0; i < a.token_count(); i += 1) {
+            masonc::lexer::token token_a = a.token_at(i);
+            masonc::lexer::token token_b = b.token_at(i);
+
+            // Locations are computed from the offsets.
+            if (token_a.type != token_b.type || a.token_offsets[i] != b.token_offsets[i])
+                return false;
+
+            bool values_equal = true;
+
+            switch (token_a.type) {
+                default:
+                    break;
+                case masonc::lexer::TOKEN_IDENTIFIER:
+                    values_equal = a.identifier_at(token_a.value_index) ==
+                                   b.identifier_at(token_b.value_index);
+                    break;
+                case masonc::lexer::TOKEN_INTEGER:
+                    values_equal = a.integer_at(token_a.value_index) ==
+                                   b.integer_at(token_b.value_index);
+                    break;
+                case masonc::lexer::TOKEN_DECIMAL:
+                    values_equal = a.decimal_at(token_a.value_index) ==
+                                   b.decimal_at(token_b.value_index);
+                    break;
+                case masonc::lexer::TOKEN_STRING:
+                    values_equal = a.string_at(token_a.value_index) ==
+                                   b.string_at(token_b.value_index);
+                    break;
+            }
+
+            if (!values_equal)
+                return false;
+        }
+
+        for (u64 i = 0; i < a.messages.errors.size(); i += 1) {
+            if (a.messages.errors[i].msg != b.messages.errors[i].msg ||
+                a.messages.errors[i].location.line_number != b.messages.errors[i].location.line_number ||
+                a.messages.errors[i].location.start_column != b.messages.errors[i].location.start_column ||
+                a.messages.errors[i].location.end_column != b.messages.errors[i].location.end_column)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void test_scanner_equivalence()
+    {
+        std::string source = generated_source(1024 * 16);
+
+        // Inputs ending in the middle of a token, so that the scalar tail of every scanner is hit.
+        const char* edge_cases[] =
+        {
+            "",
+            "identifier",
+            "1234.5678",
+            "1.",
+            "1.2.3",
+            "\"unterminated string",
+            "\"invalid \\q escape\" after",
+            "// comment without newline",
+            "/* unterminated /* nested */ block",
+            "x\t\t\n\n   \t y",
+            "a::b->c"
+        };
+
+        masonc::lexer::lexer_instance lexer;
+        const masonc::lexer::scanner& scalar = masonc::lexer::scalar_scanner();
+
+        for (masonc::lexer::scanner_isa isa : { masonc::lexer::scanner_isa::SSE2,
+                                                masonc::lexer::scanner_isa::AVX2 })
+        {
+            const masonc::lexer::scanner* vector_scanner = masonc::lexer::scanner_for(isa);
+            if (vector_scanner == nullptr)
+                continue;
+
+            // Shift the input by one character each time so that runs end at every chunk offset.
+            for (u64 offset = 0; offset < 32; offset += 1) {
+                masonc::lexer::lexer_instance_output expected;
+                masonc::lexer::lexer_instance_output result;
+
+                lexer.set_scanner(scalar);
+                lexer.tokenize(source.c_str() + offset, source.length() - offset, &expected);
+
+                lexer.set_scanner(*vector_scanner);
+                lexer.tokenize(source.c_str() + offset, source.length() - offset, &result);
+
+                if (!outputs_equal(expected, result))
+                    throw std::runtime_error{ "lexer scanner equivalence test failed" };
+            }
+
+            for (const char* edge_case : edge_cases) {
+                masonc::lexer::lexer_instance_output expected;
+                masonc::lexer::lexer_instance_output result;
+
+                lexer.set_scanner(scalar);
+                lexer.tokenize(edge_case, std::strlen(edge_case), &expected);
+
+                lexer.set_scanner(*vector_scanner);
+                lexer.tokenize(edge_case, std::strlen(edge_case), &result);
+
+                if (!outputs_equal(expected, result))
+                    throw std::runtime_error{ "lexer scanner equivalence test failed" };
+            }
+        }
+    }
+
+    void test_token_locations()
+    {
+        const char* source =
+            "module test;\n"
+            "\tvalue: s64 = 42;\n"
+            "text: ^char = \"a\\tb\" -> x::y\n";
+
+        // Line, start column and end column of every token with a tab size of 4.
+        const u64 expected[][3] = {
+            { 1, 1, 6 }, { 1, 8, 11 }, { 1, 12, 12 },
+            { 2, 5, 9 }, { 2, 10, 10 }, { 2, 12, 14 }, { 2, 16, 16 }, { 2, 18, 19 }, { 2, 20, 20 },
+            { 3, 1, 4 }, { 3, 5, 5 }, { 3, 7, 7 }, { 3, 8, 11 }, { 3, 13, 13 }, { 3, 15, 20 },
+            { 3, 22, 23 }, { 3, 25, 25 }, { 3, 26, 27 }, { 3, 28, 28 }
+        };
+
+        masonc::lexer::lexer_instance lexer;
+        masonc::lexer::lexer_instance_output output;
+        lexer.tokenize(source, std::strlen(source), &output, 4);
+
+        if (output.token_count() != sizeof(expected) / sizeof(expected[0]))
+            throw std::runtime_error{ "lexer token location test failed: unexpected token count" };
+
+        for (u64 i = 0; i < output.token_count(); i += 1) {
+            masonc::lexer::token_location location = output.location_at(i);
+
+            if (location.line_number != expected[i][0] ||
+                location.start_column != expected[i][1] ||
+                location.end_column != expected[i][2])
+            {
+                throw std::runtime_error{ "lexer token location test failed at token " + std::to_string(i) };
+            }
+        }
+    }
+
+    void test_parallel_lexing()
+    {
+        // Newlines inside strings and comments, which must not be split at.
+        const char* tricky_snippet =
+            "text: ^char = \"string spanning\nlines \\q with\" an invalid escape\";\n"
+            "/* block /* nested\n */ comment with \" and // inside\n */\n"
+            "// line comment with \" and /* inside\n"
+            "ratio = 1.5 / 2 - value->field::x;\n";
+
+        std::string source = generated_source(1024 * 16);
+
+        for (u64 i = 0; i < 64; i += 1) {
+            source += tricky_snippet;
+        }
+
+        // Lexing stops at the second "." in the middle, so later chunks have to be dropped.
+        std::string stopped_source = source + "x = 1.2.3;\n" + source;
+
+        masonc::lexer::lexer_instance lexer;
+
+        for (const std::string* input : { &source, &stopped_source }) {
+            masonc::lexer::lexer_instance_output expected;
+
+            lexer.set_parallel_lexing(std::numeric_limits<u64>::max());
+            lexer.tokenize(input->c_str(), input->length(), &expected);
+
+            for (u64 chunk_count : { 2, 3, 7, 64 }) {
+                masonc::lexer::lexer_instance_output result;
+
+                lexer.set_parallel_lexing(0, chunk_count);
+                lexer.tokenize(input->c_str(), input->length(), &result);
+
+                if (!outputs_equal(expected, result))
+                    throw std::runtime_error{ "lexer parallel lexing test failed" };
+            }
+        }
+    }
+
+    void test_retokenize()
+    {
+        std::string source = generated_source(1024 * 16);
+
+        masonc::lexer::lexer_instance lexer;
+        masonc::lexer::lexer_instance_output output;
+        lexer.tokenize(source.c_str(), source.length(), &output);
+
+        // Replaces "removed_length" characters at "offset" with "inserted",
+        // retokenizes and compares the result with tokenizing from scratch.
+        auto edit = [&](u64 offset, u64 removed_length, const std::string& inserted) {
+            source.replace(offset, removed_length, inserted);
+
+            masonc::lexer::token_edit replaced = lexer.retokenize(source.c_str(), source.length(), &output,
+                masonc::lexer::input_edit{ offset, removed_length, inserted.length() });
+
+            masonc::lexer::lexer_instance_output expected;
+            lexer.tokenize(source.c_str(), source.length(), &expected);
+
+            if (!outputs_equal(expected, output))
+                throw std::runtime_error{ "lexer retokenize test failed at offset " + std::to_string(offset) };
+
+            return replaced;
+        };
+
+        // Edits somewhere in the middle of the input.
+        auto middle = [&](const char* text) {
+            return source.find(text, source.length() / 2);
+        };
+
+        masonc::lexer::token_edit replaced = edit(middle("1234567890"), 10, "42");
+        if (replaced.removed_count > 2 || replaced.inserted_count > 2)
+            throw std::runtime_error{ "lexer retokenize test failed: too many tokens replaced" };
+
+        // Continue an identifier, join two and split a composed token.
+        edit(middle("value:") + 5, 0, "x");
+        edit(middle("mut second") + 3, 1, "");
+        edit(middle("std::core") + 4, 1, "");
+
+        // Open a block comment and a string that swallow the following tokens, then close them again.
+        edit(middle("proc"), 0, "/* ");
+        edit(middle("/* proc"), 3, "");
+        edit(middle("ratio: f64"), 0, "\"");
+        edit(middle("\"ratio"), 1, "");
+
+        // Lexing continues after an invalid escape sequence, but stops at a second ".".
+        // After an error, the next edit tokenizes everything again.
+        edit(middle("Escapes"), 0, "\\q ");
+        edit(middle("3.14159") + 4, 0, ".5");
+        edit(middle("3.14.5") + 4, 2, "");
+
+        edit(0, 0, "// Leading comment.\n");
+        edit(source.length(), 0, "trailing_identifier");
+        edit(0, source.length(), "");
+    }
+
+    void benchmark_lexer_throughput(u64 source_size, u64 iterations)
+    {
+        std::string source = generated_source(source_size);
+        f64 megabytes = static_cast<f64>(source.length()) / (1024.0 * 1024.0);
+
+        masonc::lexer::lexer_instance lexer;
+
+        // Fastest iteration wins to filter out noise.
+        auto best_seconds = [&]() {
+            f64 result = 0.0;
+
+            for (u64 i = 0; i < iterations; i += 1) {
+                masonc::lexer::lexer_instance_output output;
+
+                auto start = std::chrono::high_resolution_clock::now();
+                lexer.tokenize(source.c_str(), source.length(), &output);
+                auto end = std::chrono::high_resolution_clock::now();
+
+                f64 seconds = std::chrono::duration<f64>(end - start).count();
+                if (i == 0 || seconds < result)
+                    result = seconds;
+            }
+
+            return result;
+        };
+
+        // Compare scanners on a single thread.
+        lexer.set_parallel_lexing(std::numeric_limits<u64>::max());
+
+        for (masonc::lexer::scanner_isa isa : { masonc::lexer::scanner_isa::SCALAR,
+                                                masonc::lexer::scanner_isa::SSE2,
+                                                masonc::lexer::scanner_isa::AVX2 })
+        {
+            const masonc::lexer::scanner* current_scanner = masonc::lexer::scanner_for(isa);
+            if (current_scanner == nullptr)
+                continue;
+
+            lexer.set_scanner(*current_scanner);
+
+            std::cout << "lexer throughput (" << masonc::lexer::scanner_isa_name(isa) << "): "
+                      << megabytes / best_seconds() << " MB/s" << std::endl;
+        }
+
+        lexer.set_scanner(masonc::lexer::active_scanner());
+        lexer.set_parallel_lexing(0);
+
+        std::cout << "lexer throughput (parallel, " << std::thread::hardware_concurrency() << " threads): "
+                  << megabytes / best_seconds() << " MB/s" << std::endl;
+    }
+}
\ No newline at end of file
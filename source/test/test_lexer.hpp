@@ -0,0 +1,38 @@
+#ifndef MASONC_TEST_LEXER_HPP
+#define MASONC_TEST_LEXER_HPP
+
+#include <lexer.hpp>
+
+#include <common.hpp>
+
+#include <string>
+
+namespace masonc::test::lexer
+{
+    // Returns mason source code of at least "min_size" characters that contains
+    // every kind of token, comments, escape sequences and mixed whitespace.
+    std::string generated_source(u64 min_size);
+
+    // Returns true if both outputs contain the same tokens, locations, values and errors.
+    bool outputs_equal(const masonc::lexer::lexer_instance_output& a,
+        const masonc::lexer::lexer_instance_output& b);
+
+    // Test if every scanner supported by the CPU produces the same output as the scalar scanner.
+    void test_scanner_equivalence();
+
+    // Test if lines and columns computed from token offsets account for tabs and newlines.
+    void test_token_locations();
+
+    // Test if tokenizing an input in parallel chunks gives the same output as in one go.
+    void test_parallel_lexing();
+
+    // Test if retokenizing an edited input gives the same output as tokenizing it from scratch,
+    // and if a small edit only replaces the tokens around it.
+    void test_retokenize();
+
+    // Print lexer throughput in MB/s for every scanner supported by the CPU
+    // and for parallel lexing with the active scanner.
+    void benchmark_lexer_throughput(u64 source_size = 1024 * 1024 * 16, u64 iterations = 8);
+}
+
+#endif
\ No newline at end of file
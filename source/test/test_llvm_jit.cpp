@@ -0,0 +1,106 @@
+#include <test_llvm_jit.hpp>
+
+#include <llvm-c/Core.h>
+
+#include <string>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace masonc::test::llvm_jit
+{
+    // Adds a procedure "name" to "module" that returns "value" as an integer of "bits" bits,
+    // with the return attribute "attribute" unless it is empty.
+    static void add_constant_procedure(LLVMModuleRef module, const char* name, u32 bits, u64 value,
+        std::string_view attribute = "")
+    {
+        LLVMContextRef context = LLVMGetModuleContext(module);
+        LLVMTypeRef integer_type = LLVMIntTypeInContext(context, bits);
+
+        LLVMValueRef function = LLVMAddFunction(module, name, LLVMFunctionType(integer_type, nullptr, 0, false));
+
+        if (!attribute.empty()) {
+            LLVMAttributeRef llvm_attribute = LLVMCreateEnumAttribute(context,
+                LLVMGetEnumAttributeKindForName(attribute.data(), attribute.length()), 0);
+
+            LLVMAddAttributeAtIndex(function, LLVMAttributeReturnIndex, llvm_attribute);
+        }
+
+        LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+        LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, function, "entry"));
+        LLVMBuildRet(builder, LLVMConstInt(integer_type, value, false));
+        LLVMDisposeBuilder(builder);
+    }
+
+    static void expect_result(masonc::llvm::llvm_jit* jit, const std::string& procedure_name, s64 expected)
+    {
+        std::optional<s64> result = jit->run(procedure_name);
+
+        if (!result)
+            throw std::runtime_error{ "llvm jit test failed: could not run \"" + procedure_name + "\": " + jit->error() };
+
+        if (result.value() != expected) {
+            throw std::runtime_error{ "llvm jit test failed: \"" + procedure_name + "\" returned " +
+                std::to_string(result.value()) + " instead of " + std::to_string(expected) };
+        }
+    }
+
+    void test_run()
+    {
+        LLVMContextRef context = LLVMContextCreate();
+
+        {
+            masonc::llvm::llvm_jit jit;
+
+            if (!jit.is_valid())
+                throw std::runtime_error{ "llvm jit test failed: " + jit.error() };
+
+            LLVMModuleRef module = LLVMModuleCreateWithNameInContext("test_llvm_jit", context);
+
+            add_constant_procedure(module, "signed_byte", 8, 0xff, "signext");
+            add_constant_procedure(module, "unsigned_byte", 8, 0xff, "zeroext");
+            add_constant_procedure(module, "unmarked_short", 16, 0x8000);
+            add_constant_procedure(module, "unsigned_int", 32, 0xffffffff, "zeroext");
+            add_constant_procedure(module, "odd_width", 33, 0x100000000, "signext");
+            add_constant_procedure(module, "flag", 1, 1, "zeroext");
+            add_constant_procedure(module, "wide", 64, 0x123456789abcdef0);
+
+            LLVMTypeRef void_type = LLVMVoidTypeInContext(context);
+            LLVMValueRef nothing = LLVMAddFunction(module, "nothing", LLVMFunctionType(void_type, nullptr, 0, false));
+
+            LLVMTypeRef argument_type = LLVMInt32TypeInContext(context);
+            LLVMValueRef identity = LLVMAddFunction(module, "identity",
+                LLVMFunctionType(argument_type, &argument_type, 1, false));
+
+            LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+
+            LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, nothing, "entry"));
+            LLVMBuildRetVoid(builder);
+
+            LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, identity, "entry"));
+            LLVMBuildRet(builder, LLVMGetParam(identity, 0));
+
+            LLVMDisposeBuilder(builder);
+
+            if (!jit.add_module(module))
+                throw std::runtime_error{ "llvm jit test failed: could not add module: " + jit.error() };
+
+            expect_result(&jit, "signed_byte", -1);
+            expect_result(&jit, "unsigned_byte", 0xff);
+            expect_result(&jit, "unmarked_short", -0x8000);
+            expect_result(&jit, "unsigned_int", 0xffffffff);
+            expect_result(&jit, "odd_width", -0x100000000);
+            expect_result(&jit, "flag", 1);
+            expect_result(&jit, "wide", 0x123456789abcdef0);
+            expect_result(&jit, "nothing", 0);
+
+            if (jit.run("identity"))
+                throw std::runtime_error{ "llvm jit test failed: ran a procedure that takes an argument" };
+
+            if (jit.run("missing"))
+                throw std::runtime_error{ "llvm jit test failed: ran a procedure that does not exist" };
+        }
+
+        LLVMContextDispose(context);
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef MASONC_TEST_LLVM_JIT_HPP
+#define MASONC_TEST_LLVM_JIT_HPP
+
+#include <llvm_jit.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::llvm_jit
+{
+    // Test if procedures of a hand-built module are run and their integers are extended
+    // by the "zeroext" and "signext" attributes of their return values, sign-extended without one,
+    // and if procedures that take arguments or do not exist are refused.
+    void test_run();
+}
+
+#endif
@@ -0,0 +1,19 @@
+// Entry point of the test executable, which runs every test once and exits.
+//
+// The compiler does not run tests, so that it starts as fast as possible. Only this executable
+// is built with "MASONC_COUNT_ALLOCATIONS", see "masonc::test::allocation_counter".
+
+#include <test.hpp>
+#include <language.hpp>
+#include <llvm_emitter.hpp>
+
+int main()
+{
+    masonc::initialize_language();
+    masonc::llvm::initialize_llvm_emitter();
+
+    // A failing test throws, which ends the program with an error.
+    masonc::test::perform_all_tests();
+
+    return 0;
+}
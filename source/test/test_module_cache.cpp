@@ -0,0 +1,146 @@
+#include <test_module_cache.hpp>
+#include <temporary_directory.hpp>
+
+#include <lexer.hpp>
+#include <parser.hpp>
+
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+
+namespace masonc::test::module_cache
+{
+    static const std::string CACHED_SOURCE =
+        "module test::cache;\n\n"
+        "import std::io;\n\n"
+        "proc print(text: ^char);\n\n"
+        "proc compute() -> f64\n{\n"
+        "    ratio: f64 = 3.25;\n"
+        "    print(\"tab\\tseparated\");\n"
+        "    print(\"plain\");\n"
+        "    return ratio * 2;\n"
+        "}\n";
+
+    static void parse(const std::string& source, masonc::parser::parser_instance_output* output)
+    {
+        masonc::lexer::lexer_instance lexer;
+        lexer.tokenize(source.c_str(), source.length(), &output->lexer_output);
+
+        masonc::parser::parser_instance parser{ output };
+
+        if (output->lexer_output.messages.errors.size() > 0 || output->messages.errors.size() > 0)
+            throw std::runtime_error{ "module cache test failed: source did not parse" };
+    }
+
+    static bool outputs_equal(masonc::parser::parser_instance_output& a,
+        masonc::parser::parser_instance_output& b)
+    {
+        const masonc::lexer::lexer_instance_output& lexed_a = a.lexer_output;
+        const masonc::lexer::lexer_instance_output& lexed_b = b.lexer_output;
+
+        if (lexed_a.token_types != lexed_b.token_types || lexed_a.token_values != lexed_b.token_values ||
+            lexed_a.token_offsets != lexed_b.token_offsets || lexed_a.strings.size() != lexed_b.strings.size())
+        {
+            return false;
+        }
+
+        for (u64 i = 0; i < lexed_a.strings.size(); i += 1) {
+            if (lexed_a.string_at(i) != lexed_b.string_at(i))
+                return false;
+        }
+
+        if (a.module_name != b.module_name || a.AST != b.AST || a.expression_lists != b.expression_lists ||
+            a.module_symbols != b.module_symbols || a.expressions.size() != b.expressions.size() ||
+            a.file_module.module_import_names.size() != b.file_module.module_import_names.size() ||
+            a.file_module.module_imports != b.file_module.module_imports)
+        {
+            return false;
+        }
+
+        for (u64 i = 0; i < a.AST.size(); i += 1) {
+            if (a.AST_spans[i].content_hash != b.AST_spans[i].content_hash ||
+                a.format_expression(a.expression_at(a.AST[i])) != b.format_expression(b.expression_at(b.AST[i])))
+            {
+                return false;
+            }
+        }
+
+        // Adding a symbol fails if the module scope has it already.
+        for (symbol name : a.module_symbols) {
+            if (b.file_module.module_scope().add_symbol(name))
+                return false;
+        }
+
+        return true;
+    }
+
+    void test_store_and_load()
+    {
+        masonc::test::temporary_directory directory{ "masonc_test_store_and_load" };
+        masonc::cache::module_cache cache{ directory.path() };
+
+        masonc::parser::parser_instance_output parsed;
+        parse(CACHED_SOURCE, &parsed);
+
+        masonc::parser::parser_instance_output loaded;
+        if (cache.load(CACHED_SOURCE.c_str(), CACHED_SOURCE.length(), &loaded))
+            throw std::runtime_error{ "module cache test failed: found an entry in an empty cache" };
+
+        if (!cache.store(parsed))
+            throw std::runtime_error{ "module cache test failed: could not store entry" };
+
+        if (!cache.load(CACHED_SOURCE.c_str(), CACHED_SOURCE.length(), &loaded))
+            throw std::runtime_error{ "module cache test failed: could not load stored entry" };
+
+        if (!outputs_equal(parsed, loaded))
+            throw std::runtime_error{ "module cache test failed: loaded output differs from parsed output" };
+
+        // A single changed character is a different file.
+        std::string changed = CACHED_SOURCE;
+        changed[changed.find("3.25")] = '4';
+
+        masonc::parser::parser_instance_output missed;
+        if (cache.load(changed.c_str(), changed.length(), &missed))
+            throw std::runtime_error{ "module cache test failed: found an entry for changed contents" };
+    }
+
+    void test_damaged_entries()
+    {
+        masonc::test::temporary_directory directory{ "masonc_test_damaged_entries" };
+        masonc::cache::module_cache cache{ directory.path() };
+
+        masonc::parser::parser_instance_output parsed;
+        parse(CACHED_SOURCE, &parsed);
+        cache.store(parsed);
+
+        std::filesystem::path entry_path = std::filesystem::directory_iterator{ directory.path() }->path();
+        u64 entry_size = std::filesystem::file_size(entry_path);
+
+        // Overwrites the byte at "offset" and tries to load the entry.
+        auto load_damaged = [&](u64 offset) {
+            std::fstream entry{ entry_path, std::ios::in | std::ios::out | std::ios::binary };
+            entry.seekp(static_cast<std::streamoff>(offset));
+            entry.put('\x5a');
+            entry.close();
+
+            masonc::parser::parser_instance_output loaded;
+            bool found = cache.load(CACHED_SOURCE.c_str(), CACHED_SOURCE.length(), &loaded);
+
+            if (found || loaded.lexer_output.token_count() != 0 || !loaded.expressions.empty())
+                throw std::runtime_error{ "module cache test failed: loaded damaged entry" };
+
+            cache.store(parsed);
+        };
+
+        load_damaged(0);
+        load_damaged(entry_size / 2);
+        load_damaged(entry_size - 1);
+
+        std::filesystem::resize_file(entry_path, entry_size / 3);
+
+        masonc::parser::parser_instance_output truncated;
+        if (cache.load(CACHED_SOURCE.c_str(), CACHED_SOURCE.length(), &truncated))
+            throw std::runtime_error{ "module cache test failed: loaded truncated entry" };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef MASONC_TEST_MODULE_CACHE_HPP
+#define MASONC_TEST_MODULE_CACHE_HPP
+
+#include <module_cache.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::module_cache
+{
+    // Test if loading a stored entry gives the same lexer and parser output as parsing the file,
+    // and if an entry is only found for the exact file contents it was stored for.
+    void test_store_and_load();
+
+    // Test if truncated and damaged entries are rejected and leave the output empty.
+    void test_damaged_entries();
+}
+
+#endif
\ No newline at end of file
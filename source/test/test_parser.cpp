@@ -1,10 +1,15 @@
 #include <test_parser.hpp>
+#include <allocation_counter.hpp>
 
 #include <lexer.hpp>
 #include <parser.hpp>
 #include <logger.hpp>
 #include <io.hpp>
 
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+
 namespace masonc::test::parser
 {
     test_parse_in_directory_output test_parse_in_directory(const char* directory_path, bool expected)
@@ -37,24 +42,325 @@ namespace masonc::test::parser
 
     std::optional<masonc::message_list> test_parse(const char* filename)
     {
-        masonc::u64 file_length;
-        std::optional<char*> file;
-
-        file = file_read(filename, 1024, &file_length);
+        std::optional<masonc::mapped_file> file = file_map(filename);
         if (!file)
             return std::optional<masonc::message_list>{};
 
         masonc::lexer::lexer_instance lexer;
         masonc::parser::parser_instance_output parser_output;
 
-        lexer.tokenize(file.value(), file_length, &parser_output.lexer_output);
+        lexer.tokenize(file.value().data(), file.value().size(), &parser_output.lexer_output);
         if (parser_output.lexer_output.messages.errors.size() > 0)
             return std::optional<masonc::message_list>{};
 
         masonc::parser::parser_instance parser{ &parser_output };
 
-        std::free(file.value());
-
         return std::optional<masonc::message_list>{ parser_output.messages };
     }
+
+    std::string generated_expression_source(u64 min_size)
+    {
+        std::string source = "module generated::expressions;\n\nproc stuff(x: s64);\n\n";
+        source.reserve(min_size + 1024);
+
+        for (u64 i = 0; source.length() < min_size; i += 1) {
+            std::string index = std::to_string(i);
+
+            source += "proc compute_" + index + "()\n{\n"
+                      "    num: s64 = " + index + ";\n"
+                      "    p: ^s64 = &num;\n"
+                      "    stuff((16 + 2 * 2) * (5 - (num / 2) + 10) + ^p);\n"
+                      "    stuff(((1 + 2) * (3 + 4) - (5 * 6 + 7)) / (8 - 9 * (10 + ^p)));\n"
+                      "}\n\n";
+        }
+
+        return source;
+    }
+
+    // Returns the expression as fully parenthesized infix notation, for example "(1 + (2 * 3))".
+    static std::string infix_string(masonc::parser::parser_instance_output& parser_output,
+        masonc::parser::expression_handle handle)
+    {
+        masonc::parser::expression& expr = parser_output.expression_at(handle);
+
+        masonc::parser::expression_binary* binary = masonc::parser::get_binary_expression(&expr);
+        if (binary == nullptr)
+            return std::string{ parser_output.number_value(expr.number) };
+
+        return "(" + infix_string(parser_output, binary->left) + " " +
+               static_cast<char>(binary->op_code) + " " +
+               infix_string(parser_output, binary->right) + ")";
+    }
+
+    void test_operator_precedence()
+    {
+        std::string source = "module test::precedence;\n\n"
+                             "proc compute()\n{\n"
+                             "    x: s64 = 1 + 2 * 3 - 4 / (5 - 6) - 7;\n"
+                             "    y: s64 = 8 / 4 / 2 * (1 + 1 * 3);\n"
+                             "}\n";
+
+        const char* expected[] = {
+            "(((1 + (2 * 3)) - (4 / (5 - 6))) - 7)",
+            "(((8 / 4) / 2) * (1 + (1 * 3)))"
+        };
+
+        masonc::lexer::lexer_instance lexer;
+        masonc::parser::parser_instance_output parser_output;
+        lexer.tokenize(source.c_str(), source.length(), &parser_output.lexer_output);
+
+        masonc::parser::parser_instance parser{ &parser_output };
+
+        if (parser_output.messages.errors.size() > 0 || parser_output.AST.size() != 2)
+            throw std::runtime_error{ "operator precedence test failed: source did not parse" };
+
+        masonc::parser::expression_range body =
+            parser_output.expression_at(parser_output.AST[1]).procedure_definition.body;
+
+        if (body.count != 2)
+            throw std::runtime_error{ "operator precedence test failed: unexpected statement count" };
+
+        for (u32 i = 0; i < body.count; i += 1) {
+            // The statement is the assignment to the declared variable.
+            masonc::parser::expression& statement =
+                parser_output.expression_at(parser_output.list_at(body, i));
+
+            if (statement.type != masonc::parser::EXPR_BINARY ||
+                infix_string(parser_output, statement.binary.right) != expected[i])
+            {
+                throw std::runtime_error{ "operator precedence test failed: unexpected tree shape" };
+            }
+        }
+    }
+
+    // Returns mason source code of "procedure_count" procedures with "statement_count" calls each.
+    static std::string procedure_source(u64 procedure_count, u64 statement_count)
+    {
+        std::string source = "module generated::procedures;\n\nproc stuff(x: s64);\n\n";
+
+        for (u64 i = 0; i < procedure_count; i += 1) {
+            source += "proc compute_" + std::to_string(i) + "()\n{\n";
+
+            for (u64 j = 0; j < statement_count; j += 1) {
+                source += "    stuff((16 + 2 * 2) * (5 - (" + std::to_string(j) + " / 2) + 10));\n";
+            }
+
+            source += "}\n\n";
+        }
+
+        return source;
+    }
+
+#ifdef MASONC_COUNT_ALLOCATIONS
+    // Returns the number of allocations made while parsing "source".
+    static u64 parse_allocation_count(const std::string& source)
+    {
+        masonc::lexer::lexer_instance lexer;
+        masonc::parser::parser_instance_output parser_output;
+        lexer.tokenize(source.c_str(), source.length(), &parser_output.lexer_output);
+
+        masonc::test::allocation_counter allocations;
+        masonc::parser::parser_instance parser{ &parser_output };
+        u64 count = allocations.count();
+
+        if (parser_output.messages.errors.size() > 0)
+            throw std::runtime_error{ "parse allocation test failed: generated source has errors" };
+
+        return count;
+    }
+
+    void test_parse_allocations()
+    {
+        constexpr u64 PROCEDURE_COUNT = 64;
+
+        u64 short_bodies = parse_allocation_count(procedure_source(PROCEDURE_COUNT, 2));
+        u64 long_bodies = parse_allocation_count(procedure_source(PROCEDURE_COUNT, 64));
+
+        // Each procedure owns a scope and a symbol. Anything else would be per expression.
+        if (short_bodies > PROCEDURE_COUNT * 4)
+            throw std::runtime_error{ "parse allocation test failed: too many allocations per procedure" };
+
+        // The node arrays are reserved up front, so 32 times the expressions
+        // should cost at most a few growth steps.
+        if (long_bodies > short_bodies + 8)
+            throw std::runtime_error{ "parse allocation test failed: allocations grow with expression count" };
+    }
+#endif
+
+    // Throws if "incremental" differs from a full parse of the same source in "expected".
+    static void compare_reparse(masonc::parser::parser_instance_output& expected,
+        masonc::parser::parser_instance_output& incremental)
+    {
+        if (incremental.messages.errors.size() != expected.messages.errors.size() ||
+            incremental.AST.size() != expected.AST.size() ||
+            incremental.AST_spans.size() != expected.AST_spans.size())
+        {
+            throw std::runtime_error{ "incremental reparse test failed: different top-level expressions" };
+        }
+
+        for (u64 i = 0; i < expected.AST.size(); i += 1) {
+            const masonc::parser::top_level_span& expected_span = expected.AST_spans[i];
+            const masonc::parser::top_level_span& span = incremental.AST_spans[i];
+
+            if (span.first_token != expected_span.first_token || span.token_count != expected_span.token_count ||
+                span.content_hash != expected_span.content_hash || span.symbol_count != expected_span.symbol_count)
+            {
+                throw std::runtime_error{ "incremental reparse test failed: different span at " + std::to_string(i) };
+            }
+
+            for (u32 j = 0; j < span.symbol_count; j += 1) {
+                if (incremental.module_symbols[span.first_symbol + j] !=
+                    expected.module_symbols[expected_span.first_symbol + j])
+                {
+                    throw std::runtime_error{ "incremental reparse test failed: different module symbols" };
+                }
+            }
+
+            if (incremental.format_expression(incremental.expression_at(incremental.AST[i])) !=
+                expected.format_expression(expected.expression_at(expected.AST[i])))
+            {
+                throw std::runtime_error{ "incremental reparse test failed: different expression at " + std::to_string(i) };
+            }
+        }
+    }
+
+    void test_incremental_reparse()
+    {
+        std::string source = procedure_source(32, 4);
+
+        masonc::lexer::lexer_instance lexer;
+        masonc::parser::parser_instance_output incremental;
+        lexer.tokenize(source.c_str(), source.length(), &incremental.lexer_output);
+        masonc::parser::parser_instance{ &incremental };
+
+        // Replaces "removed_length" characters at "offset" with "inserted",
+        // reparses and compares the result with parsing from scratch.
+        auto edit = [&](u64 offset, u64 removed_length, const std::string& inserted) {
+            source.replace(offset, removed_length, inserted);
+
+            masonc::lexer::token_edit tokens = lexer.retokenize(source.c_str(), source.length(),
+                &incremental.lexer_output, masonc::lexer::input_edit{ offset, removed_length, inserted.length() });
+            masonc::parser::parser_instance parser{ &incremental, tokens };
+
+            masonc::parser::parser_instance_output expected;
+            lexer.tokenize(source.c_str(), source.length(), &expected.lexer_output);
+            masonc::parser::parser_instance{ &expected };
+
+            compare_reparse(expected, incremental);
+            return parser.replaced();
+        };
+
+        auto middle = [&](const char* text) {
+            return source.find(text, source.length() / 2);
+        };
+
+        // Edits inside a procedure body replace that procedure only.
+        masonc::parser::top_level_edit replaced = edit(middle("(16 + 2") + 1, 2, "1234");
+        if (replaced.first == 0 || replaced.removed_count != 1 || replaced.inserted_count != 1)
+            throw std::runtime_error{ "incremental reparse test failed: too many expressions replaced" };
+
+        edit(middle("    stuff"), 0, "    local: s64 = 7;\n");
+        edit(middle("proc compute"), 0, "// Only a comment.\n\n");
+
+        // Insert and delete whole procedures.
+        edit(middle("proc compute"), 0, "proc inserted() { stuff(1); }\n\n");
+        u64 inserted = middle("proc inserted");
+        edit(inserted, source.find("proc", inserted + 1) - inserted, "");
+
+        // Join two procedures into one and split them again.
+        u64 closing = middle("}\n\nproc compute");
+        edit(closing, 7, "");
+        edit(closing, 0, "}\n\nproc");
+
+        // After an error, the next edit parses everything again.
+        edit(middle("stuff("), 6, "stuff(;");
+        edit(middle("stuff(;"), 7, "stuff(");
+
+        // Procedure names are module symbols, a name that is taken again is an error.
+        u64 name = middle("compute_");
+        edit(name, source.find('(', name) - name, "compute_0");
+        edit(name, 9, "compute_x");
+
+        edit(source.length(), 0, "proc appended();\n");
+
+        u64 first_procedure = source.find("proc");
+        edit(first_procedure, source.length() - first_procedure, "");
+    }
+
+    void benchmark_parser(u64 source_size, u64 iterations)
+    {
+        std::string source = generated_expression_source(source_size);
+
+        masonc::lexer::lexer_instance lexer;
+        masonc::lexer::lexer_instance_output lexer_output;
+        lexer.tokenize(source.c_str(), source.length(), &lexer_output);
+
+        u64 expression_count = 0;
+        u64 ast_bytes = 0;
+
+        // Fastest iteration wins to filter out noise.
+        f64 best_parse_seconds = 0.0;
+
+        for (u64 i = 0; i < iterations; i += 1) {
+            masonc::parser::parser_instance_output parser_output;
+            parser_output.lexer_output = lexer_output;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            masonc::parser::parser_instance parser{ &parser_output };
+            auto end = std::chrono::high_resolution_clock::now();
+
+            f64 seconds = std::chrono::duration<f64>(end - start).count();
+            if (i == 0 || seconds < best_parse_seconds)
+                best_parse_seconds = seconds;
+
+            expression_count = parser_output.expressions.size();
+            ast_bytes = parser_output.expressions.size() * sizeof(masonc::parser::expression) +
+                        (parser_output.expression_lists.size() + parser_output.AST.size()) *
+                        sizeof(masonc::parser::expression_handle);
+        }
+
+        std::cout << "parser: " << expression_count << " expressions in "
+                  << static_cast<f64>(ast_bytes) / (1024.0 * 1024.0) << " MB, parsed in "
+                  << best_parse_seconds * 1000.0 << " ms" << std::endl;
+    }
+
+    void benchmark_incremental_reparse(u64 procedure_count, u64 iterations)
+    {
+        std::string source = procedure_source(procedure_count, 8);
+
+        masonc::lexer::lexer_instance lexer;
+        masonc::parser::parser_instance_output parser_output;
+        lexer.tokenize(source.c_str(), source.length(), &parser_output.lexer_output);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        masonc::parser::parser_instance{ &parser_output };
+        auto end = std::chrono::high_resolution_clock::now();
+
+        f64 full_seconds = std::chrono::duration<f64>(end - start).count();
+
+        // Fastest iteration wins to filter out noise.
+        f64 best_reparse_seconds = 0.0;
+
+        for (u64 i = 0; i < iterations; i += 1) {
+            // Turns a literal into another one of the same length, somewhere in the middle.
+            u64 offset = source.find("(16 + 2", source.length() / 2) + 1;
+            std::string inserted = (i % 2 == 0) ? "61" : "16";
+            source.replace(offset, 2, inserted);
+
+            start = std::chrono::high_resolution_clock::now();
+
+            masonc::lexer::token_edit tokens = lexer.retokenize(source.c_str(), source.length(),
+                &parser_output.lexer_output, masonc::lexer::input_edit{ offset, 2, 2 });
+            masonc::parser::parser_instance{ &parser_output, tokens };
+
+            end = std::chrono::high_resolution_clock::now();
+
+            f64 seconds = std::chrono::duration<f64>(end - start).count();
+            if (i == 0 || seconds < best_reparse_seconds)
+                best_reparse_seconds = seconds;
+        }
+
+        std::cout << "parser: " << procedure_count << " procedures parsed in " << full_seconds * 1000.0
+                  << " ms, edit retokenized and reparsed in " << best_reparse_seconds * 1000.0 << " ms" << std::endl;
+    }
 }
\ No newline at end of file
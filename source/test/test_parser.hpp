@@ -2,6 +2,7 @@
 #define MASONC_TEST_PARSER_HPP
 
 #include <message.hpp>
+#include <common.hpp>
 
 #include <vector>
 #include <optional>
@@ -25,6 +26,32 @@ namespace masonc::test::parser
     // Returns empty result if file i/o or lexing failed.
     // Returns the parser's message list otherwise.
     std::optional<message_list> test_parse(const char* filename);
+
+    // Returns mason source code of at least "min_size" characters made of procedures
+    // full of nested unary and binary expressions.
+    std::string generated_expression_source(u64 min_size);
+
+    // Test if binary expressions are parsed into a tree that respects operator precedence,
+    // associativity and parentheses.
+    void test_operator_precedence();
+
+#ifdef MASONC_COUNT_ALLOCATIONS
+    // Test if the number of allocations while parsing depends on the number of procedures only,
+    // not on the number of expressions in their bodies. Only part of the test executable,
+    // see "masonc::test::allocation_counter".
+    void test_parse_allocations();
+#endif
+
+    // Test if reparsing after an edit gives the same result as parsing from scratch,
+    // and if it only replaces the top-level expressions the edit touched.
+    void test_incremental_reparse();
+
+    // Print the parse time of expression-heavy code and how much memory its AST takes.
+    void benchmark_parser(u64 source_size = 1024 * 1024 * 4, u64 iterations = 8);
+
+    // Print the time to parse a file of "procedure_count" procedures and to reparse it
+    // after a one-character edit.
+    void benchmark_incremental_reparse(u64 procedure_count = 1024 * 8, u64 iterations = 16);
 }
 
 #endif
\ No newline at end of file
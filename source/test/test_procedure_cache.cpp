@@ -0,0 +1,149 @@
+#include <test_procedure_cache.hpp>
+#include <temporary_directory.hpp>
+
+#include <lexer.hpp>
+#include <parser.hpp>
+
+#include <string>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <filesystem>
+
+namespace masonc::test::procedure_cache
+{
+    static const std::string CALLER_SOURCE =
+        "module test::procedures;\n\n"
+        "proc print(text: ^char)\n{\n"
+        "    line: ^char;\n"
+        "}\n\n"
+        "proc compute() -> f64\n{\n"
+        "    ratio: f64 = 3.25;\n"
+        "    print(\"ratio\");\n"
+        "}\n";
+
+    static void parse(const std::string& source, masonc::parser::parser_instance_output* output)
+    {
+        masonc::lexer::lexer_instance lexer;
+        lexer.tokenize(source.c_str(), source.length(), &output->lexer_output);
+
+        masonc::parser::parser_instance parser{ output };
+
+        if (output->lexer_output.messages.errors.size() > 0 || output->messages.errors.size() > 0)
+            throw std::runtime_error{ "procedure cache test failed: source did not parse" };
+    }
+
+    // Hash of the procedure "compute" after replacing "from" with "to" in "CALLER_SOURCE".
+    static std::optional<u64> compute_hash(const std::string& from = "", const std::string& to = "")
+    {
+        std::string source = CALLER_SOURCE;
+
+        if (!from.empty())
+            source.replace(source.find(from), from.length(), to);
+
+        masonc::parser::parser_instance_output output;
+        parse(source, &output);
+
+        masonc::cache::signature_map signatures;
+        masonc::cache::add_signatures(output, &signatures);
+
+        auto signature_of = [&](symbol name) -> std::optional<u64> {
+            auto find_it = signatures.find(name);
+            if (find_it == signatures.end())
+                return std::nullopt;
+
+            return find_it->second;
+        };
+
+        symbol compute_name = global_interner.intern("compute");
+
+        for (masonc::parser::expression_handle top_level : output.AST) {
+            const masonc::parser::expression& expr = output.expression_at(top_level);
+            if (expr.type != masonc::parser::EXPR_PROC_DEFINITION)
+                continue;
+
+            const masonc::parser::expression& prototype = output.expression_at(expr.procedure_definition.prototype);
+            if (prototype.procedure_prototype.name_handle == compute_name)
+                return masonc::cache::procedure_hash(output, expr.procedure_definition, signature_of);
+        }
+
+        throw std::runtime_error{ "procedure cache test failed: \"compute\" was not parsed" };
+    }
+
+    void test_procedure_hash()
+    {
+        std::optional<u64> hash = compute_hash();
+
+        if (!hash)
+            throw std::runtime_error{ "procedure cache test failed: no hash although every name is declared" };
+
+        if (compute_hash() != hash)
+            throw std::runtime_error{ "procedure cache test failed: hash differs between parses" };
+
+        // Different string IDs and positions in the file.
+        if (compute_hash("proc print", "proc other()\n{\n    count: u32;\n}\n\nproc print") != hash)
+            throw std::runtime_error{ "procedure cache test failed: hash changed with another procedure" };
+
+        if (compute_hash("    line: ^char;\n", "    line: ^char;\n    column: u32;\n") != hash)
+            throw std::runtime_error{ "procedure cache test failed: hash changed with the body of a callee" };
+
+        if (compute_hash("3.25", "4.25") == hash)
+            throw std::runtime_error{ "procedure cache test failed: hash did not change with a literal" };
+
+        if (compute_hash("ratio: f64", "ratio: f32") == hash)
+            throw std::runtime_error{ "procedure cache test failed: hash did not change with a type" };
+
+        if (compute_hash("text: ^char", "text: ^u8") == hash)
+            throw std::runtime_error{ "procedure cache test failed: hash did not change with a callee signature" };
+
+        if (!compute_hash("print(\"ratio\")", "print(ratio)"))
+            throw std::runtime_error{ "procedure cache test failed: no hash with a reference to a local variable" };
+
+        if (compute_hash("print(\"ratio\")", "missing(\"ratio\")"))
+            throw std::runtime_error{ "procedure cache test failed: hash with a call to an undeclared procedure" };
+    }
+
+    void test_store_and_load()
+    {
+        masonc::test::temporary_directory directory{ "masonc_test_procedure_cache" };
+        masonc::cache::procedure_cache cache{ directory.path() };
+
+        archive_member object{ "", std::string{ "\x7f" "ELF\0object", 11 }, { "compute", "compute.helper" } };
+        u64 key = masonc::cache::procedure_cache::key(1234, "x86_64-pc-linux-gnu O2");
+
+        if (key == masonc::cache::procedure_cache::key(1234, "x86_64-pc-linux-gnu O3"))
+            throw std::runtime_error{ "procedure cache test failed: key does not depend on the configuration" };
+
+        if (cache.load(key, "compute.o"))
+            throw std::runtime_error{ "procedure cache test failed: found an entry in an empty cache" };
+
+        if (!cache.store(key, object))
+            throw std::runtime_error{ "procedure cache test failed: could not store entry" };
+
+        std::optional<archive_member> loaded = cache.load(key, "compute.o");
+
+        if (!loaded || loaded->name != "compute.o" || loaded->contents != object.contents ||
+            loaded->symbols != object.symbols)
+        {
+            throw std::runtime_error{ "procedure cache test failed: loaded object differs from stored object" };
+        }
+
+        std::filesystem::path entry_path = std::filesystem::directory_iterator{ directory.path() }->path();
+        u64 entry_size = std::filesystem::file_size(entry_path);
+
+        {
+            std::fstream entry{ entry_path, std::ios::in | std::ios::out | std::ios::binary };
+            entry.seekp(static_cast<std::streamoff>(entry_size - 2));
+            entry.put('\x5a');
+        }
+
+        if (cache.load(key, "compute.o"))
+            throw std::runtime_error{ "procedure cache test failed: loaded damaged entry" };
+
+        cache.store(key, object);
+        std::filesystem::resize_file(entry_path, 8);
+
+        if (cache.load(key, "compute.o"))
+            throw std::runtime_error{ "procedure cache test failed: loaded truncated entry" };
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef MASONC_TEST_PROCEDURE_CACHE_HPP
+#define MASONC_TEST_PROCEDURE_CACHE_HPP
+
+#include <procedure_cache.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::procedure_cache
+{
+    // Test if a procedure's hash only changes with the procedure itself
+    // and with the signatures of the procedures it calls.
+    void test_procedure_hash();
+
+    // Test if a stored object is loaded as it was stored and if damaged entries are rejected.
+    void test_store_and_load();
+}
+
+#endif
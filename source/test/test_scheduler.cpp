@@ -0,0 +1,110 @@
+#include <test_scheduler.hpp>
+
+#include <stdexcept>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace masonc::test::scheduler
+{
+    void test_all_jobs_run()
+    {
+        constexpr u64 OUTER_JOB_COUNT = 1000;
+        constexpr u64 INNER_JOBS_PER_JOB = 3;
+
+        std::vector<std::atomic<u32>> runs(OUTER_JOB_COUNT * (INNER_JOBS_PER_JOB + 1));
+
+        masonc::work_stealing_scheduler scheduler{ 4 };
+
+        for (u64 i = 0; i < OUTER_JOB_COUNT; i += 1) {
+            scheduler.submit([&, i](u64) {
+                runs[i].fetch_add(1);
+
+                for (u64 j = 0; j < INNER_JOBS_PER_JOB; j += 1) {
+                    u64 inner_index = OUTER_JOB_COUNT + i * INNER_JOBS_PER_JOB + j;
+                    scheduler.submit([&, inner_index](u64) { runs[inner_index].fetch_add(1); });
+                }
+            }, i % 17);
+        }
+
+        scheduler.finish();
+
+        for (const std::atomic<u32>& run_count : runs) {
+            if (run_count.load() != 1)
+                throw std::runtime_error{ "scheduler test failed: a job did not run exactly once" };
+        }
+
+        u64 jobs_run = 0;
+        for (const masonc::worker_stats& stats : scheduler.stats()) {
+            jobs_run += stats.jobs_run;
+        }
+
+        if (jobs_run != runs.size())
+            throw std::runtime_error{ "scheduler test failed: unexpected job count in stats" };
+    }
+
+    void test_stealing()
+    {
+        constexpr u64 JOB_COUNT = 200;
+        std::atomic<u64> finished_jobs{ 0 };
+
+        masonc::work_stealing_scheduler scheduler{ 4 };
+
+        // All jobs end up in the deque of the worker that runs this one.
+        scheduler.submit([&](u64) {
+            for (u64 i = 0; i < JOB_COUNT; i += 1) {
+                scheduler.submit([&](u64) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+                    finished_jobs.fetch_add(1);
+                });
+            }
+        });
+
+        scheduler.finish();
+
+        u64 jobs_stolen = 0;
+        for (const masonc::worker_stats& stats : scheduler.stats()) {
+            jobs_stolen += stats.jobs_stolen;
+        }
+
+        if (finished_jobs.load() != JOB_COUNT)
+            throw std::runtime_error{ "scheduler test failed: not every job finished" };
+
+        if (jobs_stolen == 0)
+            throw std::runtime_error{ "scheduler test failed: no job was stolen" };
+    }
+
+    void test_priority_order()
+    {
+        constexpr u64 JOB_COUNT = 24;
+
+        std::atomic<bool> released{ false };
+        std::vector<u64> order;
+
+        masonc::work_stealing_scheduler scheduler{ 1 };
+
+        // Keeps the only worker busy until every other job is submitted.
+        scheduler.submit([&](u64) {
+            while (!released.load()) {
+                std::this_thread::yield();
+            }
+        }, JOB_COUNT + 1);
+
+        for (u64 i = 0; i < JOB_COUNT; i += 1) {
+            u64 priority = (i * 7) % JOB_COUNT;
+            scheduler.submit([&order, priority](u64) { order.push_back(priority); }, priority);
+        }
+
+        released.store(true);
+        scheduler.finish();
+
+        if (order.size() != JOB_COUNT)
+            throw std::runtime_error{ "scheduler test failed: not every job ran" };
+
+        for (u64 i = 0; i < JOB_COUNT; i += 1) {
+            if (order[i] != JOB_COUNT - 1 - i)
+                throw std::runtime_error{ "scheduler test failed: jobs did not run highest priority first" };
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef MASONC_TEST_SCHEDULER_HPP
+#define MASONC_TEST_SCHEDULER_HPP
+
+#include <scheduler.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::scheduler
+{
+    // Test if every job, including jobs submitted from inside jobs, runs exactly once.
+    void test_all_jobs_run();
+
+    // Test if idle workers steal jobs that another worker submitted to its own deque.
+    void test_stealing();
+
+    // Test if a single worker runs jobs submitted from outside highest priority first.
+    void test_priority_order();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include <test_scope.hpp>
+
+#include <mod.hpp>
+#include <language.hpp>
+#include <interner.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+namespace masonc::test::scope
+{
+    void test_find_symbol()
+    {
+        mod test_module;
+        test_module.module_scope().set_module(&test_module);
+
+        symbol module_symbol = global_interner.intern("test_module_symbol");
+        symbol nested_symbol = global_interner.intern("test_nested_symbol");
+        test_module.module_scope().add_symbol(module_symbol);
+
+        // A chain of nested scopes, with siblings added in between so that the scopes are moved around.
+        std::vector<scope_handle> chain{ MODULE_SCOPE_HANDLE };
+
+        for (u64 depth = 0; depth < 64; depth += 1) {
+            test_module.scopes[chain.back()].add_child(masonc::scope{});
+            chain.push_back(test_module.scopes[chain.back()].add_child(masonc::scope{}));
+        }
+
+        for (u64 i = 1; i < chain.size(); i += 1) {
+            const masonc::scope& current = test_module.scopes[chain[i]];
+
+            if (current.handle() != chain[i] || current.parent() != chain[i - 1])
+                throw std::runtime_error{ "scope test failed: wrong handle or parent" };
+        }
+
+        test_module.scopes[chain[32]].add_symbol(nested_symbol);
+
+        const masonc::scope& deepest = test_module.scopes[chain.back()];
+
+        if (!deepest.find_symbol(module_symbol) || !deepest.find_symbol(nested_symbol) ||
+            !test_module.module_scope().find_symbol(module_symbol))
+        {
+            throw std::runtime_error{ "scope test failed: symbol of an enclosing scope not found" };
+        }
+
+        if (test_module.scopes[chain[31]].find_symbol(nested_symbol) ||
+            test_module.module_scope().find_symbol(nested_symbol))
+        {
+            throw std::runtime_error{ "scope test failed: symbol of a nested scope found" };
+        }
+
+        // The deepest scope is 64 scopes below the module scope and 32 below the one with "nested_symbol".
+        if (!deepest.find_symbol(nested_symbol, 32) || deepest.find_symbol(nested_symbol, 33) ||
+            !deepest.find_symbol(module_symbol, 64) || deepest.find_symbol(module_symbol, 65))
+        {
+            throw std::runtime_error{ "scope test failed: offset skipped the wrong scopes" };
+        }
+
+        symbol builtin_type = global_interner.intern(TYPE_S32);
+
+        // The module scope starts out empty and reaches language-defined types through its parent,
+        // which comes right after the module scope.
+        if (!deepest.find_symbol(builtin_type) || !deepest.find_symbol(builtin_type, 65) ||
+            deepest.find_symbol(builtin_type, 66) || test_module.module_scope().add_symbol(builtin_type))
+        {
+            throw std::runtime_error{ "scope test failed: language-defined type not found in built-in scope" };
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef MASONC_TEST_SCOPE_HPP
+#define MASONC_TEST_SCOPE_HPP
+
+#include <scope.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::scope
+{
+    // Test if symbols are found in the scope they are defined in and in every scope below it,
+    // but not above it, and if "offset" skips scopes from the bottom.
+    // Also test if language-defined types are found through the shared built-in scope.
+    void test_find_symbol();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <test_symbol_table.hpp>
+
+#include <lexer.hpp>
+#include <parser.hpp>
+#include <interner.hpp>
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+namespace masonc::test::symbol_table
+{
+    static void parse(const std::string& source, masonc::parser::parser_instance_output* output)
+    {
+        masonc::lexer::lexer_instance lexer;
+        lexer.tokenize(source.c_str(), source.length(), &output->lexer_output);
+
+        masonc::parser::parser_instance parser{ output };
+
+        if (output->lexer_output.messages.errors.size() > 0 || output->messages.errors.size() > 0)
+            throw std::runtime_error{ "symbol table test failed: source did not parse" };
+    }
+
+    void test_concurrent_add_module()
+    {
+        constexpr u64 THREAD_COUNT = 8;
+        constexpr u64 MODULE_COUNT = 64;
+        constexpr u64 PROCEDURE_COUNT = 16;
+
+        // Sources have to outlive the outputs, because token values point into them.
+        std::vector<std::string> sources;
+        std::deque<masonc::parser::parser_instance_output> outputs(MODULE_COUNT);
+
+        // Every module declares its own procedures and imports the module before it.
+        for (u64 i = 0; i < MODULE_COUNT; i += 1) {
+            std::string source = "module test::table_" + std::to_string(i) + ";\n";
+
+            if (i > 0)
+                source += "import test::table_" + std::to_string(i - 1) + ";\n";
+
+            for (u64 j = 0; j < PROCEDURE_COUNT; j += 1) {
+                source += "proc table_" + std::to_string(i) + "_" + std::to_string(j) + "();\n";
+            }
+
+            sources.push_back(source);
+        }
+
+        for (u64 i = 0; i < MODULE_COUNT; i += 1) {
+            parse(sources[i], &outputs[i]);
+        }
+
+        masonc::symbol_table table;
+        std::vector<std::thread> threads;
+
+        // Each thread only writes the results of its own modules.
+        std::vector<char> added(MODULE_COUNT, false);
+
+        for (u64 i = 0; i < THREAD_COUNT; i += 1) {
+            threads.emplace_back([&table, &outputs, &added, i]() {
+                for (u64 j = i; j < MODULE_COUNT; j += THREAD_COUNT) {
+                    added[j] = table.add_module(&outputs[j]).empty();
+                }
+            });
+        }
+
+        for (u64 i = 0; i < threads.size(); i += 1) {
+            threads[i].join();
+        }
+
+        for (u64 i = 0; i < MODULE_COUNT; i += 1) {
+            if (!added[i])
+                throw std::runtime_error{ "symbol table test failed: symbol declared twice" };
+        }
+
+        if (table.size() != MODULE_COUNT * PROCEDURE_COUNT)
+            throw std::runtime_error{ "symbol table test failed: unexpected size" };
+
+        for (u64 i = 0; i < MODULE_COUNT; i += 1) {
+            symbol module_name = global_interner.intern("test::table_" + std::to_string(i));
+
+            for (u64 j = 0; j < PROCEDURE_COUNT; j += 1) {
+                symbol name = global_interner.intern("table_" + std::to_string(i) + "_" + std::to_string(j));
+                std::optional<declaration> search = table.find(module_name, name);
+
+                // The module declaration and the import come before the procedures.
+                u32 top_level_index = static_cast<u32>(j + (i > 0 ? 2 : 1));
+
+                if (!search || search.value().module != &outputs[i] ||
+                    search.value().top_level_index != top_level_index)
+                {
+                    throw std::runtime_error{ "symbol table test failed: declaration not found" };
+                }
+
+                // Found through the module that imports it, but not through the module itself.
+                if (i + 1 < MODULE_COUNT && !table.find_imported(&outputs[i + 1], name))
+                    throw std::runtime_error{ "symbol table test failed: imported declaration not found" };
+
+                if (table.find_imported(&outputs[i], name))
+                    throw std::runtime_error{ "symbol table test failed: declaration found without import" };
+            }
+        }
+
+        // Another file of an added module declares its symbols again, as variables.
+        std::string duplicate_source = "module test::table_0;\n";
+
+        for (u64 j = 0; j < PROCEDURE_COUNT; j += 1) {
+            duplicate_source += "table_0_" + std::to_string(j) + ": s32;\n";
+        }
+
+        masonc::parser::parser_instance_output duplicate;
+        parse(duplicate_source, &duplicate);
+
+        if (table.add_module(&duplicate).size() != PROCEDURE_COUNT || table.size() != MODULE_COUNT * PROCEDURE_COUNT ||
+            table.find(global_interner.intern("test::table_0"),
+                global_interner.intern("table_0_0")).value().module != &outputs[0])
+        {
+            throw std::runtime_error{ "symbol table test failed: duplicate declaration replaced the first one" };
+        }
+    }
+
+    void test_declarations_across_files()
+    {
+        // Both files name an argument "value", and the second one declares
+        // the procedure of the first one to call it, once matching and once not.
+        std::string first_source = "module test::files;\nlimit: s32 = 4;\n"
+            "proc first(value: s32) -> s32 { return value; }\n";
+        std::string second_source = "module test::files;\nproc first(number: s32) -> s32;\n"
+            "proc second(value: s32) -> s32 { return first(value); }\n";
+        std::string mismatched_source = "module test::files;\nproc first(number: s64) -> s32;\n";
+
+        masonc::parser::parser_instance_output first;
+        masonc::parser::parser_instance_output second;
+        masonc::parser::parser_instance_output mismatched;
+
+        parse(first_source, &first);
+        parse(second_source, &second);
+        parse(mismatched_source, &mismatched);
+
+        masonc::symbol_table table;
+
+        // The prototype comes first, so that the definition has to replace it.
+        if (!table.add_module(&second).empty() || !table.add_module(&first).empty())
+            throw std::runtime_error{ "symbol table test failed: matching prototype or argument declared twice" };
+
+        if (table.size() != 3)
+            throw std::runtime_error{ "symbol table test failed: arguments were added or a variable was not" };
+
+        std::optional<declaration> search = table.find(global_interner.intern("test::files"),
+            global_interner.intern("first"));
+
+        if (!search || search.value().module != &first)
+            throw std::runtime_error{ "symbol table test failed: prototype kept over the definition" };
+
+        if (table.add_module(&mismatched).size() != 1)
+            throw std::runtime_error{ "symbol table test failed: prototype with another signature accepted" };
+    }
+}
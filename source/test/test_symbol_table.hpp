@@ -0,0 +1,19 @@
+#ifndef MASONC_TEST_SYMBOL_TABLE_HPP
+#define MASONC_TEST_SYMBOL_TABLE_HPP
+
+#include <symbol_table.hpp>
+
+#include <common.hpp>
+
+namespace masonc::test::symbol_table
+{
+    // Test if modules added from several threads at once can all be found, if symbols are found
+    // through the imports of a module, and if a symbol declared twice keeps its first declaration.
+    void test_concurrent_add_module();
+
+    // Test if only top-level declarations are added, so that files of a module can use the same
+    // argument names, and if a prototype matching a definition in another file is no duplicate.
+    void test_declarations_across_files();
+}
+
+#endif
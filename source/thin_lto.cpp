@@ -0,0 +1,168 @@
+#include <thin_lto.hpp>
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Linker.h>
+
+#include <robin_hood.hpp>
+
+namespace masonc::llvm
+{
+    static bool is_local(LLVMValueRef global)
+    {
+        LLVMLinkage linkage = LLVMGetLinkage(global);
+        return linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage;
+    }
+
+    // Whether "operand" refers to a global that is local to its module and may change,
+    // directly or through the constants it is made of.
+    static bool refers_to_local_state(LLVMValueRef operand)
+    {
+        std::vector<LLVMValueRef> stack{ operand };
+
+        while (!stack.empty()) {
+            LLVMValueRef value = stack.back();
+            stack.pop_back();
+
+            if (LLVMIsAGlobalValue(value)) {
+                // Copies of local constants behave like the original, copies of anything else do not.
+                bool is_constant = LLVMIsAGlobalVariable(value) && LLVMIsGlobalConstant(value);
+
+                if (is_local(value) && !is_constant)
+                    return true;
+
+                continue;
+            }
+
+            if (!LLVMIsAConstant(value))
+                continue;
+
+            int operand_count = LLVMGetNumOperands(value);
+
+            for (int i = 0; i < operand_count; i += 1) {
+                stack.push_back(LLVMGetOperand(value, static_cast<unsigned int>(i)));
+            }
+        }
+
+        return false;
+    }
+
+    module_summary summarize_module(LLVMModuleRef module)
+    {
+        module_summary summary;
+
+        LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(module);
+        summary.bitcode.assign(LLVMGetBufferStart(bitcode), LLVMGetBufferSize(bitcode));
+        LLVMDisposeMemoryBuffer(bitcode);
+
+        for (LLVMValueRef function = LLVMGetFirstFunction(module); function;
+            function = LLVMGetNextFunction(function))
+        {
+            // Weak definitions may be replaced at link time, so they cannot be imported either.
+            if (LLVMIsDeclaration(function) || LLVMGetLinkage(function) != LLVMExternalLinkage)
+                continue;
+
+            u64 instruction_count = 0;
+            bool importable = true;
+
+            for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block && importable;
+                block = LLVMGetNextBasicBlock(block))
+            {
+                for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction && importable;
+                    instruction = LLVMGetNextInstruction(instruction))
+                {
+                    instruction_count += 1;
+
+                    int operand_count = LLVMGetNumOperands(instruction);
+
+                    for (int i = 0; i < operand_count && importable; i += 1) {
+                        importable = !refers_to_local_state(
+                            LLVMGetOperand(instruction, static_cast<unsigned int>(i)));
+                    }
+                }
+            }
+
+            if (!importable)
+                continue;
+
+            size_t name_length = 0;
+            const char* name = LLVMGetValueName2(function, &name_length);
+
+            summary.procedures.push_back(procedure_summary{ std::string{ name, name_length }, instruction_count });
+        }
+
+        return summary;
+    }
+
+    bool import_procedures(LLVMModuleRef module, const procedure_import& import)
+    {
+        // Only procedures that "module" calls but does not define are worth importing.
+        robin_hood::unordered_flat_set<std::string> wanted_names;
+
+        for (const std::string& name : import.names) {
+            LLVMValueRef declaration = LLVMGetNamedFunction(module, name.c_str());
+
+            if (declaration && LLVMIsDeclaration(declaration))
+                wanted_names.insert(name);
+        }
+
+        if (wanted_names.empty())
+            return true;
+
+        const std::string& bitcode = import.source->bitcode;
+        LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(bitcode.data(), bitcode.size(),
+            "import", false);
+
+        // Reads the whole module, so the buffer is not needed afterwards.
+        LLVMModuleRef imported_module;
+        bool read_failed = LLVMParseBitcodeInContext2(LLVMGetModuleContext(module), buffer, &imported_module);
+        LLVMDisposeMemoryBuffer(buffer);
+
+        if (read_failed)
+            return false;
+
+        std::vector<LLVMValueRef> functions;
+
+        for (LLVMValueRef function = LLVMGetFirstFunction(imported_module); function;
+            function = LLVMGetNextFunction(function))
+        {
+            functions.push_back(function);
+        }
+
+        // Every other externally visible definition becomes a declaration, so that "module" does not
+        // define it a second time. Local definitions are left to the optimizer, which removes them
+        // unless an imported procedure uses them.
+        for (LLVMValueRef function : functions) {
+            if (LLVMIsDeclaration(function) || is_local(function))
+                continue;
+
+            size_t name_length = 0;
+            const char* name_data = LLVMGetValueName2(function, &name_length);
+            std::string name{ name_data, name_length };
+
+            if (wanted_names.find(name) != wanted_names.end()) {
+                LLVMSetLinkage(function, LLVMAvailableExternallyLinkage);
+                continue;
+            }
+
+            // Deleting a function drops its body safely, a fresh declaration takes over its uses.
+            LLVMTypeRef function_type = LLVMGlobalGetValueType(function);
+            LLVMSetValueName2(function, "", 0);
+
+            LLVMValueRef declaration = LLVMAddFunction(imported_module, name.c_str(), function_type);
+            LLVMReplaceAllUsesWith(function, declaration);
+            LLVMDeleteFunction(function);
+        }
+
+        for (LLVMValueRef global = LLVMGetFirstGlobal(imported_module); global; global = LLVMGetNextGlobal(global)) {
+            if (LLVMIsDeclaration(global) || is_local(global))
+                continue;
+
+            LLVMSetInitializer(global, nullptr);
+            LLVMSetLinkage(global, LLVMExternalLinkage);
+        }
+
+        // Takes ownership of "imported_module".
+        return !LLVMLinkModules2(module, imported_module);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef MASONC_THIN_LTO_HPP
+#define MASONC_THIN_LTO_HPP
+
+#include <common.hpp>
+
+#include <llvm-c/Core.h>
+
+#include <string>
+#include <vector>
+
+namespace masonc::llvm
+{
+    // How modules are optimized across module boundaries.
+    enum class lto_mode : u8
+    {
+        // Every module is optimized on its own.
+        NONE,
+
+        // Modules import small procedures of the modules they import, so that those can be inlined,
+        // while every module is still optimized and compiled on its own and in parallel.
+        //
+        // This follows ThinLTO: summaries are made in parallel, a cheap serial "thin link" decides
+        // what to import by looking only at the summaries, and the backends import and compile
+        // in parallel again. The LLVM C API cannot write ThinLTO's own summaries into bitcode,
+        // so "module_summary" takes their place.
+        THIN
+    };
+
+    // Procedures with at most this many instructions are imported, like ThinLTO's "import-instr-limit".
+    constexpr u64 IMPORT_INSTRUCTION_LIMIT = 100;
+
+    struct procedure_summary
+    {
+        std::string name;
+        u64 instruction_count;
+    };
+
+    // What the thin link needs to know about a module, without looking at its IR.
+    struct module_summary
+    {
+        // The module as bitcode, which importing modules read into their own context.
+        std::string bitcode;
+
+        // Procedures that other modules may import. They are defined with external linkage
+        // and refer to nothing that is local to the module, except for constants.
+        std::vector<procedure_summary> procedures;
+    };
+
+    // Procedures that a module imports from the module with summary "source".
+    struct procedure_import
+    {
+        const module_summary* source;
+        std::vector<std::string> names;
+    };
+
+    // Summarizes "module" after it was converted and before it is optimized.
+    module_summary summarize_module(LLVMModuleRef module);
+
+    // Links the procedures of "import" that "module" declares into it as "available_externally"
+    // definitions, which the optimizer can inline but which are never emitted, because the object
+    // of the source module has them. Returns false if the bitcode could not be read or linked.
+    bool import_procedures(LLVMModuleRef module, const procedure_import& import);
+}
+
+#endif
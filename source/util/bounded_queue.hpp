@@ -0,0 +1,97 @@
+#ifndef MASONC_BOUNDED_QUEUE_HPP
+#define MASONC_BOUNDED_QUEUE_HPP
+
+#include <common.hpp>
+
+#include <vector>
+#include <mutex>
+#include <optional>
+#include <condition_variable>
+
+namespace masonc
+{
+    // Queue with a fixed capacity that any number of threads can push to and pop from.
+    //
+    // Connects the stages of a pipeline. A stage that produces faster than the next one consumes
+    // blocks on "push" once the queue is full, instead of piling up unbounded work in memory.
+    template <typename value_t>
+    struct bounded_queue
+    {
+        // "capacity" must be at least 1.
+        explicit bounded_queue(u64 capacity)
+            : slots(capacity)
+        {
+            assume(capacity > 0);
+        }
+
+        bounded_queue(const bounded_queue& other) = delete;
+        bounded_queue& operator=(const bounded_queue& other) = delete;
+
+        // Blocks while the queue is full.
+        // Returns false without adding "value" if the queue is closed.
+        bool push(value_t value)
+        {
+            std::unique_lock<std::mutex> queue_lock{ queue_mutex };
+            not_full_condition.wait(queue_lock, [&]() { return count < slots.size() || closed; });
+
+            if (closed)
+                return false;
+
+            slots[(first + count) % slots.size()].emplace(std::move(value));
+            count += 1;
+
+            queue_lock.unlock();
+            not_empty_condition.notify_one();
+
+            return true;
+        }
+
+        // Blocks while the queue is empty and not closed.
+        // The result is empty once the queue is closed and every value is popped.
+        std::optional<value_t> pop()
+        {
+            std::unique_lock<std::mutex> queue_lock{ queue_mutex };
+            not_empty_condition.wait(queue_lock, [&]() { return count > 0 || closed; });
+
+            if (count == 0)
+                return std::nullopt;
+
+            std::optional<value_t> value = std::move(slots[first]);
+            slots[first].reset();
+
+            first = (first + 1) % slots.size();
+            count -= 1;
+
+            queue_lock.unlock();
+            not_full_condition.notify_one();
+
+            return value;
+        }
+
+        // Lets consumers pop the remaining values and then stop, and makes further "push" calls fail.
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> queue_lock{ queue_mutex };
+                closed = true;
+            }
+
+            not_full_condition.notify_all();
+            not_empty_condition.notify_all();
+        }
+
+    private:
+        std::mutex queue_mutex;
+        std::condition_variable not_full_condition;
+        std::condition_variable not_empty_condition;
+
+        // Ring buffer of "count" values starting at "first".
+        std::vector<std::optional<value_t>> slots;
+        u64 first = 0;
+        u64 count = 0;
+
+        bool closed = false;
+    };
+}
+
+#endif
\ No newline at end of file
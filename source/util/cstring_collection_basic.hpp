@@ -133,6 +133,7 @@ namespace masonc
         }
 
         // "length" is expected to not count the null terminator.
+        // "str" does not have to be null-terminated, the terminator is always appended.
         // Returns the index of the string.
         u64 copy_back(const char* str, length_t length)
         {
@@ -143,7 +144,8 @@ namespace masonc
             lookup.push_back(occupied_bytes);
             lengths.push_back(length);
 
-            std::memcpy(buffer + occupied_bytes, str, length + 1);
+            std::memcpy(buffer + occupied_bytes, str, length);
+            buffer[occupied_bytes + length] = '\0';
             occupied_bytes = occupied_bytes_after_copy;
 
             return index;
@@ -6,14 +6,18 @@
 #include <iterator.hpp>
 
 #include <vector>
+#include <limits>
 #include <optional>
+#include <algorithm>
+
+#include <robin_hood.hpp>
 
 namespace masonc
 {
     template <typename value_t>
     struct dependency_list_vertex
     {
-        template <typename value_t>
+        template <typename>
         friend struct dependency_list;
 
         value_t value;
@@ -30,9 +34,17 @@ namespace masonc
     private:
         // Every vertex in "vertices" contains a list of indices that point to other vertices.
         std::vector<u64> adjacency_list;
+
+        // Same indices as "adjacency_list", so that adding an adjacency does not have to search it.
+        robin_hood::unordered_flat_set<u64> adjacency_set;
     };
 
     // Directed graph implemented using adjacency list.
+    // Vertices are found by value through a hash map, so "value_t" has to be hashable.
+    //
+    // An edge from "a" to "b" means that "a" depends on "b". Everything that walks the graph
+    // ("is_dependent", "find_cycles", "waves") is iterative and takes linear time,
+    // so the graph can get large without blowing up the stack.
     template <typename value_t>
     struct dependency_list : public iterable<dependency_list_vertex<value_t>>
     {
@@ -50,17 +62,7 @@ namespace masonc
 
             assume(dependency_vertex_index.has_value());
 
-            if (!is_adjacent(*vertex, *dependency_vertex)) {
-                vertex->adjacency_list.push_back(dependency_vertex_index.value());
-            }
-            /*
-            if (is_dependent(dependency_vertex, vertex)) {
-                // Adding new dependency will result in a cycle.
-            }
-            else {
-                // No cycle.
-            }
-            */
+            add_adjacency_index(vertex, dependency_vertex_index.value());
         }
 
         // If there is no vertex with value "value" that is adjacent to a vertex with
@@ -70,49 +72,45 @@ namespace masonc
             vertex_t* vertex = find(value);
             std::optional<u64> dependency_vertex_index = find_index(dependency);
 
-            if (vertex != nullptr && dependency_vertex_index.has_value()) {
-                vertex_t* dependency_vertex = &vertices[dependency_vertex_index.value()];
-
-                if (!is_adjacent(*vertex, *dependency_vertex)) {
-                    vertex->adjacency_list.push_back(dependency_vertex_index.value());
-                }
-                /*
-                if (is_dependent(dependency_vertex, vertex)) {
-                    // Adding new dependency will result in a cycle.
-                }
-                else {
-                    // No cycle.
-                }
-                */
-            }
+            if (vertex != nullptr && dependency_vertex_index.has_value())
+                add_adjacency_index(vertex, dependency_vertex_index.value());
         }
 
         // Returns true if "a" is adjacent to "b", that means if "a" points to "b".
         bool is_adjacent(const vertex_t& a, const vertex_t& b)
         {
-            for (u64 i = 0; i < a.adjacency_list.size(); i += 1) {
-                u64 a_index = a.adjacency_list[i];
-
-                if (vertices[a_index] == b)
-                    return true;
-            }
-
-            return false;
+            std::optional<u64> b_index = find_index(b.value);
+            return b_index && points_to(a, b_index.value());
         }
 
         // Returns true if "vertex" depends on "dependency_vertex",
         // that means if there is a path from "vertex" to "dependency_vertex".
         bool is_dependent(const vertex_t& vertex, const vertex_t& dependency_vertex)
         {
-            bool result = false;
-            std::vector<vertex_t*> seen;
+            std::optional<u64> dependency_index = find_index(dependency_vertex.value);
+            if (!dependency_index)
+                return false;
 
-            // Rough estimate.
-            seen.reserve(16);
+            std::vector<BOOL> seen(vertices.size(), FALSE);
+            std::vector<u64> stack{ vertex.adjacency_list.begin(), vertex.adjacency_list.end() };
 
-            is_dependent_recurse(vertex, dependency_vertex, &seen, &result);
+            while (!stack.empty()) {
+                u64 current_index = stack.back();
+                stack.pop_back();
 
-            return result;
+                if (current_index == dependency_index.value())
+                    return true;
+
+                if (seen[current_index])
+                    continue;
+
+                seen[current_index] = TRUE;
+
+                const std::vector<u64>& adjacency_list = vertices[current_index].adjacency_list;
+                stack.insert(stack.end(), adjacency_list.begin(), adjacency_list.end());
+            }
+
+            return false;
         }
 
         // If no vertex with the specified value exists yet, adds a vertex with that value
@@ -120,9 +118,9 @@ namespace masonc
         // Returns "nullptr" if a vertex with that value already exists.
         vertex_t* add_vertex(const_ref_t<value_t> value)
         {
-            vertex_t* search_value = find(value);
+            auto [index_it, inserted] = indices.emplace(value, vertices.size());
 
-            if (search_value == nullptr) {
+            if (inserted) {
                 // Vertex does not exist yet.
                 return &vertices.emplace_back(vertex_t{ value });
             }
@@ -135,45 +133,130 @@ namespace masonc
         // Returns "nullptr" if no vertex with the specified value was not found.
         vertex_t* find(const_ref_t<value_t> value)
         {
-            for (u64 i = 0; i < vertices.size(); i += 1) {
-                vertex_t* vertex = &vertices[i];
+            std::optional<u64> index = find_index(value);
 
-                if (vertex->value == value) {
-                    return vertex;
-                }
-            }
+            if (!index)
+                return nullptr;
 
-            return nullptr;
+            return &vertices[index.value()];
         }
 
         // Returns the index of the vertex with the specified value if it exists.
-        std::optional<u64> find_index(const_ref_t<value_t> value)
+        std::optional<u64> find_index(const_ref_t<value_t> value) const
         {
-            for (u64 i = 0; i < vertices.size(); i += 1) {
-                vertex_t* vertex = &vertices[i];
+            auto index_it = indices.find(value);
 
-                if (vertex->value == value) {
-                    return std::optional<u64>{ i };
-                }
-            }
+            if (index_it == indices.end())
+                return std::nullopt;
+
+            return std::optional<u64>{ index_it->second };
+        }
+
+        // Vertex at "index", which is the position it was added at.
+        const vertex_t& at(u64 index) const
+        {
+            return vertices[index];
+        }
 
-            return std::nullopt;
+        u64 size() const
+        {
+            return vertices.size();
         }
 
-        // If there are multiple sets of vertices that are not connected
-        // in any way - like multiple different graphs - this function only finds
-        // cycles within one of these graphs that contains the vertex at "start_index".
-        void find_cycles(u64 start_index)
+        // Finds every cycle in the graph as a strongly connected component, that is a set of
+        // vertices that all depend on each other, using Tarjan's algorithm.
+        // A vertex is only a cycle on its own if it is adjacent to itself.
+        // The result is stored in "cycles", as indices of vertices.
+        void find_cycles()
         {
             m_cycles.clear();
 
-            std::vector<index_resolved_pair> seen;
+            constexpr u64 UNVISITED = static_cast<u64>(-1);
+
+            // Order in which vertices were first visited, and the lowest such order
+            // of any vertex on "component_stack" that can be reached from a vertex.
+            std::vector<u64> visit_order(vertices.size(), UNVISITED);
+            std::vector<u64> lowest_reachable(vertices.size(), 0);
+            std::vector<BOOL> on_component_stack(vertices.size(), FALSE);
+
+            std::vector<u64> component_stack;
+
+            // Replaces the recursion, each entry is a vertex and the next of its adjacencies to look at.
+            struct frame
+            {
+                u64 index;
+                u64 next_adjacency;
+            };
+
+            std::vector<frame> call_stack;
+            u64 next_visit_order = 0;
+
+            for (u64 root_index = 0; root_index < vertices.size(); root_index += 1) {
+                if (visit_order[root_index] != UNVISITED)
+                    continue;
+
+                call_stack.push_back(frame{ root_index, 0 });
+
+                while (!call_stack.empty()) {
+                    frame& current = call_stack.back();
+                    u64 index = current.index;
+
+                    if (current.next_adjacency == 0 && visit_order[index] == UNVISITED) {
+                        visit_order[index] = next_visit_order;
+                        lowest_reachable[index] = next_visit_order;
+                        next_visit_order += 1;
+
+                        component_stack.push_back(index);
+                        on_component_stack[index] = TRUE;
+                    }
+
+                    const std::vector<u64>& adjacency_list = vertices[index].adjacency_list;
+
+                    if (current.next_adjacency < adjacency_list.size()) {
+                        u64 adjacent_index = adjacency_list[current.next_adjacency];
+                        current.next_adjacency += 1;
+
+                        if (visit_order[adjacent_index] == UNVISITED) {
+                            // "current" is invalidated here.
+                            call_stack.push_back(frame{ adjacent_index, 0 });
+                        }
+                        else if (on_component_stack[adjacent_index]) {
+                            lowest_reachable[index] =
+                                std::min(lowest_reachable[index], visit_order[adjacent_index]);
+                        }
+
+                        continue;
+                    }
+
+                    // Every adjacency is done, "index" is the root of a component if it cannot
+                    // reach a vertex that was visited before it.
+                    if (lowest_reachable[index] == visit_order[index]) {
+                        std::vector<u64> component;
+
+                        while (true) {
+                            u64 component_index = component_stack.back();
+                            component_stack.pop_back();
+                            on_component_stack[component_index] = FALSE;
+
+                            component.push_back(component_index);
 
-            // Rough estimate.
-            seen.reserve(16);
+                            if (component_index == index)
+                                break;
+                        }
+
+                        if (component.size() > 1 || points_to(vertices[index], index))
+                            m_cycles.push_back(std::move(component));
+                    }
+
+                    call_stack.pop_back();
 
-            seen.emplace_back(index_resolved_pair{ start_index, false });
-            find_cycles_recurse(&seen[0], &seen);
+                    if (!call_stack.empty()) {
+                        u64 caller_index = call_stack.back().index;
+                        lowest_reachable[caller_index] =
+                            std::min(lowest_reachable[caller_index], lowest_reachable[index]);
+                    }
+                }
+            }
         }
 
         const std::vector<std::vector<u64>>& cycles() const
@@ -181,117 +264,104 @@ namespace masonc
             return m_cycles;
         }
 
-        iterator<vertex_t> begin() override
+        // Returns indices of vertices in groups, where every vertex only depends on vertices
+        // of earlier groups. Vertices of one group do not depend on each other, so they can be
+        // handled at the same time once all earlier groups are done.
+        //
+        // Vertices that are part of a cycle, or that depend on one, are in no group.
+        std::vector<std::vector<u64>> waves() const
         {
-            return iterator<vertex_t>{ vertices.data() };
-        }
+            std::vector<std::vector<u64>> result;
 
-        iterator<vertex_t> end() override
-        {
-            return iterator<vertex_t>{ vertices.data() + vertices.size() };
-        }
+            // Dependencies of each vertex that are not in a group yet.
+            std::vector<u64> remaining(vertices.size());
 
-    private:
-        // Vertices are not stored in any particular order.
-        // New ones are pushed back so that indices remain stable.
-        std::vector<vertex_t> vertices;
+            // Which vertices depend on each vertex, stored as one list with "dependent_offsets"
+            // into it, so that there is no allocation per vertex.
+            std::vector<u64> dependent_offsets(vertices.size() + 1, 0);
 
-        std::vector<std::vector<u64>> m_cycles;
+            for (u64 i = 0; i < vertices.size(); i += 1) {
+                remaining[i] = vertices[i].adjacency_list.size();
 
-        // Returns vertices stored in depth-first post-order, so that simply iterating over them
-        // allows resolving dependencies in the correct order, though only if there are no cycles.
-        std::vector<vertex_t> order()
-        {
-            // TODO: Implementation.
-            return vertices;
-        }
+                for (u64 dependency_index : vertices[i].adjacency_list) {
+                    dependent_offsets[dependency_index + 1] += 1;
+                }
+            }
 
-        void is_dependent_recurse(const vertex_t& vertex, const vertex_t& dependency_vertex,
-            std::vector<vertex_t*>* seen, bool* result)
-        {
-            for (u64 i = 0; i < vertex.adjacency_list.size(); i += 1) {
-                u64 vertex_index = vertex.adjacency_list[i];
-                vertex_t* current_vertex = &vertices[vertex_index];
+            for (u64 i = 0; i < vertices.size(); i += 1) {
+                dependent_offsets[i + 1] += dependent_offsets[i];
+            }
+
+            std::vector<u64> dependents(dependent_offsets.back());
+            std::vector<u64> next_dependent{ dependent_offsets.begin(), dependent_offsets.end() - 1 };
 
-                if (current_vertex->value == dependency_vertex.value) {
-                    *result = true;
-                    return;
+            for (u64 i = 0; i < vertices.size(); i += 1) {
+                for (u64 dependency_index : vertices[i].adjacency_list) {
+                    dependents[next_dependent[dependency_index]] = i;
+                    next_dependent[dependency_index] += 1;
                 }
+            }
+
+            std::vector<u64> wave;
 
-                for (u64 j = 0; j < seen->size(); j += 1) {
-                    vertex_t* seen_vertex = (*seen)[j];
+            for (u64 i = 0; i < vertices.size(); i += 1) {
+                if (remaining[i] == 0)
+                    wave.push_back(i);
+            }
 
-                    if (seen_vertex == current_vertex) {
-                        // The same pointer has been seen more than once,
-                        // ignore it since it's a cycle and we don't want to blow up the stack.
-                        goto CONTINUE;
+            while (!wave.empty()) {
+                std::vector<u64> next_wave;
+
+                for (u64 index : wave) {
+                    for (u64 j = dependent_offsets[index]; j < dependent_offsets[index + 1]; j += 1) {
+                        u64 dependent_index = dependents[j];
+                        remaining[dependent_index] -= 1;
+
+                        if (remaining[dependent_index] == 0)
+                            next_wave.push_back(dependent_index);
                     }
                 }
 
-                seen->push_back(current_vertex);
-                is_dependent_recurse(*current_vertex, dependency_vertex, seen, result);
-
-                CONTINUE:
+                result.push_back(std::move(wave));
+                wave = std::move(next_wave);
             }
+
+            return result;
         }
 
-        struct index_resolved_pair
+        iterator<vertex_t> begin() override
         {
-            u64 index;
-            bool resolved;
-        };
+            return iterator<vertex_t>{ vertices.data() };
+        }
 
-        void find_cycles_recurse(index_resolved_pair* vertex_index_resolved,
-            std::vector<index_resolved_pair>* seen)
+        iterator<vertex_t> end() override
         {
-            u64 vertex_index = vertex_index_resolved->index;
-            vertex_t* vertex = &vertices[vertex_index];
-
-            // Loop over the vertex' adjacent vertices.
-            for (u64 i = 0; i < vertex->adjacency_list.size(); i += 1) {
-                u64 adjacent_vertex_index = vertex->adjacency_list[i];
-                vertex_t* adjacent_vertex = &vertices[adjacent_vertex_index];
-
-                // Loop over the vertices that have been seen before.
-                for (u64 j = 0; j < seen->size(); j += 1) {
-                    u64 seen_vertex_index = (*seen)[j].index;
-                    vertex_t* seen_vertex = &vertices[seen_vertex_index];
-                    bool seen_vertex_resolved = (*seen)[j].resolved;
-
-                    // Do we have a path that has already been taken?
-                    if (seen_vertex == adjacent_vertex) {
-
-                        // Do we have a cycle?
-                        if (!seen_vertex_resolved) {
-                            std::vector<u64> cycle;
-                            cycle.reserve(seen->size() - 1 - j);
-
-                            // We can "backtrack" to find out which vertices are part of
-                            // the cycle.
-                            for (u64 k = j; k < seen->size(); k += 1) {
-                                cycle.push_back((*seen)[k].index);
-                            }
-
-                            // FIXME: Maybe check if this cycle already exists
-                            //        and don't add it in that case?
-                            m_cycles.push_back(cycle);
-                        }
+            return iterator<vertex_t>{ vertices.data() + vertices.size() };
+        }
 
-                        // Do not go the same path again.
-                        goto CONTINUE;
-                    }
-                }
+    private:
+        // Vertices are not stored in any particular order.
+        // New ones are pushed back so that indices remain stable.
+        std::vector<vertex_t> vertices;
 
-                seen->push_back(index_resolved_pair{ adjacent_vertex_index, false });
-                find_cycles_recurse(&seen->back(), seen);
+        // Index in "vertices" of each vertex' value.
+        robin_hood::unordered_map<value_t, u64> indices;
 
-                CONTINUE:
-                ;
-            }
+        std::vector<std::vector<u64>> m_cycles;
 
-            vertex_index_resolved->resolved = true;
+        // Whether "vertex" is adjacent to the vertex at "index".
+        bool points_to(const vertex_t& vertex, u64 index) const
+        {
+            return vertex.adjacency_set.find(index) != vertex.adjacency_set.end();
+        }
+
+        // Makes "vertex" adjacent to the vertex at "index", unless it is already.
+        void add_adjacency_index(vertex_t* vertex, u64 index)
+        {
+            if (vertex->adjacency_set.insert(index).second)
+                vertex->adjacency_list.push_back(index);
         }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,146 @@
+#include <interner.hpp>
+
+#include <cstring>
+#include <mutex>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace masonc
+{
+    string_id string_interner::intern(std::string_view str)
+    {
+        u32 index = shard_index(str);
+        shard& current_shard = shards[index];
+
+        // Most strings are already interned, so try to get away with a shared lock first.
+        {
+            std::shared_lock<std::shared_mutex> shared_lock{ current_shard.mutex };
+
+            auto find_it = current_shard.ids.find(str);
+            if (find_it != current_shard.ids.end())
+                return find_it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> unique_lock{ current_shard.mutex };
+
+        // Another thread might have interned the string in the meantime.
+        auto find_it = current_shard.ids.find(str);
+        if (find_it != current_shard.ids.end())
+            return find_it->second;
+
+        // Only written while the unique lock is held.
+        u32 string_index = current_shard.string_count.load(std::memory_order_relaxed);
+
+        assume(string_index < (std::numeric_limits<string_id>::max() >> SHARD_BITS),
+            "string interner shard is full");
+
+        string_id id = static_cast<string_id>(string_index << SHARD_BITS) | index;
+        std::string_view copied = current_shard.copy(str);
+
+        u32 chunk = chunk_index(string_index);
+        std::unique_ptr<std::string_view[]>& strings = current_shard.string_chunks[chunk];
+
+        if (strings == nullptr)
+            strings.reset(new std::string_view[1ull << (FIRST_CHUNK_BITS + chunk)]);
+
+        strings[chunk_offset(string_index, chunk)] = copied;
+        current_shard.ids.emplace(copied, id);
+
+        // Publishes the string to "at".
+        current_shard.string_count.store(string_index + 1, std::memory_order_release);
+
+        return id;
+    }
+
+    std::optional<string_id> string_interner::find(std::string_view str) const
+    {
+        const shard& current_shard = shards[shard_index(str)];
+        std::shared_lock<std::shared_mutex> shared_lock{ current_shard.mutex };
+
+        auto find_it = current_shard.ids.find(str);
+        if (find_it == current_shard.ids.end())
+            return std::nullopt;
+
+        return find_it->second;
+    }
+
+    std::string_view string_interner::at(string_id id) const
+    {
+        const shard& current_shard = shards[id & (SHARD_COUNT - 1)];
+        u32 string_index = id >> SHARD_BITS;
+
+        assume(string_index < current_shard.string_count.load(std::memory_order_acquire),
+            "string_id is out of range");
+
+        u32 chunk = chunk_index(string_index);
+        return current_shard.string_chunks[chunk][chunk_offset(string_index, chunk)];
+    }
+
+    u64 string_interner::size() const
+    {
+        u64 result = 0;
+
+        for (const shard& current_shard : shards) {
+            result += current_shard.string_count.load(std::memory_order_acquire);
+        }
+
+        return result;
+    }
+
+    std::string_view string_interner::shard::copy(std::string_view str)
+    {
+        // Include space for the null terminator.
+        u64 size = str.length() + 1;
+
+        char* destination;
+
+        if (size > BLOCK_SIZE) {
+            // Give oversized strings a block of their own, keeping the current one.
+            destination = blocks.emplace_back(new char[size]).get();
+        }
+        else {
+            if (size > block_remaining) {
+                block_next = blocks.emplace_back(new char[BLOCK_SIZE]).get();
+                block_remaining = BLOCK_SIZE;
+            }
+
+            destination = block_next;
+            block_next += size;
+            block_remaining -= size;
+        }
+
+        std::memcpy(destination, str.data(), str.length());
+        destination[str.length()] = '\0';
+
+        return std::string_view{ destination, str.length() };
+    }
+
+    u32 string_interner::chunk_index(u32 index)
+    {
+        // Chunk "n" starts at index "(1 << (FIRST_CHUNK_BITS + n)) - (1 << FIRST_CHUNK_BITS)",
+        // so the chunk follows from the highest set bit of the index shifted by the first chunk's size.
+        u32 shifted = index + (1u << FIRST_CHUNK_BITS);
+
+        #if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long highest_bit;
+            _BitScanReverse(&highest_bit, shifted);
+            return static_cast<u32>(highest_bit) - FIRST_CHUNK_BITS;
+        #else
+            return static_cast<u32>(31 - __builtin_clz(shifted)) - FIRST_CHUNK_BITS;
+        #endif
+    }
+
+    u32 string_interner::chunk_offset(u32 index, u32 chunk)
+    {
+        return index + (1u << FIRST_CHUNK_BITS) - (1u << (FIRST_CHUNK_BITS + chunk));
+    }
+
+    u32 string_interner::shard_index(std::string_view str)
+    {
+        // Use the upper bits, the lower ones are what the shard's hash map indexes with.
+        u64 hash = static_cast<u64>(robin_hood::hash<std::string_view>{}(str));
+        return static_cast<u32>(hash >> (64 - SHARD_BITS));
+    }
+}
\ No newline at end of file
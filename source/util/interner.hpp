@@ -0,0 +1,91 @@
+#ifndef MASONC_INTERNER_HPP
+#define MASONC_INTERNER_HPP
+
+#include <common.hpp>
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <shared_mutex>
+
+#include <robin_hood.hpp>
+
+namespace masonc
+{
+    // Stable ID of an interned string. Equal strings always have equal IDs.
+    using string_id = u32;
+
+    // Thread-safe set of strings where each distinct string is stored once and can be referred to
+    // by a "string_id". Interned strings are never freed, views returned by "at" stay valid for
+    // the lifetime of the interner and are null-terminated.
+    //
+    // Strings are spread over shards by their hash so that threads interning different strings
+    // rarely wait on the same lock. Looking up a string by its ID takes no lock at all.
+    struct string_interner
+    {
+        // Returns the ID of "str", copying it into the interner if it has not been seen before.
+        string_id intern(std::string_view str);
+
+        // Returns the ID of "str" or an empty optional if it has not been interned.
+        std::optional<string_id> find(std::string_view str) const;
+
+        // Assumes that "id" was returned by this interner. Does not lock.
+        std::string_view at(string_id id) const;
+
+        // Number of distinct strings.
+        u64 size() const;
+
+    private:
+        static constexpr u32 SHARD_BITS = 5;
+        static constexpr u32 SHARD_COUNT = 1u << SHARD_BITS;
+
+        // Strings are copied into blocks of this size, unless they do not fit into one.
+        static constexpr u64 BLOCK_SIZE = 64 * 1024;
+
+        // The first chunk of a shard's strings holds "1 << FIRST_CHUNK_BITS" of them
+        // and every following chunk twice as many as the one before.
+        static constexpr u32 FIRST_CHUNK_BITS = 8;
+
+        // Enough chunks for every index that fits into a "string_id" next to the shard bits.
+        static constexpr u32 CHUNK_COUNT = 32 - SHARD_BITS - FIRST_CHUNK_BITS + 1;
+
+        struct shard
+        {
+            // Protects everything in this shard except for reading strings that are published
+            // by "string_count".
+            mutable std::shared_mutex mutex;
+
+            robin_hood::unordered_flat_map<std::string_view, string_id> ids;
+
+            // Interned strings by their index, which is the "string_id" without the shard bits.
+            // Chunks are never moved or freed, so a published string can be read without the lock.
+            std::array<std::unique_ptr<std::string_view[]>, CHUNK_COUNT> string_chunks;
+
+            // Strings in "string_chunks", stored with release order once a string is added.
+            std::atomic<u32> string_count{ 0 };
+
+            std::vector<std::unique_ptr<char[]>> blocks;
+            char* block_next = nullptr;
+            u64 block_remaining = 0;
+
+            // Assumes that the unique lock is held.
+            std::string_view copy(std::string_view str);
+        };
+
+        std::array<shard, SHARD_COUNT> shards;
+
+        static u32 shard_index(std::string_view str);
+
+        // Chunk of the string at "index" in a shard, and the position of the string in that chunk.
+        static u32 chunk_index(u32 index);
+        static u32 chunk_offset(u32 index, u32 chunk);
+    };
+
+    inline string_interner global_interner;
+}
+
+#endif
\ No newline at end of file
@@ -5,8 +5,28 @@
 #include <system_error>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <algorithm>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define MASONC_IO_MMAP
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(MASONC_IO_MMAP) && __has_include(<linux/io_uring.h>)
+    #define MASONC_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <cerrno>
+#endif
 
 namespace masonc
 {
@@ -259,4 +279,650 @@ namespace masonc
         std::free(buffer);
         return nullptr;
     }
+
+    mapped_file::~mapped_file()
+    {
+        release();
+    }
+
+    mapped_file::mapped_file(mapped_file&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+
+            mapping = std::exchange(other.mapping, nullptr);
+            mapping_size = std::exchange(other.mapping_size, 0);
+            contents_size = std::exchange(other.contents_size, 0);
+        }
+
+        return *this;
+    }
+
+    const char* mapped_file::data() const
+    {
+        return static_cast<const char*>(mapping);
+    }
+
+    u64 mapped_file::size() const
+    {
+        return contents_size;
+    }
+
+    void mapped_file::release()
+    {
+        if (mapping == nullptr)
+            return;
+
+        #if defined(MASONC_IO_MMAP)
+            munmap(mapping, mapping_size);
+        #else
+            std::free(mapping);
+        #endif
+
+        mapping = nullptr;
+        mapping_size = 0;
+        contents_size = 0;
+    }
+
+    mapped_file mapped_file_adopt(void* mapping, u64 mapping_size, u64 contents_size)
+    {
+        mapped_file result;
+        result.mapping = mapping;
+        result.mapping_size = mapping_size;
+        result.contents_size = contents_size;
+
+        return result;
+    }
+
+    std::optional<mapped_file> file_map(const char* path)
+    {
+    #if defined(MASONC_IO_MMAP)
+        int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+        if (descriptor == -1) {
+            global_logger.log_error(
+                std::string{ "Unable to open file '" + std::string(path) + "'" }
+                .c_str()
+            );
+
+            return std::nullopt;
+        }
+
+        struct stat file_status;
+        if (fstat(descriptor, &file_status) == -1) {
+            global_logger.log_error(
+                std::string{ "Unable to get the size of file '" + std::string(path) + "'" }
+                .c_str()
+            );
+
+            close(descriptor);
+            return std::nullopt;
+        }
+
+        u64 file_size = static_cast<u64>(file_status.st_size);
+        u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+
+        // Reserve at least one byte more than the file needs, rounded up to whole pages.
+        // Anonymous pages and the rest of the file's last page are zero-filled,
+        // which provides the null terminator without copying anything.
+        u64 mapping_size = (file_size / page_size + 1) * page_size;
+
+        void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            global_logger.log_error(
+                std::string{ "Unable to reserve memory for file '" + std::string(path) + "'" }
+                .c_str()
+            );
+
+            close(descriptor);
+            return std::nullopt;
+        }
+
+        // Mapping zero bytes is an error, an empty file is only the null terminator.
+        if (file_size > 0) {
+            int flags = MAP_PRIVATE | MAP_FIXED;
+
+            // The lexer reads every page right away anyway, so fault them all in at once.
+            #if defined(MAP_POPULATE)
+                flags |= MAP_POPULATE;
+            #endif
+
+            // Replaces the start of the reserved pages.
+            if (mmap(mapping, file_size, PROT_READ, flags, descriptor, 0) == MAP_FAILED) {
+                global_logger.log_error(
+                    std::string{ "Unable to map file '" + std::string(path) + "'" }
+                    .c_str()
+                );
+
+                munmap(mapping, mapping_size);
+                close(descriptor);
+                return std::nullopt;
+            }
+
+            #if !defined(MAP_POPULATE)
+                madvise(mapping, file_size, MADV_SEQUENTIAL);
+            #endif
+        }
+
+        // The mapping stays valid after closing the file.
+        close(descriptor);
+
+        return mapped_file_adopt(mapping, mapping_size, file_size);
+    #else
+        u64 file_size;
+        char* contents = file_read(path, 64000, &file_size);
+
+        if (contents == nullptr)
+            return std::nullopt;
+
+        return mapped_file_adopt(contents, file_size + 1, file_size);
+    #endif
+    }
+
+    // Returns 0 up until "count".
+    static std::vector<u64> all_indices(u64 count)
+    {
+        std::vector<u64> result(count);
+
+        for (u64 i = 0; i < count; i += 1) {
+            result[i] = i;
+        }
+
+        return result;
+    }
+
+#if defined(MASONC_IO_URING)
+    // Minimal io_uring submission and completion queue that talks to the kernel
+    // through system calls directly, so that no library is needed.
+    struct io_uring_queue
+    {
+        ~io_uring_queue();
+
+        // Returns false if io_uring or one of the operations in "operations" is unavailable.
+        bool setup(u32 entry_count, std::initializer_list<u8> operations);
+
+        // Returns a zeroed entry to fill in. Assumes that there is room for it,
+        // which is the case as long as no more than "entry_count" requests are in flight.
+        io_uring_sqe* next_entry();
+
+        // Submits all new entries and waits for at least one completion.
+        // Returns false if the kernel refused.
+        bool submit_and_wait();
+
+        // Waits for at least one completion without submitting anything.
+        // Returns false if the kernel refused.
+        bool wait();
+
+        // Calls "handle" with the user data and result of every completion that is ready.
+        template <typename handler>
+        void for_each_completion(handler handle);
+
+        // Calls "handle" with the user data of every entry that the kernel has not taken yet,
+        // which it never sees unless "submit_and_wait" is called again.
+        template <typename handler>
+        void for_each_unsubmitted(handler handle) const;
+
+    private:
+        int ring_descriptor = -1;
+
+        void* submission_ring = MAP_FAILED;
+        u64 submission_ring_size = 0;
+        void* completion_ring = MAP_FAILED;
+        u64 completion_ring_size = 0;
+        io_uring_sqe* entries = static_cast<io_uring_sqe*>(MAP_FAILED);
+        u64 entries_size = 0;
+
+        u32* submission_tail;
+        u32 submission_mask;
+        u32* submission_array;
+
+        u32* completion_head;
+        u32* completion_tail;
+        u32 completion_mask;
+        io_uring_cqe* completions;
+
+        // Tail including entries that were not published to the kernel yet.
+        u32 pending_tail = 0;
+        u32 unsubmitted_count = 0;
+    };
+
+    io_uring_queue::~io_uring_queue()
+    {
+        if (entries != MAP_FAILED)
+            munmap(entries, entries_size);
+
+        if (completion_ring != MAP_FAILED && completion_ring != submission_ring)
+            munmap(completion_ring, completion_ring_size);
+
+        if (submission_ring != MAP_FAILED)
+            munmap(submission_ring, submission_ring_size);
+
+        if (ring_descriptor != -1)
+            close(ring_descriptor);
+    }
+
+    bool io_uring_queue::setup(u32 entry_count, std::initializer_list<u8> operations)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        long result = syscall(__NR_io_uring_setup, entry_count, &params);
+        if (result < 0)
+            return false;
+
+        ring_descriptor = static_cast<int>(result);
+
+        submission_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        completion_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        // Newer kernels map both rings at once.
+        bool single_mapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mapping)
+            submission_ring_size = std::max(submission_ring_size, completion_ring_size);
+
+        submission_ring = mmap(nullptr, submission_ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_SQ_RING);
+
+        if (submission_ring == MAP_FAILED)
+            return false;
+
+        if (single_mapping) {
+            completion_ring = submission_ring;
+        }
+        else {
+            completion_ring = mmap(nullptr, completion_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_CQ_RING);
+
+            if (completion_ring == MAP_FAILED)
+                return false;
+        }
+
+        entries_size = params.sq_entries * sizeof(io_uring_sqe);
+        entries = static_cast<io_uring_sqe*>(mmap(nullptr, entries_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_SQES));
+
+        if (entries == MAP_FAILED)
+            return false;
+
+        char* submission_bytes = static_cast<char*>(submission_ring);
+        submission_tail = reinterpret_cast<u32*>(submission_bytes + params.sq_off.tail);
+        submission_mask = *reinterpret_cast<u32*>(submission_bytes + params.sq_off.ring_mask);
+        submission_array = reinterpret_cast<u32*>(submission_bytes + params.sq_off.array);
+
+        char* completion_bytes = static_cast<char*>(completion_ring);
+        completion_head = reinterpret_cast<u32*>(completion_bytes + params.cq_off.head);
+        completion_tail = reinterpret_cast<u32*>(completion_bytes + params.cq_off.tail);
+        completion_mask = *reinterpret_cast<u32*>(completion_bytes + params.cq_off.ring_mask);
+        completions = reinterpret_cast<io_uring_cqe*>(completion_bytes + params.cq_off.cqes);
+
+        pending_tail = *submission_tail;
+
+        // Older kernels support io_uring, but not every operation.
+        constexpr u32 PROBE_OPERATION_COUNT = 256;
+
+        u64 probe_size = sizeof(io_uring_probe) + PROBE_OPERATION_COUNT * sizeof(io_uring_probe_op);
+        std::unique_ptr<u8[]> probe_buffer{ new u8[probe_size]() };
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probe_buffer.get());
+
+        if (syscall(__NR_io_uring_register, ring_descriptor, IORING_REGISTER_PROBE,
+            probe, PROBE_OPERATION_COUNT) < 0)
+        {
+            return false;
+        }
+
+        for (u8 operation : operations) {
+            if (operation > probe->last_op || (probe->ops[operation].flags & IO_URING_OP_SUPPORTED) == 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    io_uring_sqe* io_uring_queue::next_entry()
+    {
+        u32 index = pending_tail & submission_mask;
+
+        io_uring_sqe* entry = &entries[index];
+        std::memset(entry, 0, sizeof(io_uring_sqe));
+        submission_array[index] = index;
+
+        pending_tail += 1;
+        unsubmitted_count += 1;
+
+        return entry;
+    }
+
+    bool io_uring_queue::submit_and_wait()
+    {
+        // Publish the new entries to the kernel.
+        __atomic_store_n(submission_tail, pending_tail, __ATOMIC_RELEASE);
+
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, ring_descriptor, unsubmitted_count, 1,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+
+            if (result >= 0) {
+                unsubmitted_count -= static_cast<u32>(result);
+                return true;
+            }
+
+            // Nothing was submitted if a signal interrupted the call.
+            if (errno != EINTR)
+                return false;
+        }
+    }
+
+    bool io_uring_queue::wait()
+    {
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, ring_descriptor, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+            if (result >= 0)
+                return true;
+
+            if (errno != EINTR)
+                return false;
+        }
+    }
+
+    template <typename handler>
+    void io_uring_queue::for_each_unsubmitted(handler handle) const
+    {
+        for (u32 tail = pending_tail - unsubmitted_count; tail != pending_tail; tail += 1) {
+            handle(entries[submission_array[tail & submission_mask]].user_data);
+        }
+    }
+
+    template <typename handler>
+    void io_uring_queue::for_each_completion(handler handle)
+    {
+        u32 head = *completion_head;
+        u32 tail = __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE);
+
+        while (head != tail) {
+            const io_uring_cqe& completion = completions[head & completion_mask];
+            u64 user_data = completion.user_data;
+            s32 result = completion.res;
+
+            // Hand the slot back to the kernel before "handle" might submit more.
+            head += 1;
+            __atomic_store_n(completion_head, head, __ATOMIC_RELEASE);
+
+            handle(user_data, result);
+        }
+    }
+
+    // Loads the files through io_uring, opening, measuring and reading them one step at a time.
+    // Returns the indices of all paths that were not passed to "on_loaded",
+    // which is all of them if io_uring is unavailable.
+    static std::vector<u64> files_load_io_uring(const std::vector<std::string>& paths,
+        const std::function<void(u64, std::optional<mapped_file>)>& on_loaded)
+    {
+        // Files in flight at once, each with one request at a time.
+        constexpr u32 SLOT_COUNT = 64;
+
+        std::vector<u64> not_loaded;
+
+        io_uring_queue queue;
+        if (!queue.setup(SLOT_COUNT, { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ }))
+            return all_indices(paths.size());
+
+        enum class load_step : u8
+        {
+            OPEN,
+            STATUS,
+            READ
+        };
+
+        struct load_slot
+        {
+            u64 path_index;
+            load_step step;
+            int descriptor;
+            struct statx status;
+            char* mapping;
+            u64 mapping_size;
+            u64 size;
+            u64 bytes_read;
+        };
+
+        // Not a local array, because it has to be left to the kernel if requests cannot be waited for.
+        std::unique_ptr<load_slot[]> slots = std::make_unique<load_slot[]>(SLOT_COUNT);
+        std::vector<u32> free_slots;
+
+        for (u32 i = 0; i < SLOT_COUNT; i += 1) {
+            free_slots.push_back(SLOT_COUNT - 1 - i);
+        }
+
+        const u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+
+        auto queue_read = [&](u32 slot_index) {
+            load_slot& slot = slots[slot_index];
+            slot.step = load_step::READ;
+
+            io_uring_sqe* entry = queue.next_entry();
+            entry->opcode = IORING_OP_READ;
+            entry->fd = slot.descriptor;
+            entry->addr = reinterpret_cast<u64>(slot.mapping + slot.bytes_read);
+            entry->len = static_cast<u32>(std::min<u64>(slot.size - slot.bytes_read, 1u << 30));
+            entry->off = slot.bytes_read;
+            entry->user_data = slot_index;
+        };
+
+        auto finish = [&](u32 slot_index, bool success) {
+            load_slot& slot = slots[slot_index];
+
+            if (slot.step != load_step::OPEN)
+                close(slot.descriptor);
+
+            if (success) {
+                mprotect(slot.mapping, slot.mapping_size, PROT_READ);
+                on_loaded(slot.path_index, mapped_file_adopt(slot.mapping, slot.mapping_size, slot.size));
+            }
+            else {
+                if (slot.mapping != nullptr)
+                    munmap(slot.mapping, slot.mapping_size);
+
+                global_logger.log_error(
+                    std::string{ "Unable to load file '" + paths[slot.path_index] + "'" }
+                    .c_str()
+                );
+
+                on_loaded(slot.path_index, std::nullopt);
+            }
+
+            free_slots.push_back(slot_index);
+        };
+
+        auto handle_completion = [&](u64 user_data, s32 result) {
+            u32 slot_index = static_cast<u32>(user_data);
+            load_slot& slot = slots[slot_index];
+
+            if (result < 0) {
+                finish(slot_index, false);
+                return;
+            }
+
+            switch (slot.step) {
+                case load_step::OPEN: {
+                    slot.step = load_step::STATUS;
+                    slot.descriptor = result;
+
+                    io_uring_sqe* entry = queue.next_entry();
+                    entry->opcode = IORING_OP_STATX;
+                    entry->fd = slot.descriptor;
+                    entry->addr = reinterpret_cast<u64>("");
+                    entry->len = STATX_SIZE;
+                    entry->off = reinterpret_cast<u64>(&slot.status);
+                    entry->statx_flags = AT_EMPTY_PATH;
+                    entry->user_data = slot_index;
+                    break;
+                }
+                case load_step::STATUS: {
+                    slot.size = slot.status.stx_size;
+                    slot.bytes_read = 0;
+
+                    // Same layout as "file_map", the zero-filled rest is the null terminator.
+                    slot.mapping_size = (slot.size / page_size + 1) * page_size;
+
+                    void* mapping = mmap(nullptr, slot.mapping_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+                    if (mapping == MAP_FAILED) {
+                        finish(slot_index, false);
+                        return;
+                    }
+
+                    slot.mapping = static_cast<char*>(mapping);
+
+                    if (slot.size == 0)
+                        finish(slot_index, true);
+                    else
+                        queue_read(slot_index);
+
+                    break;
+                }
+                case load_step::READ: {
+                    slot.bytes_read += static_cast<u64>(result);
+
+                    // The file shrank while it was being read.
+                    if (result == 0) {
+                        finish(slot_index, false);
+                        return;
+                    }
+
+                    if (slot.bytes_read < slot.size)
+                        queue_read(slot_index);
+                    else
+                        finish(slot_index, true);
+
+                    break;
+                }
+            }
+        };
+
+        // Frees a slot whose file is loaded again without io_uring, after its request
+        // completed with "result" or was never submitted.
+        auto abandon = [&](u64 user_data, s32 result) {
+            u32 slot_index = static_cast<u32>(user_data);
+            load_slot& slot = slots[slot_index];
+
+            if (slot.step != load_step::OPEN) {
+                close(slot.descriptor);
+            }
+            else if (result >= 0) {
+                // The file was opened after all.
+                close(result);
+            }
+
+            if (slot.mapping != nullptr)
+                munmap(slot.mapping, slot.mapping_size);
+
+            not_loaded.push_back(slot.path_index);
+            free_slots.push_back(slot_index);
+        };
+
+        u64 next_path = 0;
+
+        while (next_path < paths.size() || free_slots.size() < SLOT_COUNT) {
+            while (next_path < paths.size() && !free_slots.empty()) {
+                u32 slot_index = free_slots.back();
+                free_slots.pop_back();
+
+                load_slot& slot = slots[slot_index];
+                slot.path_index = next_path;
+                slot.step = load_step::OPEN;
+                slot.mapping = nullptr;
+
+                io_uring_sqe* entry = queue.next_entry();
+                entry->opcode = IORING_OP_OPENAT;
+                entry->fd = AT_FDCWD;
+                entry->addr = reinterpret_cast<u64>(paths[next_path].c_str());
+                entry->open_flags = O_RDONLY | O_CLOEXEC;
+                entry->user_data = slot_index;
+
+                next_path += 1;
+            }
+
+            if (!queue.submit_and_wait()) {
+                global_logger.log_error("io_uring refused to load files");
+
+                queue.for_each_unsubmitted([&](u64 user_data) { abandon(user_data, -1); });
+
+                // Requests in flight write into their slots and mappings until they complete,
+                // so wait for all of them before anything is freed.
+                while (free_slots.size() < SLOT_COUNT) {
+                    if (!queue.wait()) {
+                        // There is no telling when the kernel is done with the remaining slots,
+                        // so they and their descriptors and mappings are left to it.
+                        for (u32 i = 0; i < SLOT_COUNT; i += 1) {
+                            if (std::find(free_slots.begin(), free_slots.end(), i) == free_slots.end())
+                                not_loaded.push_back(slots[i].path_index);
+                        }
+
+                        static_cast<void>(slots.release());
+                        break;
+                    }
+
+                    queue.for_each_completion(abandon);
+                }
+
+                for (; next_path < paths.size(); next_path += 1) {
+                    not_loaded.push_back(next_path);
+                }
+
+                return not_loaded;
+            }
+
+            queue.for_each_completion(handle_completion);
+        }
+
+        return not_loaded;
+    }
+#endif
+
+    void files_load(const std::vector<std::string>& paths,
+        const std::function<void(u64, std::optional<mapped_file>)>& on_loaded, bool allow_io_uring)
+    {
+    #if defined(MASONC_IO_URING)
+        std::vector<u64> not_loaded = allow_io_uring ?
+            files_load_io_uring(paths, on_loaded) : all_indices(paths.size());
+    #else
+        (void)allow_io_uring;
+        std::vector<u64> not_loaded = all_indices(paths.size());
+    #endif
+
+        if (not_loaded.empty())
+            return;
+
+        // Mapping a file blocks until it is read, so spread the files over a pool of threads.
+        u64 thread_count = std::min<u64>(std::max<u64>(std::thread::hardware_concurrency(), 1),
+            not_loaded.size());
+
+        std::atomic<u64> next{ 0 };
+
+        auto load = [&]() {
+            for (u64 i = next.fetch_add(1); i < not_loaded.size(); i = next.fetch_add(1)) {
+                u64 path_index = not_loaded[i];
+                on_loaded(path_index, file_map(paths[path_index].c_str()));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+
+        for (u64 i = 1; i < thread_count; i += 1) {
+            threads.emplace_back(load);
+        }
+
+        load();
+
+        for (u64 i = 0; i < threads.size(); i += 1) {
+            threads[i].join();
+        }
+    }
 }
\ No newline at end of file
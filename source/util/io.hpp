@@ -5,6 +5,8 @@
 
 #include <vector>
 #include <string>
+#include <optional>
+#include <functional>
 
 namespace masonc
 {
@@ -62,6 +64,53 @@ namespace masonc
     // Returns "nullptr" if something went wrong.
 	char* file_read(const char* path, const u64 block_size = 64000,
         u64* terminator_index = nullptr);
+
+    // Read-only contents of a file that are mapped into memory instead of being copied,
+    // followed by a null terminator. The file is unmapped once the "mapped_file" is destroyed.
+    //
+    // The file must not be truncated while it is mapped.
+    // On platforms without "mmap" the contents are read into a buffer instead.
+    struct mapped_file
+    {
+        mapped_file() = default;
+        ~mapped_file();
+
+        mapped_file(mapped_file&& other) noexcept;
+        mapped_file& operator=(mapped_file&& other) noexcept;
+
+        mapped_file(const mapped_file& other) = delete;
+        mapped_file& operator=(const mapped_file& other) = delete;
+
+        // Null-terminated, stays at the same address when the "mapped_file" is moved.
+        const char* data() const;
+
+        // Number of characters, not counting the null terminator.
+        u64 size() const;
+
+    private:
+        void* mapping = nullptr;
+        u64 mapping_size = 0;
+        u64 contents_size = 0;
+
+        void release();
+
+        // Takes ownership of memory that "file_map" or "files_load" filled with the contents.
+        friend mapped_file mapped_file_adopt(void* mapping, u64 mapping_size, u64 contents_size);
+    };
+
+    // Map a file into memory. Returns an empty optional if something went wrong.
+    std::optional<mapped_file> file_map(const char* path);
+
+    // Load many files at once and call "on_loaded" with the index of the path and the contents
+    // as soon as a file is loaded, or with an empty optional if something went wrong.
+    // Returns once "on_loaded" was called for every path.
+    //
+    // On Linux the files are opened, measured and read in batches through io_uring
+    // into anonymous memory, which avoids a system call per file and step.
+    // Otherwise, or if io_uring is unavailable, the files are mapped by a pool of threads,
+    // in which case "on_loaded" is called from several threads at once.
+    void files_load(const std::vector<std::string>& paths,
+        const std::function<void(u64, std::optional<mapped_file>)>& on_loaded, bool allow_io_uring = true);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include <scheduler.hpp>
+
+#include <array>
+#include <chrono>
+#include <algorithm>
+
+namespace masonc
+{
+    // Lock-free work-stealing deque after "Correct and Efficient Work-Stealing for Weak Memory Models"
+    // (Lê et al., 2013), with sequentially consistent accesses to the indices instead of fences.
+    // Only the owner calls "push" and "take", any thread may call "steal".
+    struct job_deque
+    {
+        job_deque()
+        {
+            buffers.emplace_back(new buffer{ INITIAL_CAPACITY });
+            current.store(buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        void push(void* item)
+        {
+            s64 b = bottom.load(std::memory_order_relaxed);
+            s64 t = top.load(std::memory_order_acquire);
+            buffer* items = current.load(std::memory_order_relaxed);
+
+            if (b - t > items->capacity - 1) {
+                items = grow(items, t, b);
+                current.store(items, std::memory_order_release);
+            }
+
+            items->store(b, item);
+            bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // Returns "nullptr" if the deque is empty.
+        void* take()
+        {
+            s64 b = bottom.load(std::memory_order_relaxed) - 1;
+            buffer* items = current.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_seq_cst);
+            s64 t = top.load(std::memory_order_seq_cst);
+
+            if (t > b) {
+                // Empty.
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            void* item = items->load(b);
+
+            if (t == b) {
+                // Last item, race thieves for it.
+                if (!top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    item = nullptr;
+                }
+
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            return item;
+        }
+
+        // Returns "nullptr" if the deque is empty.
+        void* steal()
+        {
+            while (true) {
+                s64 t = top.load(std::memory_order_seq_cst);
+                s64 b = bottom.load(std::memory_order_seq_cst);
+
+                if (t >= b)
+                    return nullptr;
+
+                buffer* items = current.load(std::memory_order_acquire);
+                void* item = items->load(t);
+
+                if (top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return item;
+                }
+
+                // Another thread was faster, try the next item.
+            }
+        }
+
+    private:
+        static constexpr s64 INITIAL_CAPACITY = 64;
+
+        struct buffer
+        {
+            explicit buffer(s64 capacity)
+                : capacity{ capacity }, items{ new std::atomic<void*>[capacity] } {}
+
+            s64 capacity;
+            std::unique_ptr<std::atomic<void*>[]> items;
+
+            // The capacity is a power of 2, so indices wrap around with a mask.
+            void* load(s64 index) const
+            {
+                return items[index & (capacity - 1)].load(std::memory_order_acquire);
+            }
+
+            void store(s64 index, void* item)
+            {
+                items[index & (capacity - 1)].store(item, std::memory_order_release);
+            }
+        };
+
+        buffer* grow(buffer* items, s64 t, s64 b)
+        {
+            buffers.emplace_back(new buffer{ items->capacity * 2 });
+            buffer* grown = buffers.back().get();
+
+            for (s64 i = t; i < b; i += 1) {
+                grown->store(i, items->load(i));
+            }
+
+            return grown;
+        }
+
+        alignas(64) std::atomic<s64> top{ 0 };
+        alignas(64) std::atomic<s64> bottom{ 0 };
+        std::atomic<buffer*> current;
+
+        // Thieves might still read from old buffers, so they are kept until the deque is destroyed.
+        std::vector<std::unique_ptr<buffer>> buffers;
+    };
+
+    struct work_stealing_scheduler::worker
+    {
+        job_deque jobs;
+    };
+
+    // Lets "submit" know whether it is called from inside a job, and by which worker.
+    static thread_local work_stealing_scheduler* current_scheduler = nullptr;
+    static thread_local u64 current_worker_index = 0;
+
+    static f64 seconds_between(std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<f64>(end - start).count();
+    }
+
+    bool work_stealing_scheduler::job_priority_less::operator()(const job* a, const job* b) const
+    {
+        return a->priority < b->priority;
+    }
+
+    work_stealing_scheduler::work_stealing_scheduler(u64 worker_count)
+    {
+        worker_count = std::max<u64>(worker_count, 1);
+
+        workers.reserve(worker_count);
+        worker_stats_list.resize(worker_count);
+
+        for (u64 i = 0; i < worker_count; i += 1) {
+            workers.emplace_back(new worker{});
+        }
+
+        threads.reserve(worker_count);
+
+        for (u64 i = 0; i < worker_count; i += 1) {
+            threads.emplace_back(&work_stealing_scheduler::run_worker, this, i);
+        }
+    }
+
+    work_stealing_scheduler::~work_stealing_scheduler()
+    {
+        finish();
+    }
+
+    void work_stealing_scheduler::submit(job_function job_to_run, u64 priority)
+    {
+        job* submitted = new job{ std::move(job_to_run), priority };
+        pending_job_count.fetch_add(1);
+
+        if (current_scheduler == this) {
+            workers[current_worker_index]->jobs.push(submitted);
+        }
+        else {
+            std::lock_guard<std::mutex> injected_lock{ injected_mutex };
+            injected_jobs.push(submitted);
+        }
+
+        notify_work();
+    }
+
+    void work_stealing_scheduler::finish()
+    {
+        if (threads.empty())
+            return;
+
+        {
+            std::unique_lock<std::mutex> sleep_lock{ sleep_mutex };
+            finished_condition.wait(sleep_lock, [&]() { return pending_job_count.load() == 0; });
+
+            stopping = true;
+        }
+
+        work_condition.notify_all();
+
+        for (u64 i = 0; i < threads.size(); i += 1) {
+            threads[i].join();
+        }
+
+        threads.clear();
+    }
+
+    u64 work_stealing_scheduler::worker_count() const
+    {
+        return workers.size();
+    }
+
+    const std::vector<worker_stats>& work_stealing_scheduler::stats() const
+    {
+        return worker_stats_list;
+    }
+
+    void work_stealing_scheduler::print_stats() const
+    {
+        for (u64 i = 0; i < worker_stats_list.size(); i += 1) {
+            const worker_stats& current = worker_stats_list[i];
+
+            std::cout << "Worker " << i << ": " << current.jobs_run << " jobs ("
+                      << current.jobs_stolen << " stolen), busy " << current.busy_seconds * 1000.0
+                      << " ms, idle " << current.idle_seconds * 1000.0 << " ms" << std::endl;
+        }
+    }
+
+    void work_stealing_scheduler::run_worker(u64 worker_index)
+    {
+        current_scheduler = this;
+        current_worker_index = worker_index;
+
+        worker_stats& stats = worker_stats_list[worker_index];
+        auto idle_start = std::chrono::steady_clock::now();
+
+        while (true) {
+            // Read before looking so that a job submitted in the meantime is never slept through.
+            u64 epoch = work_epoch.load();
+
+            job* next = find_job(worker_index);
+            if (next != nullptr) {
+                auto busy_start = std::chrono::steady_clock::now();
+                stats.idle_seconds += seconds_between(idle_start, busy_start);
+
+                next->run(worker_index);
+                delete next;
+
+                idle_start = std::chrono::steady_clock::now();
+                stats.busy_seconds += seconds_between(busy_start, idle_start);
+                stats.jobs_run += 1;
+
+                if (pending_job_count.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> sleep_lock{ sleep_mutex };
+                    finished_condition.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock<std::mutex> sleep_lock{ sleep_mutex };
+            sleeping_count.fetch_add(1);
+
+            work_condition.wait(sleep_lock, [&]() { return work_epoch.load() != epoch || stopping; });
+
+            sleeping_count.fetch_sub(1);
+
+            // Only set once every job has run.
+            if (stopping)
+                break;
+        }
+
+        stats.idle_seconds += seconds_between(idle_start, std::chrono::steady_clock::now());
+        current_scheduler = nullptr;
+    }
+
+    work_stealing_scheduler::job* work_stealing_scheduler::find_job(u64 worker_index)
+    {
+        job* next = static_cast<job*>(workers[worker_index]->jobs.take());
+        if (next != nullptr)
+            return next;
+
+        next = take_injected(worker_index);
+        if (next != nullptr)
+            return next;
+
+        // Start at the next worker, so that not every thief tries the same victim first.
+        for (u64 i = 1; i < workers.size(); i += 1) {
+            u64 victim = (worker_index + i) % workers.size();
+
+            next = static_cast<job*>(workers[victim]->jobs.steal());
+            if (next != nullptr) {
+                worker_stats_list[worker_index].jobs_stolen += 1;
+                return next;
+            }
+        }
+
+        return nullptr;
+    }
+
+    work_stealing_scheduler::job* work_stealing_scheduler::take_injected(u64 worker_index)
+    {
+        // Enough to spare most trips to the shared queue, few enough to leave work for the others.
+        constexpr u64 MAX_BATCH_SIZE = 32;
+
+        std::unique_lock<std::mutex> injected_lock{ injected_mutex };
+
+        if (injected_jobs.empty())
+            return nullptr;
+
+        job* next = injected_jobs.top();
+        injected_jobs.pop();
+
+        u64 batch_size = std::min<u64>(injected_jobs.size() / workers.size(), MAX_BATCH_SIZE);
+
+        std::array<job*, MAX_BATCH_SIZE> batch;
+
+        for (u64 i = 0; i < batch_size; i += 1) {
+            batch[i] = injected_jobs.top();
+            injected_jobs.pop();
+        }
+
+        injected_lock.unlock();
+
+        // Pushed from lowest to highest priority. The owner takes from the bottom, so it keeps going
+        // with the highest priority jobs, while thieves take the lower priority ones from the top.
+        for (u64 i = batch_size; i > 0; i -= 1) {
+            workers[worker_index]->jobs.push(batch[i - 1]);
+        }
+
+        if (batch_size > 0)
+            notify_work();
+
+        return next;
+    }
+
+    void work_stealing_scheduler::notify_work()
+    {
+        work_epoch.fetch_add(1);
+
+        // A worker about to sleep either sees the new epoch or is counted here.
+        if (sleeping_count.load() > 0) {
+            std::lock_guard<std::mutex> sleep_lock{ sleep_mutex };
+            work_condition.notify_one();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef MASONC_SCHEDULER_HPP
+#define MASONC_SCHEDULER_HPP
+
+#include <common.hpp>
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace masonc
+{
+    // What a worker thread of a "work_stealing_scheduler" spent its time on.
+    struct worker_stats
+    {
+        u64 jobs_run = 0;
+
+        // Jobs taken from another worker's deque.
+        u64 jobs_stolen = 0;
+
+        // Time spent running jobs.
+        f64 busy_seconds = 0.0;
+
+        // Time spent looking for jobs and waiting for them.
+        f64 idle_seconds = 0.0;
+    };
+
+    // Runs jobs on a fixed number of worker threads.
+    //
+    // Every worker has a deque of its own that only it pushes to and takes from at the bottom,
+    // while idle workers steal from the top (Chase-Lev). Jobs submitted from outside go
+    // to a shared queue ordered by priority. A worker takes a batch from it at once
+    // and puts all but one into its deque, from where idle workers steal them.
+    struct work_stealing_scheduler
+    {
+        // Receives the index of the worker that runs the job.
+        using job_function = std::function<void(u64 worker_index)>;
+
+        // Starts "worker_count" threads, at least one.
+        explicit work_stealing_scheduler(u64 worker_count);
+
+        // Calls "finish" if it has not been called yet.
+        ~work_stealing_scheduler();
+
+        work_stealing_scheduler(const work_stealing_scheduler& other) = delete;
+        work_stealing_scheduler& operator=(const work_stealing_scheduler& other) = delete;
+
+        // Can be called from any thread, including from inside jobs, until "finish" is called.
+        // Jobs submitted from outside with a higher "priority" are started first.
+        // Jobs submitted from inside a job go to the worker's own deque and ignore "priority".
+        void submit(job_function job, u64 priority = 0);
+
+        // Waits until all submitted jobs, and the jobs they submit, have run and stops the workers.
+        // Must not be called from inside a job.
+        void finish();
+
+        u64 worker_count() const;
+
+        // Complete once "finish" returned.
+        const std::vector<worker_stats>& stats() const;
+
+        // Prints the busy and idle time of every worker.
+        void print_stats() const;
+
+    private:
+        struct job
+        {
+            job_function run;
+            u64 priority;
+        };
+
+        struct job_priority_less
+        {
+            bool operator()(const job* a, const job* b) const;
+        };
+
+        struct worker;
+
+        std::vector<std::unique_ptr<worker>> workers;
+        std::vector<std::thread> threads;
+        std::vector<worker_stats> worker_stats_list;
+
+        // Jobs submitted from outside, highest priority on top.
+        std::mutex injected_mutex;
+        std::priority_queue<job*, std::vector<job*>, job_priority_less> injected_jobs;
+
+        // Submitted jobs that did not finish running yet.
+        std::atomic<u64> pending_job_count{ 0 };
+
+        // Increased whenever a job becomes available, so a worker can tell
+        // whether it missed one between looking for jobs and going to sleep.
+        std::atomic<u64> work_epoch{ 0 };
+        std::atomic<u64> sleeping_count{ 0 };
+
+        // Protects "stopping" and is used with both conditions.
+        std::mutex sleep_mutex;
+        std::condition_variable work_condition;
+        std::condition_variable finished_condition;
+        bool stopping = false;
+
+        void run_worker(u64 worker_index);
+
+        // Returns "nullptr" if no job could be found anywhere.
+        job* find_job(u64 worker_index);
+        job* take_injected(u64 worker_index);
+
+        // Wakes a sleeping worker, if any.
+        void notify_work();
+    };
+}
+
+#endif
\ No newline at end of file